@@ -0,0 +1,268 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "echo.h"
+#include "chan_mem.h"
+#include "chan_rec.h"
+
+#define EOL "\n"
+
+#define Log(fmt, ...) \
+    fprintf(stdout, fmt EOL, ##__VA_ARGS__)
+
+typedef struct _BenchCase {
+    const char *name;
+
+    /* Response generator. */
+    size_t hdrNum;
+    size_t bodyLen;
+
+    /* Channel behavior. */
+    EcoChanMemFrag frag;
+    size_t fragLen;
+    bool keepAlive;
+
+    /* Extra client configuration, can be `NULL`. */
+    void (*cfgHook)(EcoHttpCli *cli);
+} BenchCase;
+
+static void ReuseRsp(EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ReuseRsp, (EcoArg)true);
+}
+
+static int DiscardBody(int off, const void *buf, int len, EcoArg arg) {
+    (void)off;
+    (void)buf;
+    (void)arg;
+
+    return len;
+}
+
+static void StreamBody(EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyWriteHook, DiscardBody);
+}
+
+static void AllowFewHdrs(EcoHttpCli *cli) {
+    EcoHdrTab *tab = EcoHdrTab_New();
+
+    EcoHdrTab_Add(tab, "Content-Length", "");
+    EcoHdrTab_Add(tab, "X-Bench-Header-1", "");
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrFilterTab, tab);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrFilter, (EcoArg)EcoHdrFilter_Allow);
+}
+
+static void ParseLeniently(EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_LenientParse, (EcoArg)true);
+}
+
+static const BenchCase gCaseAry[] = {
+    { "small",              4,          64, EcoChanMemFrag_None,     0, true,  NULL },
+    { "small-close",        4,          64, EcoChanMemFrag_None,     0, false, NULL },
+    { "small-reuse",        4,          64, EcoChanMemFrag_None,     0, true,  ReuseRsp },
+    { "small-lenient",      4,          64, EcoChanMemFrag_None,     0, true,  ParseLeniently },
+    { "small-1-byte",       4,          64, EcoChanMemFrag_Fixed,    1, true,  NULL },
+    { "small-mtu",          4,          64, EcoChanMemFrag_Fixed, 1460, true,  NULL },
+    { "small-random",       4,          64, EcoChanMemFrag_Random, 512, true,  NULL },
+    { "many-headers",      32,          64, EcoChanMemFrag_None,     0, true,  NULL },
+    { "many-lenient",      32,          64, EcoChanMemFrag_None,     0, true,  ParseLeniently },
+    { "many-hdrs-allow",   32,          64, EcoChanMemFrag_None,     0, true,  AllowFewHdrs },
+    { "body-64k",           4,   64 * 1024, EcoChanMemFrag_None,     0, true,  NULL },
+    { "body-64k-reuse",     4,   64 * 1024, EcoChanMemFrag_None,     0, true,  ReuseRsp },
+    { "body-1m-mtu",        4, 1024 * 1024, EcoChanMemFrag_Fixed, 1460, true,  NULL },
+    { "body-1m-stream",     4, 1024 * 1024, EcoChanMemFrag_None,     0, true,  StreamBody },
+};
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Generate a response message with the given number of headers and body length.
+ */
+static char *GenRspMsg(size_t hdrNum, size_t bodyLen, size_t *msgLen) {
+    size_t cap = 256 + hdrNum * 64 + bodyLen;
+    size_t len = 0;
+    char *msg;
+
+    msg = (char *)malloc(cap);
+    if (msg == NULL) {
+        return NULL;
+    }
+
+    len += (size_t)snprintf(msg + len, cap - len, "HTTP/1.1 200 OK\r\n"
+                                                  "Content-Length: %zu\r\n", bodyLen);
+
+    for (size_t i = 1; i < hdrNum; i++) {
+        len += (size_t)snprintf(msg + len, cap - len, "X-Bench-Header-%zu: value-%zu\r\n", i, i);
+    }
+
+    len += (size_t)snprintf(msg + len, cap - len, "\r\n");
+
+    memset(msg + len, 'x', bodyLen);
+    len += bodyLen;
+
+    *msgLen = len;
+
+    return msg;
+}
+
+static int RunCase(const BenchCase *bc, size_t iterNum) {
+    uint64_t begTime;
+    uint64_t endTime;
+    EcoChanMem mem;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    size_t msgLen;
+    double nsPerOp;
+    char *msg;
+    EcoRes res;
+
+    msg = GenRspMsg(bc->hdrNum, bc->bodyLen, &msgLen);
+    if (msg == NULL) {
+        return -1;
+    }
+
+    EcoChanMem_Init(&mem);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_RspBuf, msg);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_RspLen, (EcoArg)msgLen);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)bc->frag);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)bc->fragLen);
+
+    cli = EcoHttpCli_New();
+    req = EcoHttpReq_New();
+    if (cli == NULL || req == NULL) {
+        return -1;
+    }
+
+    EcoChanMem_Apply(&mem, cli);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)bc->keepAlive);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://127.0.0.1:8080/bench?id=1");
+
+    if (bc->cfgHook != NULL) {
+        bc->cfgHook(cli);
+    }
+
+    begTime = NowNs();
+
+    for (size_t i = 0; i < iterNum; i++) {
+        res = EcoHttpCli_Issue(cli);
+        if (res != EcoRes_Ok) {
+            Log("%-16s failed: %s", bc->name, EcoRes_ToStr(res));
+
+            return -1;
+        }
+    }
+
+    endTime = NowNs();
+
+    nsPerOp = (double)(endTime - begTime) / (double)iterNum;
+
+    Log("%-16s %12.0f ns/op %10.1f MB/s %10.1f reads/op %8zu rcv buf",
+        bc->name, nsPerOp,
+        (double)msgLen * 1000.0 / nsPerOp,
+        (double)mem.readNum / (double)iterNum,
+        cli->stats.rcvBufCap);
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+    free(msg);
+
+    return 0;
+}
+
+/**
+ * @brief Replay a recorded capture as fast as possible.
+ */
+static int RunCapture(const char *path, size_t iterNum) {
+    uint64_t begTime;
+    uint64_t endTime;
+    EcoChanReplay rep;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    size_t rspLen = 0;
+    double nsPerOp;
+    EcoRes res;
+
+    EcoChanReplay_Init(&rep);
+
+    res = EcoChanReplay_SetOpt(&rep, EcoChanReplayOpt_Path, (EcoArg)path);
+    if (res != EcoRes_Ok) {
+        Log("%s: %s", path, EcoRes_ToStr(res));
+
+        return -1;
+    }
+
+    cli = EcoHttpCli_New();
+    req = EcoHttpReq_New();
+    if (cli == NULL || req == NULL) {
+        return -1;
+    }
+
+    EcoChanReplay_Apply(&rep, cli);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://127.0.0.1:8080/bench?id=1");
+
+    begTime = NowNs();
+
+    for (size_t i = 0; i < iterNum; i++) {
+        res = EcoHttpCli_Issue(cli);
+        if (res != EcoRes_Ok) {
+            Log("%-16s failed: %s", "capture", EcoRes_ToStr(res));
+
+            return -1;
+        }
+
+        rspLen += cli->rsp->bodyLen;
+    }
+
+    endTime = NowNs();
+
+    nsPerOp = (double)(endTime - begTime) / (double)iterNum;
+
+    Log("%-16s %12.0f ns/op %10.1f MB/s %10.1f reads/op %8zu rcv buf",
+        "capture", nsPerOp,
+        (double)rspLen / (double)iterNum * 1000.0 / nsPerOp,
+        (double)rep.readNum / (double)iterNum,
+        cli->stats.rcvBufCap);
+
+    EcoHttpCli_Del(cli);
+    EcoChanReplay_Deinit(&rep);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    size_t iterNum = 10000;
+
+    if (argc > 1) {
+        iterNum = (size_t)strtoul(argv[1], NULL, 10);
+    }
+
+    /* Replay a capture instead of the generated cases. */
+    if (argc > 2) {
+        Log("Issuing %zu requests over capture %s...", iterNum, argv[2]);
+
+        return RunCapture(argv[2], iterNum) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    Log("Issuing %zu requests per case over memory channel...", iterNum);
+
+    for (size_t i = 0; i < sizeof(gCaseAry) / sizeof(gCaseAry[0]); i++) {
+        if (RunCase(gCaseAry + i, iterNum) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
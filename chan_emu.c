@@ -0,0 +1,430 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "echo.h"
+#include "chan_emu.h"
+
+#define NS_PER_MS   1000000ULL
+#define NS_PER_SEC  1000000000ULL
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Get the deadline of an operation in nanoseconds.
+ * 
+ * @param timeout Timeout in milliseconds, 0 means no timeout.
+ * 
+ * @return The deadline, 0 means no deadline.
+ */
+static uint64_t GetDdl(uint32_t timeout) {
+    if (timeout == 0) {
+        return 0;
+    }
+
+    return NowNs() + (uint64_t)timeout * NS_PER_MS;
+}
+
+/**
+ * @brief Sleep until the given time of monotonic clock, but not
+ *        beyond the deadline.
+ * 
+ * @param time Time to wake up.
+ * @param ddl Deadline, 0 means no deadline.
+ * 
+ * @return If the given time has been reached before the deadline.
+ */
+static bool SleepUntil(uint64_t time, uint64_t ddl) {
+    struct timespec ts;
+    bool reached = true;
+    uint64_t now;
+
+    if (ddl != 0 &&
+        ddl < time) {
+        time = ddl;
+        reached = false;
+    }
+
+    now = NowNs();
+    if (time <= now) {
+        return reached;
+    }
+
+    ts.tv_sec = (time_t)((time - now) / NS_PER_SEC);
+    ts.tv_nsec = (long)((time - now) % NS_PER_SEC);
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        continue;
+    }
+
+    return reached;
+}
+
+static uint32_t NextRand(EcoChanEmu *emu) {
+    uint32_t x = emu->seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    emu->seed = x;
+
+    return x;
+}
+
+/**
+ * @brief Get one-way delay in nanoseconds with random jitter.
+ */
+static uint64_t GetDelay(EcoChanEmu *emu) {
+    int64_t delay = (int64_t)emu->latency * (int64_t)NS_PER_MS;
+
+    if (emu->jitter != 0) {
+        int64_t range = (int64_t)emu->jitter * (int64_t)NS_PER_MS;
+
+        delay += (int64_t)(NextRand(emu) % (uint64_t)(range * 2 + 1)) - range;
+        if (delay < 0) {
+            delay = 0;
+        }
+    }
+
+    return (uint64_t)delay;
+}
+
+/**
+ * @brief Get transmission time in nanoseconds of the given length.
+ */
+static uint64_t GetTxTime(uint64_t bandwidth, size_t len) {
+    if (bandwidth == 0) {
+        return 0;
+    }
+
+    return (uint64_t)len * 8 * NS_PER_SEC / bandwidth;
+}
+
+/**
+ * @brief Get the maximum length which can be transmitted
+ *        from the given time until the deadline.
+ * 
+ * @return The maximum length, `SIZE_MAX` means unlimited.
+ */
+static size_t GetTxCap(uint64_t bandwidth, uint64_t begTime, uint64_t ddl) {
+    if (bandwidth == 0 ||
+        ddl == 0) {
+        return SIZE_MAX;
+    }
+
+    if (begTime >= ddl) {
+        return 0;
+    }
+
+    /* Microseconds keep the product from overflowing. */
+    return (size_t)((ddl - begTime) / 1000 * bandwidth / 8 / 1000000);
+}
+
+/**
+ * @brief Get the length of a partial read or write.
+ */
+static int GetPartialLen(EcoChanEmu *emu, size_t maxLen, int len) {
+    size_t curLen;
+
+    if (maxLen == 0 ||
+        len <= 1) {
+        return len;
+    }
+
+    curLen = NextRand(emu) % maxLen + 1;
+    if (curLen > (size_t)len) {
+        curLen = (size_t)len;
+    }
+
+    return (int)curLen;
+}
+
+void EcoChanEmu_Init(EcoChanEmu *emu, const EcoChanHooks *inner) {
+    if (inner != NULL) {
+        emu->inner = *inner;
+    } else {
+        memset(&emu->inner, 0, sizeof(emu->inner));
+    }
+
+    emu->latency = 0;
+    emu->jitter = 0;
+    emu->upBandwidth = 0;
+    emu->downBandwidth = 0;
+    emu->maxReadLen = 0;
+    emu->maxWriteLen = 0;
+    emu->seed = 1;
+
+    emu->connTimeout = 0;
+    emu->rwTimeout = 0;
+
+    emu->upIdleTime = 0;
+    emu->downIdleTime = 0;
+    emu->rspArrTime = 0;
+}
+
+EcoChanEmu *EcoChanEmu_New(const EcoChanHooks *inner) {
+    EcoChanEmu *newEmu;
+
+    newEmu = (EcoChanEmu *)malloc(sizeof(EcoChanEmu));
+    if (newEmu == NULL) {
+        return NULL;
+    }
+
+    EcoChanEmu_Init(newEmu, inner);
+
+    return newEmu;
+}
+
+void EcoChanEmu_Deinit(EcoChanEmu *emu) {
+    EcoChanEmu_Init(emu, NULL);
+}
+
+void EcoChanEmu_Del(EcoChanEmu *emu) {
+    EcoChanEmu_Deinit(emu);
+
+    free(emu);
+}
+
+EcoRes EcoChanEmu_SetOpt(EcoChanEmu *emu, EcoChanEmuOpt opt, EcoArg arg) {
+    switch (opt) {
+    case EcoChanEmuOpt_Latency:
+        emu->latency = (uint32_t)(size_t)arg;
+        break;
+
+    case EcoChanEmuOpt_Jitter:
+        emu->jitter = (uint32_t)(size_t)arg;
+        break;
+
+    case EcoChanEmuOpt_UpBandwidth:
+        emu->upBandwidth = (uint64_t)(size_t)arg;
+        break;
+
+    case EcoChanEmuOpt_DownBandwidth:
+        emu->downBandwidth = (uint64_t)(size_t)arg;
+        break;
+
+    case EcoChanEmuOpt_MaxReadLen:
+        emu->maxReadLen = (size_t)arg;
+        break;
+
+    case EcoChanEmuOpt_MaxWriteLen:
+        emu->maxWriteLen = (size_t)arg;
+        break;
+
+    case EcoChanEmuOpt_Seed:
+
+        /* Xorshift generator gets stuck at 0. */
+        emu->seed = (uint32_t)(size_t)arg != 0 ? (uint32_t)(size_t)arg : 1;
+        break;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+void EcoChanEmu_Wrap(EcoChanEmu *emu, EcoHttpCli *cli) {
+    EcoChanHooks hooks;
+
+    EcoHttpCli_GetChanHooks(cli, &emu->inner);
+
+    hooks.arg = emu;
+    hooks.openHook = EcoChanEmu_OpenHook;
+    hooks.closeHook = EcoChanEmu_CloseHook;
+    hooks.setOptHook = EcoChanEmu_SetOptHook;
+    hooks.readHook = EcoChanEmu_ReadHook;
+    hooks.writeHook = EcoChanEmu_WriteHook;
+
+    EcoHttpCli_SetChanHooks(cli, &hooks);
+}
+
+EcoRes EcoChanEmu_OpenHook(EcoChanAddr *addr, EcoArg arg) {
+    EcoChanEmu *emu = (EcoChanEmu *)arg;
+    uint64_t ddl;
+    uint64_t now;
+
+    /* Connection handshake takes a round trip. */
+    now = NowNs();
+    ddl = GetDdl(emu->connTimeout);
+
+    if (SleepUntil(now + GetDelay(emu) + GetDelay(emu), ddl) == false) {
+        return EcoRes_Timeout;
+    }
+
+    emu->upIdleTime = 0;
+    emu->downIdleTime = 0;
+    emu->rspArrTime = 0;
+
+    return emu->inner.openHook(addr, emu->inner.arg);
+}
+
+EcoRes EcoChanEmu_CloseHook(EcoArg arg) {
+    EcoChanEmu *emu = (EcoChanEmu *)arg;
+
+    return emu->inner.closeHook(emu->inner.arg);
+}
+
+EcoRes EcoChanEmu_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg) {
+    EcoChanEmu *emu = (EcoChanEmu *)hookArg;
+    EcoRes res = EcoRes_BadOpt;
+
+    if (emu->inner.setOptHook != NULL) {
+        res = emu->inner.setOptHook(opt, arg, emu->inner.arg);
+    }
+
+    /* Timeouts also bound the emulated waits, even if
+       the decorated channel doesn't support them. */
+    switch (opt) {
+    case EcoChanOpt_ConnTimeout:
+        emu->connTimeout = (uint32_t)(size_t)arg;
+        break;
+
+    case EcoChanOpt_ReadWriteTimeout:
+        emu->rwTimeout = (uint32_t)(size_t)arg;
+        break;
+
+    default:
+        return res;
+    }
+
+    return res == EcoRes_BadOpt ? EcoRes_Ok : res;
+}
+
+int EcoChanEmu_ReadHook(void *buf, int len, EcoArg arg) {
+    EcoChanEmu *emu = (EcoChanEmu *)arg;
+    uint64_t begTime;
+    uint64_t ddl;
+    size_t txCap;
+    int rdLen;
+
+    ddl = GetDdl(emu->rwTimeout);
+
+    /* Wait for the response of the last request. */
+    if (emu->rspArrTime != 0) {
+        if (SleepUntil(emu->rspArrTime, ddl) == false) {
+            return EcoRes_Timeout;
+        }
+
+        emu->rspArrTime = 0;
+    }
+
+    /* Only read what the downlink can deliver before the deadline. */
+    begTime = NowNs();
+    if (emu->downIdleTime > begTime) {
+        begTime = emu->downIdleTime;
+    }
+
+    txCap = GetTxCap(emu->downBandwidth, begTime, ddl);
+    if (txCap == 0) {
+        SleepUntil(ddl, 0);
+
+        return EcoRes_Timeout;
+    }
+
+    if ((size_t)len > txCap) {
+        len = (int)txCap;
+    }
+
+    rdLen = emu->inner.readHook(buf, GetPartialLen(emu, emu->maxReadLen, len),
+                                emu->inner.arg);
+    if (rdLen <= 0) {
+        return rdLen;
+    }
+
+    /* Data can't arrive faster than the downlink allows. */
+    begTime = NowNs();
+    if (emu->downIdleTime > begTime) {
+        begTime = emu->downIdleTime;
+    }
+
+    emu->downIdleTime = begTime + GetTxTime(emu->downBandwidth, (size_t)rdLen);
+
+    SleepUntil(emu->downIdleTime, ddl);
+
+    return rdLen;
+}
+
+int EcoChanEmu_WriteHook(const void *buf, int len, EcoArg arg) {
+    EcoChanEmu *emu = (EcoChanEmu *)arg;
+    uint64_t begTime;
+    uint64_t ddl;
+    size_t txCap;
+    int wrLen;
+
+    ddl = GetDdl(emu->rwTimeout);
+
+    /* Only write what the uplink can send before the deadline. */
+    begTime = NowNs();
+    if (emu->upIdleTime > begTime) {
+        begTime = emu->upIdleTime;
+    }
+
+    txCap = GetTxCap(emu->upBandwidth, begTime, ddl);
+    if (txCap == 0) {
+        SleepUntil(ddl, 0);
+
+        return EcoRes_Timeout;
+    }
+
+    if ((size_t)len > txCap) {
+        len = (int)txCap;
+    }
+
+    wrLen = emu->inner.writeHook(buf, GetPartialLen(emu, emu->maxWriteLen, len),
+                                 emu->inner.arg);
+    if (wrLen <= 0) {
+        return wrLen;
+    }
+
+    /* Data can't leave faster than the uplink allows. */
+    begTime = NowNs();
+    if (emu->upIdleTime > begTime) {
+        begTime = emu->upIdleTime;
+    }
+
+    emu->upIdleTime = begTime + GetTxTime(emu->upBandwidth, (size_t)wrLen);
+
+    SleepUntil(emu->upIdleTime, ddl);
+
+    /* Response can't come back before the request
+       reaches the peer and travels back. */
+    emu->rspArrTime = emu->upIdleTime + GetDelay(emu) + GetDelay(emu);
+
+    return wrLen;
+}
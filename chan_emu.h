@@ -0,0 +1,158 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ECHO_CHAN_EMU_H__
+#define __ECHO_CHAN_EMU_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "echo.h"
+
+typedef enum _EcoChanEmuOpt {
+
+    /* One-way latency in milliseconds. */
+    EcoChanEmuOpt_Latency,
+
+    /* Random jitter in milliseconds, which is added to
+       or subtracted from the latency of each response. */
+    EcoChanEmuOpt_Jitter,
+
+    /* Bandwidth in bits per second, 0 means unlimited. */
+    EcoChanEmuOpt_UpBandwidth,
+    EcoChanEmuOpt_DownBandwidth,
+
+    /* Maximum length of each read or write, 0 means unlimited.
+
+       The actual length of each operation is a random
+       number between 1 and the maximum length. */
+    EcoChanEmuOpt_MaxReadLen,
+    EcoChanEmuOpt_MaxWriteLen,
+
+    /* Seed of random jitter and partial reads/writes. */
+    EcoChanEmuOpt_Seed,
+} EcoChanEmuOpt;
+
+/* Network condition emulation channel, which decorates
+   another channel with latency, jitter, bandwidth caps
+   and partial reads/writes, all in process.
+
+   Opening pays a round trip for the handshake, and the first
+   read after a write waits until the request has reached the
+   peer and the response has come back.
+
+   Emulated waits are bounded by the timeouts pushed into the
+   channel, each operation fails with `EcoRes_Timeout` once its
+   timeout expires. */
+typedef struct _EcoChanEmu {
+    EcoChanHooks inner;
+
+    uint32_t latency;
+    uint32_t jitter;
+    uint64_t upBandwidth;
+    uint64_t downBandwidth;
+    size_t maxReadLen;
+    size_t maxWriteLen;
+    uint32_t seed;
+
+    /* Timeouts (in milliseconds) pushed into the channel, 0 means none. */
+    uint32_t connTimeout;
+    uint32_t rwTimeout;
+
+    /* Time (in nanoseconds) when uplink and downlink become idle. */
+    uint64_t upIdleTime;
+    uint64_t downIdleTime;
+
+    /* Time (in nanoseconds) when the response of the last
+       written request arrives, 0 means it has arrived. */
+    uint64_t rspArrTime;
+} EcoChanEmu;
+
+/**
+ * @brief Initialize a network emulation channel.
+ * 
+ * @param emu Network emulation channel.
+ * @param inner Hooks of the decorated channel.
+ */
+void EcoChanEmu_Init(EcoChanEmu *emu, const EcoChanHooks *inner);
+
+/**
+ * @brief Create a new network emulation channel.
+ * 
+ * @param inner Hooks of the decorated channel.
+ */
+EcoChanEmu *EcoChanEmu_New(const EcoChanHooks *inner);
+
+/**
+ * @brief Deinitialize a network emulation channel.
+ * @note The decorated channel won't be deinitialized.
+ * 
+ * @param emu Network emulation channel.
+ */
+void EcoChanEmu_Deinit(EcoChanEmu *emu);
+
+/**
+ * @brief Delete a network emulation channel.
+ * 
+ * @param emu Network emulation channel.
+ */
+void EcoChanEmu_Del(EcoChanEmu *emu);
+
+/**
+ * @brief Set a network emulation channel option.
+ * 
+ * @param emu Network emulation channel.
+ * @param opt Option to set.
+ * @param arg Option data to set.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoChanEmu_SetOpt(EcoChanEmu *emu, EcoChanEmuOpt opt, EcoArg arg);
+
+/**
+ * @brief Decorate the current channel of the HTTP client.
+ * @note The current channel hooks of the client become the
+ *       decorated channel, and are replaced with the hooks
+ *       of network emulation channel.
+ * 
+ * @param emu Network emulation channel.
+ * @param cli HTTP client.
+ */
+void EcoChanEmu_Wrap(EcoChanEmu *emu, EcoHttpCli *cli);
+
+/**
+ * @brief Channel hooks of network emulation channel,
+ *        the hook argument must be `EcoChanEmu *`.
+ */
+EcoRes EcoChanEmu_OpenHook(EcoChanAddr *addr, EcoArg arg);
+
+EcoRes EcoChanEmu_CloseHook(EcoArg arg);
+
+EcoRes EcoChanEmu_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg);
+
+int EcoChanEmu_ReadHook(void *buf, int len, EcoArg arg);
+
+int EcoChanEmu_WriteHook(const void *buf, int len, EcoArg arg);
+
+#endif
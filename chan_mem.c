@@ -0,0 +1,279 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "echo.h"
+#include "chan_mem.h"
+
+#define REQ_BUF_INIT_CAP    512
+
+void EcoChanMem_Init(EcoChanMem *mem) {
+    mem->reqBuf = NULL;
+    mem->reqCap = 0;
+    mem->reqLen = 0;
+
+    mem->rspBuf = NULL;
+    mem->rspLen = 0;
+    mem->rspOff = 0;
+
+    mem->frag = EcoChanMemFrag_None;
+    mem->fragLen = 0;
+    mem->seed = 1;
+
+    mem->openNum = 0;
+    mem->closeNum = 0;
+    mem->readNum = 0;
+    mem->writeNum = 0;
+
+    mem->opened = false;
+    mem->rspRead = false;
+}
+
+EcoChanMem *EcoChanMem_New(void) {
+    EcoChanMem *newMem;
+
+    newMem = (EcoChanMem *)malloc(sizeof(EcoChanMem));
+    if (newMem == NULL) {
+        return NULL;
+    }
+
+    EcoChanMem_Init(newMem);
+
+    return newMem;
+}
+
+void EcoChanMem_Deinit(EcoChanMem *mem) {
+    if (mem->reqBuf != NULL) {
+        free(mem->reqBuf);
+    }
+
+    EcoChanMem_Init(mem);
+}
+
+void EcoChanMem_Del(EcoChanMem *mem) {
+    EcoChanMem_Deinit(mem);
+
+    free(mem);
+}
+
+EcoRes EcoChanMem_SetOpt(EcoChanMem *mem, EcoChanMemOpt opt, EcoArg arg) {
+    switch (opt) {
+    case EcoChanMemOpt_RspBuf:
+        mem->rspBuf = (const uint8_t *)arg;
+        mem->rspOff = 0;
+        break;
+
+    case EcoChanMemOpt_RspLen:
+        mem->rspLen = (size_t)arg;
+        mem->rspOff = 0;
+        break;
+
+    case EcoChanMemOpt_Frag:
+        switch ((size_t)arg) {
+        case EcoChanMemFrag_None:
+        case EcoChanMemFrag_Fixed:
+        case EcoChanMemFrag_Random:
+            break;
+
+        default:
+            return EcoRes_BadArg;
+        }
+
+        mem->frag = (EcoChanMemFrag)(size_t)arg;
+        break;
+
+    case EcoChanMemOpt_FragLen:
+        mem->fragLen = (size_t)arg;
+        break;
+
+    case EcoChanMemOpt_Seed:
+
+        /* Xorshift generator gets stuck at 0. */
+        mem->seed = (uint32_t)(size_t)arg != 0 ? (uint32_t)(size_t)arg : 1;
+        break;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+void EcoChanMem_Apply(EcoChanMem *mem, EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanHookArg, mem);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanOpenHook, EcoChanMem_OpenHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanCloseHook, EcoChanMem_CloseHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanSetOptHook, EcoChanMem_SetOptHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanReadHook, EcoChanMem_ReadHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanWriteHook, EcoChanMem_WriteHook);
+}
+
+static uint32_t NextRand(EcoChanMem *mem) {
+    uint32_t x = mem->seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    mem->seed = x;
+
+    return x;
+}
+
+/**
+ * @brief Rewind both request capture and response replay.
+ */
+static void Rewind(EcoChanMem *mem) {
+    mem->reqLen = 0;
+    mem->rspOff = 0;
+    mem->rspRead = false;
+}
+
+EcoRes EcoChanMem_OpenHook(EcoChanAddr *addr, EcoArg arg) {
+    EcoChanMem *mem = (EcoChanMem *)arg;
+
+    (void)addr;
+
+    Rewind(mem);
+
+    mem->opened = true;
+    mem->openNum++;
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoChanMem_CloseHook(EcoArg arg) {
+    EcoChanMem *mem = (EcoChanMem *)arg;
+
+    mem->opened = false;
+    mem->closeNum++;
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoChanMem_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg) {
+    (void)arg;
+    (void)hookArg;
+
+    switch (opt) {
+    case EcoChanOpt_ConnTimeout:
+    case EcoChanOpt_ReadWriteTimeout:
+
+        /* Memory channel never blocks. */
+        return EcoRes_Ok;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+}
+
+int EcoChanMem_ReadHook(void *buf, int len, EcoArg arg) {
+    EcoChanMem *mem = (EcoChanMem *)arg;
+    size_t rdLen;
+
+    if (mem->opened == false) {
+        return EcoRes_BadChanRead;
+    }
+
+    if (mem->rspOff == mem->rspLen) {
+        return EcoRes_ReachEnd;
+    }
+
+    rdLen = mem->rspLen - mem->rspOff;
+    if (rdLen > (size_t)len) {
+        rdLen = (size_t)len;
+    }
+
+    if (mem->fragLen != 0) {
+        size_t fragLen;
+
+        switch (mem->frag) {
+        case EcoChanMemFrag_Fixed:
+            fragLen = mem->fragLen;
+            break;
+
+        case EcoChanMemFrag_Random:
+            fragLen = NextRand(mem) % mem->fragLen + 1;
+            break;
+
+        default:
+            fragLen = rdLen;
+            break;
+        }
+
+        if (rdLen > fragLen) {
+            rdLen = fragLen;
+        }
+    }
+
+    memcpy(buf, mem->rspBuf + mem->rspOff, rdLen);
+
+    mem->rspOff += rdLen;
+    mem->rspRead = true;
+    mem->readNum++;
+
+    return (int)rdLen;
+}
+
+int EcoChanMem_WriteHook(const void *buf, int len, EcoArg arg) {
+    EcoChanMem *mem = (EcoChanMem *)arg;
+
+    if (mem->opened == false) {
+        return EcoRes_BadChanWrite;
+    }
+
+    /* A new request on the same channel. */
+    if (mem->rspRead) {
+        Rewind(mem);
+    }
+
+    if (mem->reqLen + (size_t)len > mem->reqCap) {
+        size_t newCap = mem->reqCap == 0 ? REQ_BUF_INIT_CAP : mem->reqCap;
+        uint8_t *newBuf;
+
+        while (newCap < mem->reqLen + (size_t)len) {
+            newCap *= 2;
+        }
+
+        newBuf = (uint8_t *)realloc(mem->reqBuf, newCap);
+        if (newBuf == NULL) {
+            return EcoRes_NoMem;
+        }
+
+        mem->reqBuf = newBuf;
+        mem->reqCap = newCap;
+    }
+
+    memcpy(mem->reqBuf + mem->reqLen, buf, (size_t)len);
+
+    mem->reqLen += (size_t)len;
+    mem->writeNum++;
+
+    return len;
+}
@@ -0,0 +1,150 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ECHO_CHAN_MEM_H__
+#define __ECHO_CHAN_MEM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "echo.h"
+
+typedef enum _EcoChanMemFrag {
+
+    /* Each read returns as much data as requested. */
+    EcoChanMemFrag_None,
+
+    /* Each read returns at most `fragLen` bytes,
+       e.g. 1 for byte by byte, 1460 for MTU sized reads. */
+    EcoChanMemFrag_Fixed,
+
+    /* Each read returns a random length between 1 and `fragLen` bytes. */
+    EcoChanMemFrag_Random,
+} EcoChanMemFrag;
+
+typedef enum _EcoChanMemOpt {
+
+    /* Set scripted response byte stream, which is not copied. */
+    EcoChanMemOpt_RspBuf,
+    EcoChanMemOpt_RspLen,
+
+    /* Set read fragmentation mode, see `EcoChanMemFrag`. */
+    EcoChanMemOpt_Frag,
+    EcoChanMemOpt_FragLen,
+
+    /* Set seed of random fragmentation. */
+    EcoChanMemOpt_Seed,
+} EcoChanMemOpt;
+
+/* In-memory loopback channel.
+
+   Write hook captures request bytes into `reqBuf`, and read hook
+   replays the scripted response. Both of them are rewound when the
+   channel is opened, or when a new request is written after the
+   response has been read, so the same response can be replayed
+   over a keep-alive channel. */
+typedef struct _EcoChanMem {
+    uint8_t *reqBuf;
+    size_t reqCap;
+    size_t reqLen;
+
+    const uint8_t *rspBuf;
+    size_t rspLen;
+    size_t rspOff;
+
+    EcoChanMemFrag frag;
+    size_t fragLen;
+    uint32_t seed;
+
+    uint32_t openNum;
+    uint32_t closeNum;
+    uint32_t readNum;
+    uint32_t writeNum;
+
+    /* Flags. */
+    uint32_t opened: 1;
+    uint32_t rspRead: 1;
+} EcoChanMem;
+
+/**
+ * @brief Initialize a memory channel.
+ * 
+ * @param mem Memory channel.
+ */
+void EcoChanMem_Init(EcoChanMem *mem);
+
+/**
+ * @brief Create a new memory channel.
+ */
+EcoChanMem *EcoChanMem_New(void);
+
+/**
+ * @brief Deinitialize a memory channel.
+ * 
+ * @param mem Memory channel.
+ */
+void EcoChanMem_Deinit(EcoChanMem *mem);
+
+/**
+ * @brief Delete a memory channel.
+ * 
+ * @param mem Memory channel.
+ */
+void EcoChanMem_Del(EcoChanMem *mem);
+
+/**
+ * @brief Set a memory channel option.
+ * 
+ * @param mem Memory channel.
+ * @param opt Option to set.
+ * @param arg Option data to set.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoChanMem_SetOpt(EcoChanMem *mem, EcoChanMemOpt opt, EcoArg arg);
+
+/**
+ * @brief Set all channel hooks of the HTTP client to the memory channel.
+ * 
+ * @param mem Memory channel.
+ * @param cli HTTP client.
+ */
+void EcoChanMem_Apply(EcoChanMem *mem, EcoHttpCli *cli);
+
+/**
+ * @brief Channel hooks of memory channel, the
+ *        hook argument must be `EcoChanMem *`.
+ */
+EcoRes EcoChanMem_OpenHook(EcoChanAddr *addr, EcoArg arg);
+
+EcoRes EcoChanMem_CloseHook(EcoArg arg);
+
+EcoRes EcoChanMem_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg);
+
+int EcoChanMem_ReadHook(void *buf, int len, EcoArg arg);
+
+int EcoChanMem_WriteHook(const void *buf, int len, EcoArg arg);
+
+#endif
@@ -0,0 +1,561 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "echo.h"
+#include "chan_rec.h"
+
+#define NS_PER_SEC  1000000000ULL
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Sleep until the given time of monotonic clock.
+ */
+static void SleepUntil(uint64_t time) {
+    struct timespec ts;
+    uint64_t now;
+
+    now = NowNs();
+    if (time <= now) {
+        return;
+    }
+
+    ts.tv_sec = (time_t)((time - now) / NS_PER_SEC);
+    ts.tv_nsec = (long)((time - now) % NS_PER_SEC);
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        continue;
+    }
+}
+
+static void PutLe(uint8_t *buf, uint64_t val, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)(val >> (i * 8));
+    }
+}
+
+static uint64_t GetLe(const uint8_t *buf, size_t len) {
+    uint64_t val = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        val |= (uint64_t)buf[i] << (i * 8);
+    }
+
+    return val;
+}
+
+/**
+ * @brief Append a record to the capture file.
+ */
+static EcoRes WriteRec(EcoChanRec *rec, EcoChanCapRecType type, const void *buf, size_t len) {
+    uint8_t head[ECO_CHAN_CAP_REC_HEAD_LEN];
+
+    if (rec->file == NULL) {
+        return EcoRes_Ok;
+    }
+
+    memset(head, 0, sizeof(head));
+    head[0] = (uint8_t)type;
+    PutLe(head + 4, len, 4);
+    PutLe(head + 8, NowNs() - rec->begTime, 8);
+
+    if (fwrite(head, 1, sizeof(head), rec->file) != sizeof(head)) {
+        return EcoRes_Err;
+    }
+
+    if (len != 0 &&
+        fwrite(buf, 1, len, rec->file) != len) {
+        return EcoRes_Err;
+    }
+
+    rec->recNum++;
+
+    return EcoRes_Ok;
+}
+
+void EcoChanRec_Init(EcoChanRec *rec, const EcoChanHooks *inner) {
+    if (inner != NULL) {
+        rec->inner = *inner;
+    } else {
+        memset(&rec->inner, 0, sizeof(rec->inner));
+    }
+
+    rec->file = NULL;
+    rec->begTime = 0;
+    rec->recNum = 0;
+}
+
+EcoChanRec *EcoChanRec_New(const EcoChanHooks *inner) {
+    EcoChanRec *newRec;
+
+    newRec = (EcoChanRec *)malloc(sizeof(EcoChanRec));
+    if (newRec == NULL) {
+        return NULL;
+    }
+
+    EcoChanRec_Init(newRec, inner);
+
+    return newRec;
+}
+
+void EcoChanRec_Deinit(EcoChanRec *rec) {
+    if (rec->file != NULL) {
+        fclose(rec->file);
+    }
+
+    EcoChanRec_Init(rec, NULL);
+}
+
+void EcoChanRec_Del(EcoChanRec *rec) {
+    EcoChanRec_Deinit(rec);
+
+    free(rec);
+}
+
+EcoRes EcoChanRec_SetOpt(EcoChanRec *rec, EcoChanRecOpt opt, EcoArg arg) {
+    switch (opt) {
+    case EcoChanRecOpt_Path: {
+        const char *path = (const char *)arg;
+        FILE *file;
+
+        if (path == NULL) {
+            return EcoRes_BadArg;
+        }
+
+        file = fopen(path, "wb");
+        if (file == NULL) {
+            return EcoRes_Err;
+        }
+
+        if (fwrite(ECO_CHAN_CAP_MAGIC, 1, ECO_CHAN_CAP_MAGIC_LEN, file) != ECO_CHAN_CAP_MAGIC_LEN) {
+            fclose(file);
+
+            return EcoRes_Err;
+        }
+
+        if (rec->file != NULL) {
+            fclose(rec->file);
+        }
+
+        rec->file = file;
+        rec->begTime = NowNs();
+        rec->recNum = 0;
+        break;
+    }
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+void EcoChanRec_Wrap(EcoChanRec *rec, EcoHttpCli *cli) {
+    EcoChanHooks hooks;
+
+    EcoHttpCli_GetChanHooks(cli, &rec->inner);
+
+    hooks.arg = rec;
+    hooks.openHook = EcoChanRec_OpenHook;
+    hooks.closeHook = EcoChanRec_CloseHook;
+    hooks.setOptHook = EcoChanRec_SetOptHook;
+    hooks.readHook = EcoChanRec_ReadHook;
+    hooks.writeHook = EcoChanRec_WriteHook;
+
+    EcoHttpCli_SetChanHooks(cli, &hooks);
+}
+
+EcoRes EcoChanRec_OpenHook(EcoChanAddr *addr, EcoArg arg) {
+    EcoChanRec *rec = (EcoChanRec *)arg;
+    EcoRes res;
+
+    res = rec->inner.openHook(addr, rec->inner.arg);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    if (WriteRec(rec, EcoChanCapRecType_Open, NULL, 0) != EcoRes_Ok) {
+        rec->inner.closeHook(rec->inner.arg);
+
+        return EcoRes_BadChanOpen;
+    }
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoChanRec_CloseHook(EcoArg arg) {
+    EcoChanRec *rec = (EcoChanRec *)arg;
+
+    WriteRec(rec, EcoChanCapRecType_Close, NULL, 0);
+
+    /* Keep the capture usable while the client is still running. */
+    if (rec->file != NULL) {
+        fflush(rec->file);
+    }
+
+    return rec->inner.closeHook(rec->inner.arg);
+}
+
+EcoRes EcoChanRec_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg) {
+    EcoChanRec *rec = (EcoChanRec *)hookArg;
+
+    if (rec->inner.setOptHook == NULL) {
+        return EcoRes_BadOpt;
+    }
+
+    return rec->inner.setOptHook(opt, arg, rec->inner.arg);
+}
+
+int EcoChanRec_ReadHook(void *buf, int len, EcoArg arg) {
+    EcoChanRec *rec = (EcoChanRec *)arg;
+    int rdLen;
+
+    rdLen = rec->inner.readHook(buf, len, rec->inner.arg);
+    if (rdLen > 0) {
+        if (WriteRec(rec, EcoChanCapRecType_Read, buf, (size_t)rdLen) != EcoRes_Ok) {
+            return EcoRes_BadChanRead;
+        }
+    } else if (rdLen == EcoRes_ReachEnd) {
+        WriteRec(rec, EcoChanCapRecType_End, NULL, 0);
+    }
+
+    return rdLen;
+}
+
+int EcoChanRec_WriteHook(const void *buf, int len, EcoArg arg) {
+    EcoChanRec *rec = (EcoChanRec *)arg;
+    int wrLen;
+
+    wrLen = rec->inner.writeHook(buf, len, rec->inner.arg);
+    if (wrLen > 0) {
+        if (WriteRec(rec, EcoChanCapRecType_Write, buf, (size_t)wrLen) != EcoRes_Ok) {
+            return EcoRes_BadChanWrite;
+        }
+    }
+
+    return wrLen;
+}
+
+/**
+ * @brief Parse the record head at the given offset.
+ * 
+ * @return `true` if a complete record is there, otherwise `false`.
+ */
+static bool GetRec(EcoChanReplay *rep, size_t off, EcoChanCapRecType *type, size_t *len, uint64_t *time) {
+    const uint8_t *head = rep->capBuf + off;
+    size_t datLen;
+
+    if (off + ECO_CHAN_CAP_REC_HEAD_LEN > rep->capLen) {
+        return false;
+    }
+
+    datLen = (size_t)GetLe(head + 4, 4);
+    if (datLen > rep->capLen - off - ECO_CHAN_CAP_REC_HEAD_LEN) {
+        return false;
+    }
+
+    *type = (EcoChanCapRecType)head[0];
+    *len = datLen;
+    *time = GetLe(head + 8, 8);
+
+    return true;
+}
+
+/**
+ * @brief Find the next open record from the given offset.
+ * 
+ * @return Offset of the record, or `capLen` if not found.
+ */
+static size_t FindOpenRec(EcoChanReplay *rep, size_t off) {
+    EcoChanCapRecType type;
+    uint64_t time;
+    size_t len;
+
+    while (GetRec(rep, off, &type, &len, &time)) {
+        if (type == EcoChanCapRecType_Open) {
+            return off;
+        }
+
+        off += ECO_CHAN_CAP_REC_HEAD_LEN + len;
+    }
+
+    return rep->capLen;
+}
+
+void EcoChanReplay_Init(EcoChanReplay *rep) {
+    rep->capBuf = NULL;
+    rep->capLen = 0;
+
+    rep->recOff = 0;
+    rep->datOff = 0;
+
+    rep->speed = 0;
+
+    rep->baseTime = 0;
+    rep->capBaseTime = 0;
+
+    rep->openNum = 0;
+    rep->readNum = 0;
+
+    rep->opened = false;
+}
+
+EcoChanReplay *EcoChanReplay_New(void) {
+    EcoChanReplay *newRep;
+
+    newRep = (EcoChanReplay *)malloc(sizeof(EcoChanReplay));
+    if (newRep == NULL) {
+        return NULL;
+    }
+
+    EcoChanReplay_Init(newRep);
+
+    return newRep;
+}
+
+void EcoChanReplay_Deinit(EcoChanReplay *rep) {
+    if (rep->capBuf != NULL) {
+        munmap((void *)rep->capBuf, rep->capLen);
+    }
+
+    EcoChanReplay_Init(rep);
+}
+
+void EcoChanReplay_Del(EcoChanReplay *rep) {
+    EcoChanReplay_Deinit(rep);
+
+    free(rep);
+}
+
+EcoRes EcoChanReplay_SetOpt(EcoChanReplay *rep, EcoChanReplayOpt opt, EcoArg arg) {
+    switch (opt) {
+    case EcoChanReplayOpt_Path: {
+        const char *path = (const char *)arg;
+        struct stat st;
+        void *capBuf;
+        int fd;
+
+        if (path == NULL) {
+            return EcoRes_BadArg;
+        }
+
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return EcoRes_Err;
+        }
+
+        if (fstat(fd, &st) != 0 ||
+            (size_t)st.st_size < ECO_CHAN_CAP_MAGIC_LEN) {
+            close(fd);
+
+            return EcoRes_BadFmt;
+        }
+
+        capBuf = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (capBuf == MAP_FAILED) {
+            return EcoRes_Err;
+        }
+
+        if (memcmp(capBuf, ECO_CHAN_CAP_MAGIC, ECO_CHAN_CAP_MAGIC_LEN) != 0) {
+            munmap(capBuf, (size_t)st.st_size);
+
+            return EcoRes_BadFmt;
+        }
+
+        /* Captures are read sequentially. */
+        madvise(capBuf, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+        if (rep->capBuf != NULL) {
+            munmap((void *)rep->capBuf, rep->capLen);
+        }
+
+        rep->capBuf = (const uint8_t *)capBuf;
+        rep->capLen = (size_t)st.st_size;
+        rep->recOff = ECO_CHAN_CAP_MAGIC_LEN;
+        rep->datOff = 0;
+        rep->opened = false;
+        break;
+    }
+
+    case EcoChanReplayOpt_Speed:
+        rep->speed = (uint32_t)(size_t)arg;
+        break;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+void EcoChanReplay_Apply(EcoChanReplay *rep, EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanHookArg, rep);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanOpenHook, EcoChanReplay_OpenHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanCloseHook, EcoChanReplay_CloseHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanSetOptHook, EcoChanReplay_SetOptHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanReadHook, EcoChanReplay_ReadHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanWriteHook, EcoChanReplay_WriteHook);
+}
+
+EcoRes EcoChanReplay_OpenHook(EcoChanAddr *addr, EcoArg arg) {
+    EcoChanReplay *rep = (EcoChanReplay *)arg;
+    EcoChanCapRecType type;
+    size_t len;
+    size_t off;
+
+    /* Peer is whatever the capture has recorded. */
+    (void)addr;
+
+    if (rep->capBuf == NULL) {
+        return EcoRes_BadChanOpen;
+    }
+
+    /* Restart from the beginning after the last connection. */
+    off = FindOpenRec(rep, rep->recOff);
+    if (off == rep->capLen) {
+        off = FindOpenRec(rep, ECO_CHAN_CAP_MAGIC_LEN);
+        if (off == rep->capLen) {
+            return EcoRes_BadChanOpen;
+        }
+    }
+
+    GetRec(rep, off, &type, &len, &rep->capBaseTime);
+
+    rep->recOff = off + ECO_CHAN_CAP_REC_HEAD_LEN + len;
+    rep->datOff = 0;
+    rep->baseTime = NowNs();
+    rep->opened = true;
+    rep->openNum++;
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoChanReplay_CloseHook(EcoArg arg) {
+    EcoChanReplay *rep = (EcoChanReplay *)arg;
+
+    rep->opened = false;
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoChanReplay_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg) {
+    (void)arg;
+    (void)hookArg;
+
+    switch (opt) {
+    case EcoChanOpt_ConnTimeout:
+    case EcoChanOpt_ReadWriteTimeout:
+
+        /* Pacing is driven by the capture, not by the client. */
+        return EcoRes_Ok;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+}
+
+int EcoChanReplay_ReadHook(void *buf, int len, EcoArg arg) {
+    EcoChanReplay *rep = (EcoChanReplay *)arg;
+    EcoChanCapRecType type;
+    uint64_t time;
+    size_t recLen;
+    size_t rdLen;
+
+    if (rep->opened == false) {
+        return EcoRes_BadChanRead;
+    }
+
+    while (true) {
+        if (GetRec(rep, rep->recOff, &type, &recLen, &time) == false) {
+            return EcoRes_ReachEnd;
+        }
+
+        /* Recorded requests have been replaced by the written ones. */
+        if (type == EcoChanCapRecType_Write) {
+            rep->recOff += ECO_CHAN_CAP_REC_HEAD_LEN + recLen;
+            continue;
+        }
+
+        if (type != EcoChanCapRecType_Read) {
+            return EcoRes_ReachEnd;
+        }
+
+        if (rep->datOff < recLen) {
+            break;
+        }
+
+        rep->recOff += ECO_CHAN_CAP_REC_HEAD_LEN + recLen;
+        rep->datOff = 0;
+    }
+
+    if (rep->speed != 0 &&
+        rep->datOff == 0 &&
+        time > rep->capBaseTime) {
+        SleepUntil(rep->baseTime + (time - rep->capBaseTime) / rep->speed);
+    }
+
+    rdLen = recLen - rep->datOff;
+    if (rdLen > (size_t)len) {
+        rdLen = (size_t)len;
+    }
+
+    memcpy(buf, rep->capBuf + rep->recOff + ECO_CHAN_CAP_REC_HEAD_LEN + rep->datOff, rdLen);
+
+    rep->datOff += rdLen;
+    rep->readNum++;
+
+    return (int)rdLen;
+}
+
+int EcoChanReplay_WriteHook(const void *buf, int len, EcoArg arg) {
+    EcoChanReplay *rep = (EcoChanReplay *)arg;
+
+    (void)buf;
+
+    if (rep->opened == false) {
+        return EcoRes_BadChanWrite;
+    }
+
+    return len;
+}
@@ -0,0 +1,237 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ECHO_CHAN_REC_H__
+#define __ECHO_CHAN_REC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "echo.h"
+
+/* Capture file starts with an 8-byte magic, followed by records.
+
+   Each record has a 16-byte little-endian head, followed by its data:
+
+   +------+----------+--------+------------------------+
+   | type | reserved | length | timestamp (ns)         |
+   | 1 B  | 3 B      | 4 B    | 8 B                    |
+   +------+----------+--------+------------------------+
+
+   The timestamp is relative to the beginning of recording. */
+#define ECO_CHAN_CAP_MAGIC          "ECOCAP\x00\x01"
+#define ECO_CHAN_CAP_MAGIC_LEN      8
+#define ECO_CHAN_CAP_REC_HEAD_LEN   16
+
+typedef enum _EcoChanCapRecType {
+    EcoChanCapRecType_Open = 1,
+    EcoChanCapRecType_Close,
+    EcoChanCapRecType_Write,
+    EcoChanCapRecType_Read,
+
+    /* Channel has been closed by peer. */
+    EcoChanCapRecType_End,
+} EcoChanCapRecType;
+
+typedef enum _EcoChanRecOpt {
+
+    /* Path of the capture file, which is truncated
+       and starts with a new file header. */
+    EcoChanRecOpt_Path,
+} EcoChanRecOpt;
+
+/* Recording channel, which decorates another channel
+   and logs every byte it transfers to a capture file. */
+typedef struct _EcoChanRec {
+    EcoChanHooks inner;
+
+    FILE *file;
+    uint64_t begTime;
+    uint32_t recNum;
+} EcoChanRec;
+
+typedef enum _EcoChanReplayOpt {
+
+    /* Path of the capture file to replay. */
+    EcoChanReplayOpt_Path,
+
+    /* Pacing of responses, 0 means as fast as possible,
+       1 means original pacing, N means N times faster. */
+    EcoChanReplayOpt_Speed,
+} EcoChanReplayOpt;
+
+/* Replay channel, which maps a capture file and serves
+   the recorded responses back.
+
+   Writes are accepted but not compared with the recorded
+   requests, and every read returns at most one recorded
+   read, so the original fragmentation is reproduced.
+   After the last connection, replay restarts from the
+   beginning of the capture. */
+typedef struct _EcoChanReplay {
+    const uint8_t *capBuf;
+    size_t capLen;
+
+    /* Offset of the current record, and offset
+       of the next byte in the current record. */
+    size_t recOff;
+    size_t datOff;
+
+    uint32_t speed;
+
+    /* Open time of the replayed and recorded connection. */
+    uint64_t baseTime;
+    uint64_t capBaseTime;
+
+    uint32_t openNum;
+    uint32_t readNum;
+
+    /* Flags. */
+    uint32_t opened: 1;
+} EcoChanReplay;
+
+/**
+ * @brief Initialize a recording channel.
+ * 
+ * @param rec Recording channel.
+ * @param inner Hooks of the decorated channel.
+ */
+void EcoChanRec_Init(EcoChanRec *rec, const EcoChanHooks *inner);
+
+/**
+ * @brief Create a new recording channel.
+ * 
+ * @param inner Hooks of the decorated channel.
+ */
+EcoChanRec *EcoChanRec_New(const EcoChanHooks *inner);
+
+/**
+ * @brief Deinitialize a recording channel, and close its capture file.
+ * @note The decorated channel won't be deinitialized.
+ * 
+ * @param rec Recording channel.
+ */
+void EcoChanRec_Deinit(EcoChanRec *rec);
+
+/**
+ * @brief Delete a recording channel.
+ * 
+ * @param rec Recording channel.
+ */
+void EcoChanRec_Del(EcoChanRec *rec);
+
+/**
+ * @brief Set a recording channel option.
+ * 
+ * @param rec Recording channel.
+ * @param opt Option to set.
+ * @param arg Option data to set.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoChanRec_SetOpt(EcoChanRec *rec, EcoChanRecOpt opt, EcoArg arg);
+
+/**
+ * @brief Decorate the current channel of the HTTP client.
+ * 
+ * @param rec Recording channel.
+ * @param cli HTTP client.
+ */
+void EcoChanRec_Wrap(EcoChanRec *rec, EcoHttpCli *cli);
+
+/**
+ * @brief Channel hooks of recording channel,
+ *        the hook argument must be `EcoChanRec *`.
+ */
+EcoRes EcoChanRec_OpenHook(EcoChanAddr *addr, EcoArg arg);
+
+EcoRes EcoChanRec_CloseHook(EcoArg arg);
+
+EcoRes EcoChanRec_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg);
+
+int EcoChanRec_ReadHook(void *buf, int len, EcoArg arg);
+
+int EcoChanRec_WriteHook(const void *buf, int len, EcoArg arg);
+
+/**
+ * @brief Initialize a replay channel.
+ * 
+ * @param rep Replay channel.
+ */
+void EcoChanReplay_Init(EcoChanReplay *rep);
+
+/**
+ * @brief Create a new replay channel.
+ */
+EcoChanReplay *EcoChanReplay_New(void);
+
+/**
+ * @brief Deinitialize a replay channel, and unmap its capture file.
+ * 
+ * @param rep Replay channel.
+ */
+void EcoChanReplay_Deinit(EcoChanReplay *rep);
+
+/**
+ * @brief Delete a replay channel.
+ * 
+ * @param rep Replay channel.
+ */
+void EcoChanReplay_Del(EcoChanReplay *rep);
+
+/**
+ * @brief Set a replay channel option.
+ * 
+ * @param rep Replay channel.
+ * @param opt Option to set.
+ * @param arg Option data to set.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoChanReplay_SetOpt(EcoChanReplay *rep, EcoChanReplayOpt opt, EcoArg arg);
+
+/**
+ * @brief Install replay channel hooks into the HTTP client.
+ * 
+ * @param rep Replay channel.
+ * @param cli HTTP client.
+ */
+void EcoChanReplay_Apply(EcoChanReplay *rep, EcoHttpCli *cli);
+
+/**
+ * @brief Channel hooks of replay channel,
+ *        the hook argument must be `EcoChanReplay *`.
+ */
+EcoRes EcoChanReplay_OpenHook(EcoChanAddr *addr, EcoArg arg);
+
+EcoRes EcoChanReplay_CloseHook(EcoArg arg);
+
+EcoRes EcoChanReplay_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg);
+
+int EcoChanReplay_ReadHook(void *buf, int len, EcoArg arg);
+
+int EcoChanReplay_WriteHook(const void *buf, int len, EcoArg arg);
+
+#endif
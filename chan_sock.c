@@ -0,0 +1,546 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <netinet/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+
+#include "echo.h"
+#include "conf.h"
+#include "chan_sock.h"
+
+void EcoChanSock_Init(EcoChanSock *sock) {
+    sock->fd = -1;
+    sock->connTimeout = 0;
+    sock->attemptDelay = ECO_CONF_DEF_CONN_ATTEMPT_DELAY;
+}
+
+EcoChanSock *EcoChanSock_New(void) {
+    EcoChanSock *newSock;
+
+    newSock = (EcoChanSock *)malloc(sizeof(EcoChanSock));
+    if (newSock == NULL) {
+        return NULL;
+    }
+
+    EcoChanSock_Init(newSock);
+
+    return newSock;
+}
+
+void EcoChanSock_Deinit(EcoChanSock *sock) {
+    if (sock->fd != -1) {
+        close(sock->fd);
+    }
+
+    EcoChanSock_Init(sock);
+}
+
+void EcoChanSock_Del(EcoChanSock *sock) {
+    EcoChanSock_Deinit(sock);
+
+    free(sock);
+}
+
+EcoRes EcoChanSock_SetOpt(EcoChanSock *sock, EcoChanSockOpt opt, EcoArg arg) {
+    switch (opt) {
+    case EcoChanSockOpt_AttemptDelay:
+        sock->attemptDelay = (uint32_t)(size_t)arg;
+        break;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+void EcoChanSock_Apply(EcoChanSock *sock, EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanHookArg, sock);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanOpenHook, EcoChanSock_OpenHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanCloseHook, EcoChanSock_CloseHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanSetOptHook, EcoChanSock_SetOptHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanReadHook, EcoChanSock_ReadHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanWriteHook, EcoChanSock_WriteHook);
+}
+
+/**
+ * @brief Connect socket, optionally within a timeout.
+ * 
+ * @param fd Socket file descriptor.
+ * @param addr Socket address.
+ * @param addrLen Socket address length.
+ * @param timeout Timeout in milliseconds, 0 means no timeout.
+ */
+static int ConnSock(int fd, const struct sockaddr *addr, socklen_t addrLen,
+                    uint32_t timeout) {
+    struct pollfd pfd;
+    socklen_t errLen;
+    int flags;
+    int err;
+    int ret;
+
+    if (timeout == 0) {
+        do {
+            ret = connect(fd, addr, addrLen);
+        } while (ret != 0 && errno == EINTR);
+
+        return ret;
+    }
+
+    flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    ret = connect(fd, addr, addrLen);
+    if (ret != 0 &&
+        errno == EINPROGRESS) {
+        pfd.fd = fd;
+        pfd.events = POLLOUT;
+
+        do {
+            ret = poll(&pfd, 1, (int)timeout);
+        } while (ret == -1 && errno == EINTR);
+
+        if (ret == 1) {
+            errLen = sizeof(err);
+
+            ret = getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen);
+            if (ret == 0 && err != 0) {
+                ret = -1;
+            }
+        } else {
+            ret = -1;
+        }
+    }
+
+    fcntl(fd, F_SETFL, flags);
+
+    return ret;
+}
+
+/**
+ * @brief Fill socket address of the IP address and port.
+ * 
+ * @return Length of the socket address.
+ */
+static socklen_t FillSockAddr(struct sockaddr_storage *sa, const EcoIpAddr *ip, uint16_t port) {
+    memset(sa, 0, sizeof(*sa));
+
+    if (ip->ver == EcoIpVer_6) {
+        struct sockaddr_in6 *sa6 = (struct sockaddr_in6 *)sa;
+
+        sa6->sin6_family = AF_INET6;
+        sa6->sin6_port = htons(port);
+        memcpy(&sa6->sin6_addr, ip->buf, 16);
+
+        return sizeof(*sa6);
+    } else {
+        struct sockaddr_in *sa4 = (struct sockaddr_in *)sa;
+
+        sa4->sin_family = AF_INET;
+        sa4->sin_port = htons(port);
+        memcpy(&sa4->sin_addr, ip->buf, 4);
+
+        return sizeof(*sa4);
+    }
+}
+
+static int NewTcpSock(EcoIpVer ver) {
+    int opt = 1;
+    int fd;
+
+    fd = socket(ver == EcoIpVer_6 ? AF_INET6 : AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd == -1) {
+        return -1;
+    }
+
+    /* Request and response are small and interactive,
+       so don't let Nagle's algorithm delay them. */
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    return fd;
+}
+
+/**
+ * @brief Order addresses for racing (RFC 8305), alternating versions
+ *        and starting with the version of the most preferred one.
+ * 
+ * @param ipAry Addresses in order of preference.
+ * @param ipNum Number of addresses.
+ * @param sortAry Buffer to store the ordered addresses.
+ */
+static void SortRaceAddrs(const EcoIpAddr *ipAry, size_t ipNum, EcoIpAddr *sortAry) {
+    EcoIpVer ver = ipAry[0].ver;
+    size_t idxAry[2] = { 0, 0 };
+    size_t sortNum = 0;
+
+    while (sortNum < ipNum) {
+        size_t *idx = idxAry + (ver == EcoIpVer_6);
+
+        while (*idx < ipNum &&
+               ipAry[*idx].ver != ver) {
+            (*idx)++;
+        }
+
+        if (*idx < ipNum) {
+            sortAry[sortNum++] = ipAry[(*idx)++];
+        }
+
+        ver = ver == EcoIpVer_6 ? EcoIpVer_4 : EcoIpVer_6;
+    }
+}
+
+static uint64_t NowMs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Race connection attempts to the addresses, starting the next one
+ *        once the attempt delay passes or an earlier attempt fails.
+ * @note Attempts which lose the race are closed.
+ * 
+ * @param ipAry Addresses in order of racing.
+ * @param ipNum Number of addresses.
+ * @param port Port.
+ * @param timeout Timeout in milliseconds, 0 means no timeout.
+ * @param attemptDelay Delay in milliseconds between starts of attempts.
+ * 
+ * @return Socket file descriptor of the winner, or -1 if all attempts fail.
+ */
+static int RaceConn(const EcoIpAddr *ipAry, size_t ipNum, uint16_t port,
+                    uint32_t timeout, uint32_t attemptDelay) {
+    struct pollfd pfdAry[ECO_CHAN_IP_MAX_NUM];
+    uint64_t ddl = timeout != 0 ? NowMs() + timeout : 0;
+    uint64_t nextTime = 0;
+    size_t nextIdx = 0;
+    size_t pfdNum = 0;
+    int winFd = -1;
+
+    while (winFd == -1) {
+        uint64_t now = NowMs();
+        int waitTime = -1;
+        int ret;
+
+        if (ddl != 0 &&
+            now >= ddl) {
+            break;
+        }
+
+        /* Start the next attempt if it's due, or nothing is in progress. */
+        if (nextIdx < ipNum &&
+            (now >= nextTime || pfdNum == 0)) {
+            struct sockaddr_storage sa;
+            socklen_t saLen;
+            int fd;
+
+            saLen = FillSockAddr(&sa, ipAry + nextIdx, port);
+            fd = NewTcpSock(ipAry[nextIdx].ver);
+            nextIdx++;
+
+            /* Failure starts the next attempt right away. */
+            if (fd == -1) {
+                nextTime = 0;
+                continue;
+            }
+
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+            ret = connect(fd, (struct sockaddr *)&sa, saLen);
+            if (ret == 0) {
+                winFd = fd;
+                break;
+            }
+
+            if (errno != EINPROGRESS) {
+                close(fd);
+                nextTime = 0;
+                continue;
+            }
+
+            pfdAry[pfdNum].fd = fd;
+            pfdAry[pfdNum].events = POLLOUT;
+            pfdAry[pfdNum].revents = 0;
+            pfdNum++;
+
+            nextTime = now + attemptDelay;
+            continue;
+        }
+
+        if (pfdNum == 0) {
+            break;
+        }
+
+        if (nextIdx < ipNum) {
+            waitTime = (int)(nextTime - now);
+        }
+
+        if (ddl != 0 &&
+            (waitTime == -1 || ddl - now < (uint64_t)waitTime)) {
+            waitTime = (int)(ddl - now);
+        }
+
+        ret = poll(pfdAry, pfdNum, waitTime);
+        if (ret == -1 &&
+            errno != EINTR) {
+            break;
+        }
+
+        for (size_t i = 0; ret > 0 && i < pfdNum; ) {
+            socklen_t errLen = sizeof(int);
+            int err = 0;
+
+            if (pfdAry[i].revents == 0) {
+                i++;
+                continue;
+            }
+
+            if (getsockopt(pfdAry[i].fd, SOL_SOCKET, SO_ERROR, &err, &errLen) == 0 &&
+                err == 0) {
+                winFd = pfdAry[i].fd;
+            } else {
+                close(pfdAry[i].fd);
+
+                /* Failure starts the next attempt right away. */
+                nextTime = 0;
+            }
+
+            pfdAry[i] = pfdAry[--pfdNum];
+
+            if (winFd != -1) {
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < pfdNum; i++) {
+        close(pfdAry[i].fd);
+    }
+
+    if (winFd != -1) {
+        fcntl(winFd, F_SETFL, fcntl(winFd, F_GETFL) & ~O_NONBLOCK);
+    }
+
+    return winFd;
+}
+
+EcoRes EcoChanSock_OpenHook(EcoChanAddr *addr, EcoArg arg) {
+    EcoChanSock *sock = (EcoChanSock *)arg;
+    EcoIpAddr ipAry[ECO_CHAN_IP_MAX_NUM];
+    size_t ipNum;
+    int fd;
+    int ret;
+
+    /* Close the previous socket if it's still open. */
+    if (sock->fd != -1) {
+        close(sock->fd);
+        sock->fd = -1;
+    }
+
+    if (addr->type == EcoChanAddrType_Unix) {
+        struct sockaddr_un srvAddr;
+
+        if (addr->sockPathLen == 0 ||
+            addr->sockPathLen >= sizeof(srvAddr.sun_path)) {
+            return EcoRes_BadChanOpen;
+        }
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1) {
+            return EcoRes_BadChanOpen;
+        }
+
+        memset(&srvAddr, 0, sizeof(srvAddr));
+        srvAddr.sun_family = AF_UNIX;
+        memcpy(srvAddr.sun_path, addr->sockPath, addr->sockPathLen + 1);
+
+        ret = ConnSock(fd, (struct sockaddr *)&srvAddr, sizeof(srvAddr),
+                       sock->connTimeout);
+        if (ret != 0) {
+            close(fd);
+
+            return EcoRes_BadChanOpen;
+        }
+
+        sock->fd = fd;
+
+        return EcoRes_Ok;
+    }
+
+    /* Host name has been resolved by the client. */
+    if (addr->type == EcoChanAddrType_Name) {
+        if (addr->ipNum == 0 ||
+            addr->ipNum > ECO_CHAN_IP_MAX_NUM) {
+            return EcoRes_BadChanOpen;
+        }
+
+        SortRaceAddrs(addr->ipAry, addr->ipNum, ipAry);
+        ipNum = addr->ipNum;
+    } else if (addr->type == EcoChanAddrType_Ipv6) {
+        ipAry[0].ver = EcoIpVer_6;
+        memcpy(ipAry[0].buf, addr->addr6, 16);
+        ipNum = 1;
+    } else {
+        ipAry[0].ver = EcoIpVer_4;
+        memcpy(ipAry[0].buf, addr->addr, 4);
+        ipNum = 1;
+    }
+
+    if (ipNum == 1) {
+        struct sockaddr_storage srvAddr;
+        socklen_t srvAddrLen;
+
+        fd = NewTcpSock(ipAry[0].ver);
+        if (fd == -1) {
+            return EcoRes_BadChanOpen;
+        }
+
+        srvAddrLen = FillSockAddr(&srvAddr, ipAry, addr->port);
+
+        ret = ConnSock(fd, (struct sockaddr *)&srvAddr, srvAddrLen,
+                       sock->connTimeout);
+        if (ret != 0) {
+            close(fd);
+
+            return EcoRes_BadChanOpen;
+        }
+    } else {
+        fd = RaceConn(ipAry, ipNum, addr->port, sock->connTimeout, sock->attemptDelay);
+        if (fd == -1) {
+            return EcoRes_BadChanOpen;
+        }
+    }
+
+    sock->fd = fd;
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoChanSock_CloseHook(EcoArg arg) {
+    EcoChanSock *sock = (EcoChanSock *)arg;
+    int ret;
+
+    if (sock->fd == -1) {
+        return EcoRes_Ok;
+    }
+
+    ret = close(sock->fd);
+    sock->fd = -1;
+    if (ret != 0) {
+        return EcoRes_BadChanClose;
+    }
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoChanSock_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg) {
+    EcoChanSock *sock = (EcoChanSock *)hookArg;
+    size_t timeout = (size_t)arg;
+    struct timeval tv;
+
+    switch (opt) {
+    case EcoChanOpt_ConnTimeout:
+        sock->connTimeout = (uint32_t)timeout;
+        break;
+
+    case EcoChanOpt_ReadWriteTimeout:
+        if (sock->fd == -1) {
+            return EcoRes_BadChanSetOpt;
+        }
+
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+
+        if (setsockopt(sock->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0 ||
+            setsockopt(sock->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0) {
+            return EcoRes_BadChanSetOpt;
+        }
+
+        break;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+int EcoChanSock_ReadHook(void *buf, int len, EcoArg arg) {
+    EcoChanSock *sock = (EcoChanSock *)arg;
+    ssize_t ret;
+
+    do {
+        ret = recv(sock->fd, buf, (size_t)len, 0);
+    } while (ret == -1 && errno == EINTR);
+
+    if (ret <= 0) {
+        if (ret == 0) {
+            return EcoRes_ReachEnd;
+        }
+
+        return EcoRes_BadChanRead;
+    }
+
+    return (int)ret;
+}
+
+int EcoChanSock_WriteHook(const void *buf, int len, EcoArg arg) {
+    EcoChanSock *sock = (EcoChanSock *)arg;
+    ssize_t ret;
+    int wrLen = 0;
+
+    while (wrLen != len) {
+
+        /* Don't let a peer reset kill the whole process. */
+        ret = send(sock->fd, (const uint8_t *)buf + wrLen,
+                   (size_t)(len - wrLen), MSG_NOSIGNAL);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return EcoRes_BadChanWrite;
+        }
+
+        wrLen += (int)ret;
+    }
+
+    return wrLen;
+}
@@ -0,0 +1,115 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ECHO_CHAN_SOCK_H__
+#define __ECHO_CHAN_SOCK_H__
+
+#include <stdint.h>
+
+#include "echo.h"
+
+typedef enum _EcoChanSockOpt {
+
+    /* Delay (in milliseconds) before racing the next
+       resolved address of a host name, while earlier
+       attempts are still in progress. */
+    EcoChanSockOpt_AttemptDelay,
+} EcoChanSockOpt;
+
+/* Socket channel, which connects to a TCP/IPv4, TCP/IPv6
+   address or a Unix domain socket path.
+
+   Resolved addresses of a host name are raced with staggered
+   starts (Happy Eyeballs), alternating address versions,
+   the first connected one wins. */
+typedef struct _EcoChanSock {
+    int fd;
+
+    /* Timeout (in milliseconds) of the next connect, 0 means no timeout. */
+    uint32_t connTimeout;
+
+    uint32_t attemptDelay;
+} EcoChanSock;
+
+/**
+ * @brief Initialize a socket channel.
+ * 
+ * @param sock Socket channel.
+ */
+void EcoChanSock_Init(EcoChanSock *sock);
+
+/**
+ * @brief Create a new socket channel.
+ */
+EcoChanSock *EcoChanSock_New(void);
+
+/**
+ * @brief Deinitialize a socket channel.
+ * @note The socket will be closed if it's still open.
+ * 
+ * @param sock Socket channel.
+ */
+void EcoChanSock_Deinit(EcoChanSock *sock);
+
+/**
+ * @brief Delete a socket channel.
+ * 
+ * @param sock Socket channel.
+ */
+void EcoChanSock_Del(EcoChanSock *sock);
+
+/**
+ * @brief Set a socket channel option.
+ * 
+ * @param sock Socket channel.
+ * @param opt Option to set.
+ * @param arg Option data to set.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoChanSock_SetOpt(EcoChanSock *sock, EcoChanSockOpt opt, EcoArg arg);
+
+/**
+ * @brief Set all channel hooks of the HTTP client to the socket channel.
+ * 
+ * @param sock Socket channel.
+ * @param cli HTTP client.
+ */
+void EcoChanSock_Apply(EcoChanSock *sock, EcoHttpCli *cli);
+
+/**
+ * @brief Channel hooks of socket channel, the
+ *        hook argument must be `EcoChanSock *`.
+ */
+EcoRes EcoChanSock_OpenHook(EcoChanAddr *addr, EcoArg arg);
+
+EcoRes EcoChanSock_CloseHook(EcoArg arg);
+
+EcoRes EcoChanSock_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg);
+
+int EcoChanSock_ReadHook(void *buf, int len, EcoArg arg);
+
+int EcoChanSock_WriteHook(const void *buf, int len, EcoArg arg);
+
+#endif
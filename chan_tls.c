@@ -0,0 +1,655 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <openssl/x509v3.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <poll.h>
+#include <time.h>
+
+#include "echo.h"
+#include "conf.h"
+#include "chan_sock.h"
+#include "chan_tls.h"
+
+/* Signal mask saved while SIGPIPE is blocked. */
+typedef struct _SigPipeMask {
+    sigset_t oldSet;
+    bool pending;
+} SigPipeMask;
+
+/**
+ * @brief Block SIGPIPE of the calling thread.
+ * @note OpenSSL writes to the socket without `MSG_NOSIGNAL`, so
+ *       a peer reset would kill the whole process otherwise.
+ */
+static void BlockSigPipe(SigPipeMask *mask) {
+    sigset_t pipeSet;
+    sigset_t pendSet;
+
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &mask->oldSet);
+
+    sigpending(&pendSet);
+    mask->pending = sigismember(&pendSet, SIGPIPE) ? true : false;
+}
+
+/**
+ * @brief Discard SIGPIPE raised while it's blocked, and restore the signal mask.
+ */
+static void RestoreSigPipe(SigPipeMask *mask) {
+    struct timespec ts = {0, 0};
+    sigset_t pipeSet;
+    sigset_t pendSet;
+
+    sigpending(&pendSet);
+
+    if (mask->pending == false &&
+        sigismember(&pendSet, SIGPIPE)) {
+        sigemptyset(&pipeSet);
+        sigaddset(&pipeSet, SIGPIPE);
+
+        while (sigtimedwait(&pipeSet, NULL, &ts) == -1 &&
+               errno == EINTR);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &mask->oldSet, NULL);
+}
+
+static uint32_t HashSessKey(const char *keyBuf, size_t keyLen) {
+    uint32_t hash = 5381;
+
+    for (size_t i = 0; i < keyLen; i++) {
+        hash = ((hash << 5) + hash) + (uint8_t)keyBuf[i];
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Find the cached session of the given peer.
+ * 
+ * @return The cached session, or `NULL` if not found.
+ */
+static EcoTlsSess *EcoChanTlsCtx_FindSess(EcoChanTlsCtx *ctx,
+                                          const char *keyBuf, size_t keyLen) {
+    uint32_t keyHash = HashSessKey(keyBuf, keyLen);
+
+    for (size_t i = 0; i < ctx->sessNum; i++) {
+        EcoTlsSess *sess = ctx->sessAry + i;
+
+        if (sess->keyHash == keyHash &&
+            sess->keyLen == keyLen &&
+            memcmp(sess->keyBuf, keyBuf, keyLen) == 0) {
+            return sess;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Cache the session of the given peer.
+ * @note The least recently used session will be evicted if the cache is full.
+ *       The cache takes over the reference of `sslSess`.
+ */
+static void EcoChanTlsCtx_PutSess(EcoChanTlsCtx *ctx,
+                                  const char *keyBuf, size_t keyLen,
+                                  SSL_SESSION *sslSess) {
+    EcoTlsSess *sess;
+
+    if (ctx->sessCap == 0) {
+        SSL_SESSION_free(sslSess);
+
+        return;
+    }
+
+    sess = EcoChanTlsCtx_FindSess(ctx, keyBuf, keyLen);
+    if (sess == NULL) {
+        if (ctx->sessNum < ctx->sessCap) {
+            sess = ctx->sessAry + ctx->sessNum;
+            ctx->sessNum++;
+        } else {
+            sess = ctx->sessAry;
+
+            for (size_t i = 1; i < ctx->sessNum; i++) {
+                if (ctx->sessAry[i].useTick < sess->useTick) {
+                    sess = ctx->sessAry + i;
+                }
+            }
+
+            SSL_SESSION_free(sess->sess);
+        }
+
+        memcpy(sess->keyBuf, keyBuf, keyLen);
+        sess->keyBuf[keyLen] = '\0';
+        sess->keyLen = keyLen;
+        sess->keyHash = HashSessKey(keyBuf, keyLen);
+    } else {
+        SSL_SESSION_free(sess->sess);
+    }
+
+    sess->sess = sslSess;
+    sess->useTick = ++ctx->sessTick;
+}
+
+/**
+ * @brief Drop the cached session of the given peer.
+ */
+static void EcoChanTlsCtx_DropSess(EcoChanTlsCtx *ctx,
+                                   const char *keyBuf, size_t keyLen) {
+    EcoTlsSess *sess;
+
+    sess = EcoChanTlsCtx_FindSess(ctx, keyBuf, keyLen);
+    if (sess == NULL) {
+        return;
+    }
+
+    SSL_SESSION_free(sess->sess);
+
+    ctx->sessNum--;
+    *sess = ctx->sessAry[ctx->sessNum];
+}
+
+static void EcoChanTlsCtx_ClearSess(EcoChanTlsCtx *ctx) {
+    for (size_t i = 0; i < ctx->sessNum; i++) {
+        SSL_SESSION_free(ctx->sessAry[i].sess);
+    }
+
+    ctx->sessNum = 0;
+}
+
+/**
+ * @brief New session callback of OpenSSL.
+ * @note With TLS 1.3, session tickets arrive after the
+ *       handshake, so they can only be caught here.
+ */
+static int NewSessCb(SSL *ssl, SSL_SESSION *sslSess) {
+    EcoChanTls *tls = (EcoChanTls *)SSL_get_app_data(ssl);
+
+    if (tls == NULL ||
+        tls->sessKeyLen == 0) {
+        return 0;
+    }
+
+    EcoChanTlsCtx_PutSess(tls->ctx, tls->sessKeyBuf, tls->sessKeyLen, sslSess);
+
+    return 1;
+}
+
+EcoRes EcoChanTlsCtx_Init(EcoChanTlsCtx *ctx) {
+    ctx->sessAry = NULL;
+    ctx->sessCap = 0;
+    ctx->sessNum = 0;
+    ctx->sessTick = 0;
+    ctx->verifyPeer = true;
+
+    ctx->sslCtx = SSL_CTX_new(TLS_client_method());
+    if (ctx->sslCtx == NULL) {
+        return EcoRes_Err;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx->sslCtx, TLS1_2_VERSION);
+    SSL_CTX_set_default_verify_paths(ctx->sslCtx);
+
+    /* Sessions are cached by peer in our own cache, because
+       OpenSSL's internal cache is only used by servers. */
+    SSL_CTX_set_session_cache_mode(ctx->sslCtx, SSL_SESS_CACHE_CLIENT |
+                                                SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx->sslCtx, NewSessCb);
+
+    ctx->sessAry = (EcoTlsSess *)malloc(sizeof(EcoTlsSess) * ECO_CONF_DEF_TLS_SESS_CAP);
+    if (ctx->sessAry == NULL) {
+        SSL_CTX_free(ctx->sslCtx);
+        ctx->sslCtx = NULL;
+
+        return EcoRes_NoMem;
+    }
+
+    ctx->sessCap = ECO_CONF_DEF_TLS_SESS_CAP;
+
+    return EcoRes_Ok;
+}
+
+EcoChanTlsCtx *EcoChanTlsCtx_New(void) {
+    EcoChanTlsCtx *newCtx;
+
+    newCtx = (EcoChanTlsCtx *)malloc(sizeof(EcoChanTlsCtx));
+    if (newCtx == NULL) {
+        return NULL;
+    }
+
+    if (EcoChanTlsCtx_Init(newCtx) != EcoRes_Ok) {
+        free(newCtx);
+
+        return NULL;
+    }
+
+    return newCtx;
+}
+
+void EcoChanTlsCtx_Deinit(EcoChanTlsCtx *ctx) {
+    EcoChanTlsCtx_ClearSess(ctx);
+
+    if (ctx->sessAry != NULL) {
+        free(ctx->sessAry);
+        ctx->sessAry = NULL;
+    }
+
+    ctx->sessCap = 0;
+
+    if (ctx->sslCtx != NULL) {
+        SSL_CTX_free(ctx->sslCtx);
+        ctx->sslCtx = NULL;
+    }
+}
+
+void EcoChanTlsCtx_Del(EcoChanTlsCtx *ctx) {
+    EcoChanTlsCtx_Deinit(ctx);
+
+    free(ctx);
+}
+
+EcoRes EcoChanTlsCtx_SetOpt(EcoChanTlsCtx *ctx, EcoChanTlsCtxOpt opt, EcoArg arg) {
+    switch (opt) {
+    case EcoChanTlsCtxOpt_VerifyPeer:
+        ctx->verifyPeer = (size_t)arg ? true : false;
+        break;
+
+    case EcoChanTlsCtxOpt_CaFile:
+        if (SSL_CTX_load_verify_locations(ctx->sslCtx, (const char *)arg, NULL) != 1) {
+            return EcoRes_BadArg;
+        }
+
+        break;
+
+    case EcoChanTlsCtxOpt_SessCap: {
+        size_t newCap = (size_t)arg;
+        EcoTlsSess *newAry = NULL;
+
+        if (newCap != 0) {
+            newAry = (EcoTlsSess *)malloc(sizeof(EcoTlsSess) * newCap);
+            if (newAry == NULL) {
+                return EcoRes_NoMem;
+            }
+        }
+
+        EcoChanTlsCtx_ClearSess(ctx);
+
+        if (ctx->sessAry != NULL) {
+            free(ctx->sessAry);
+        }
+
+        ctx->sessAry = newAry;
+        ctx->sessCap = newCap;
+
+        break;
+    }
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+void EcoChanTls_Init(EcoChanTls *tls, EcoChanTlsCtx *ctx) {
+    EcoChanSock_Init(&tls->sock);
+    tls->ctx = ctx;
+    tls->ssl = NULL;
+    tls->sessKeyBuf[0] = '\0';
+    tls->sessKeyLen = 0;
+    tls->resumed = false;
+}
+
+EcoChanTls *EcoChanTls_New(EcoChanTlsCtx *ctx) {
+    EcoChanTls *newTls;
+
+    newTls = (EcoChanTls *)malloc(sizeof(EcoChanTls));
+    if (newTls == NULL) {
+        return NULL;
+    }
+
+    EcoChanTls_Init(newTls, ctx);
+
+    return newTls;
+}
+
+void EcoChanTls_Deinit(EcoChanTls *tls) {
+    EcoChanTls_CloseHook(tls);
+
+    EcoChanTls_Init(tls, tls->ctx);
+}
+
+void EcoChanTls_Del(EcoChanTls *tls) {
+    EcoChanTls_Deinit(tls);
+
+    free(tls);
+}
+
+void EcoChanTls_Apply(EcoChanTls *tls, EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanHookArg, tls);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanOpenHook, EcoChanTls_OpenHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanCloseHook, EcoChanTls_CloseHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanSetOptHook, EcoChanTls_SetOptHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanReadHook, EcoChanTls_ReadHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanWriteHook, EcoChanTls_WriteHook);
+}
+
+/**
+ * @brief Generate session cache key of the peer.
+ */
+static void GenSessKey(EcoChanTls *tls, EcoChanAddr *addr) {
+    int ret;
+
+    if (addr->type == EcoChanAddrType_Unix) {
+        ret = snprintf(tls->sessKeyBuf, sizeof(tls->sessKeyBuf),
+                       "unix:%s", addr->sockPath);
+    } else if (addr->type == EcoChanAddrType_Name) {
+        ret = snprintf(tls->sessKeyBuf, sizeof(tls->sessKeyBuf),
+                       "%s:%u", addr->name, addr->port);
+    } else if (addr->type == EcoChanAddrType_Ipv6) {
+        char ipBuf[INET6_ADDRSTRLEN];
+
+        inet_ntop(AF_INET6, addr->addr6, ipBuf, sizeof(ipBuf));
+
+        ret = snprintf(tls->sessKeyBuf, sizeof(tls->sessKeyBuf),
+                       "[%s]:%u", ipBuf, addr->port);
+    } else {
+        ret = snprintf(tls->sessKeyBuf, sizeof(tls->sessKeyBuf),
+                       "%u.%u.%u.%u:%u",
+                       addr->addr[0], addr->addr[1],
+                       addr->addr[2], addr->addr[3],
+                       addr->port);
+    }
+
+    if (ret < 0 ||
+        (size_t)ret >= sizeof(tls->sessKeyBuf)) {
+        tls->sessKeyLen = 0;
+    } else {
+        tls->sessKeyLen = (size_t)ret;
+    }
+}
+
+static uint64_t NowMs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Perform TLS handshake, optionally before a deadline.
+ * 
+ * @param ssl SSL object bound to the socket.
+ * @param fd Socket file descriptor.
+ * @param ddl Deadline on the monotonic clock in milliseconds, 0 means none.
+ * 
+ * @return `EcoRes_Ok` for success, `EcoRes_Timeout` if the deadline
+ *         expires, otherwise `EcoRes_BadChanOpen`.
+ */
+static EcoRes ConnSsl(SSL *ssl, int fd, uint64_t ddl) {
+    struct pollfd pfd;
+    uint64_t now;
+    EcoRes res;
+    int flags;
+    int ret;
+
+    if (ddl == 0) {
+        return SSL_connect(ssl) == 1 ? EcoRes_Ok : EcoRes_BadChanOpen;
+    }
+
+    flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    pfd.fd = fd;
+
+    while (true) {
+        ret = SSL_connect(ssl);
+        if (ret == 1) {
+            res = EcoRes_Ok;
+            break;
+        }
+
+        switch (SSL_get_error(ssl, ret)) {
+        case SSL_ERROR_WANT_READ:
+            pfd.events = POLLIN;
+            break;
+
+        case SSL_ERROR_WANT_WRITE:
+            pfd.events = POLLOUT;
+            break;
+
+        default:
+            pfd.events = 0;
+            break;
+        }
+
+        if (pfd.events == 0) {
+            res = EcoRes_BadChanOpen;
+            break;
+        }
+
+        now = NowMs();
+        if (now >= ddl) {
+            res = EcoRes_Timeout;
+            break;
+        }
+
+        ret = poll(&pfd, 1, (int)(ddl - now));
+        if (ret == -1 &&
+            errno != EINTR) {
+            res = EcoRes_BadChanOpen;
+            break;
+        }
+    }
+
+    fcntl(fd, F_SETFL, flags);
+
+    return res;
+}
+
+EcoRes EcoChanTls_OpenHook(EcoChanAddr *addr, EcoArg arg) {
+    EcoChanTls *tls = (EcoChanTls *)arg;
+    EcoTlsSess *sess = NULL;
+    uint64_t ddl = 0;
+    SigPipeMask mask;
+    SSL *ssl;
+    EcoRes res;
+
+    /* Close the previous connection if it's still open. */
+    EcoChanTls_CloseHook(tls);
+
+    /* Handshake shares the connecting budget with the socket. */
+    if (tls->sock.connTimeout != 0) {
+        ddl = NowMs() + tls->sock.connTimeout;
+    }
+
+    res = EcoChanSock_OpenHook(addr, &tls->sock);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    ssl = SSL_new(tls->ctx->sslCtx);
+    if (ssl == NULL) {
+        goto CloseSock;
+    }
+
+    SSL_set_fd(ssl, tls->sock.fd);
+    SSL_set_app_data(ssl, tls);
+
+    /* Server name indication is only sent for host names. */
+    if (addr->type == EcoChanAddrType_Name) {
+        SSL_set_tlsext_host_name(ssl, addr->name);
+    }
+
+    if (tls->ctx->verifyPeer) {
+        SSL_set_verify(ssl, SSL_VERIFY_PEER, NULL);
+
+        if (addr->type == EcoChanAddrType_Ipv4) {
+            X509_VERIFY_PARAM_set1_ip(SSL_get0_param(ssl), addr->addr, 4);
+        } else if (addr->type == EcoChanAddrType_Ipv6) {
+            X509_VERIFY_PARAM_set1_ip(SSL_get0_param(ssl), addr->addr6, 16);
+        } else if (addr->type == EcoChanAddrType_Name) {
+            X509_VERIFY_PARAM_set1_host(SSL_get0_param(ssl), addr->name, addr->nameLen);
+        }
+    } else {
+        SSL_set_verify(ssl, SSL_VERIFY_NONE, NULL);
+    }
+
+    /* Try to resume the cached session of this peer. */
+    GenSessKey(tls, addr);
+    if (tls->sessKeyLen != 0) {
+        sess = EcoChanTlsCtx_FindSess(tls->ctx, tls->sessKeyBuf, tls->sessKeyLen);
+        if (sess != NULL) {
+            SSL_set_session(ssl, sess->sess);
+            sess->useTick = ++tls->ctx->sessTick;
+        }
+    }
+
+    BlockSigPipe(&mask);
+    res = ConnSsl(ssl, tls->sock.fd, ddl);
+    RestoreSigPipe(&mask);
+
+    if (res != EcoRes_Ok) {
+
+        /* The cached session may be the cause, unless the peer is slow. */
+        if (sess != NULL &&
+            res != EcoRes_Timeout) {
+            EcoChanTlsCtx_DropSess(tls->ctx, tls->sessKeyBuf, tls->sessKeyLen);
+        }
+
+        ERR_clear_error();
+        SSL_free(ssl);
+
+        EcoChanSock_CloseHook(&tls->sock);
+
+        return res;
+    }
+
+    tls->ssl = ssl;
+    tls->resumed = SSL_session_reused(ssl) ? true : false;
+
+    return EcoRes_Ok;
+
+CloseSock:
+    EcoChanSock_CloseHook(&tls->sock);
+
+    return EcoRes_BadChanOpen;
+}
+
+EcoRes EcoChanTls_CloseHook(EcoArg arg) {
+    EcoChanTls *tls = (EcoChanTls *)arg;
+    SigPipeMask mask;
+
+    if (tls->ssl != NULL) {
+        BlockSigPipe(&mask);
+        SSL_shutdown(tls->ssl);
+        RestoreSigPipe(&mask);
+
+        SSL_free(tls->ssl);
+        tls->ssl = NULL;
+
+        ERR_clear_error();
+    }
+
+    return EcoChanSock_CloseHook(&tls->sock);
+}
+
+EcoRes EcoChanTls_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg) {
+    EcoChanTls *tls = (EcoChanTls *)hookArg;
+
+    return EcoChanSock_SetOptHook(opt, arg, &tls->sock);
+}
+
+int EcoChanTls_ReadHook(void *buf, int len, EcoArg arg) {
+    EcoChanTls *tls = (EcoChanTls *)arg;
+    SigPipeMask mask;
+    int ret;
+
+    if (tls->ssl == NULL) {
+        return EcoRes_BadChanRead;
+    }
+
+    /* Reading may write alerts and key updates as well. */
+    BlockSigPipe(&mask);
+    ret = SSL_read(tls->ssl, buf, len);
+    RestoreSigPipe(&mask);
+
+    if (ret > 0) {
+        return ret;
+    }
+
+    switch (SSL_get_error(tls->ssl, ret)) {
+    case SSL_ERROR_ZERO_RETURN:
+        return EcoRes_ReachEnd;
+
+    default:
+
+        /* Closing without close_notify can't be told apart from
+           a truncation by an attacker, so it fails the read too. */
+        ERR_clear_error();
+
+        return EcoRes_BadChanRead;
+    }
+}
+
+int EcoChanTls_WriteHook(const void *buf, int len, EcoArg arg) {
+    EcoChanTls *tls = (EcoChanTls *)arg;
+    SigPipeMask mask;
+    int ret;
+
+    if (tls->ssl == NULL) {
+        return EcoRes_BadChanWrite;
+    }
+
+    if (len == 0) {
+        return 0;
+    }
+
+    BlockSigPipe(&mask);
+    ret = SSL_write(tls->ssl, buf, len);
+    RestoreSigPipe(&mask);
+
+    if (ret <= 0) {
+        ERR_clear_error();
+
+        return EcoRes_BadChanWrite;
+    }
+
+    return ret;
+}
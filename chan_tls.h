@@ -0,0 +1,188 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ECHO_CHAN_TLS_H__
+#define __ECHO_CHAN_TLS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "echo.h"
+#include "chan_sock.h"
+
+struct ssl_ctx_st;
+struct ssl_st;
+struct ssl_session_st;
+
+typedef enum _EcoChanTlsCtxOpt {
+
+    /* Verify peer certificate, enabled by default. */
+    EcoChanTlsCtxOpt_VerifyPeer,
+
+    /* CA file used to verify peer certificate,
+       system default CA paths are used if not set. */
+    EcoChanTlsCtxOpt_CaFile,
+
+    /* Set the maximum number of cached sessions.
+
+       This option will drop all cached sessions. */
+    EcoChanTlsCtxOpt_SessCap,
+} EcoChanTlsCtxOpt;
+
+/* Key is "unix:<path>" or "<host>:<port>", and
+   the latter is the longer one. */
+#define ECO_TLS_SESS_KEY_MAX_LEN    ECO_CHAN_HOST_MAX_LEN
+#define ECO_TLS_SESS_KEY_BUF_LEN    (ECO_TLS_SESS_KEY_MAX_LEN + 1)
+
+/* Cached TLS session of a peer. */
+typedef struct _EcoTlsSess {
+    char keyBuf[ECO_TLS_SESS_KEY_BUF_LEN];
+    size_t keyLen;
+    uint32_t keyHash;
+    uint64_t useTick;
+    struct ssl_session_st *sess;
+} EcoTlsSess;
+
+/* TLS context, which can be shared by multiple TLS channels
+   of the same thread, so that sessions can be resumed
+   across channels and connections. */
+typedef struct _EcoChanTlsCtx {
+    struct ssl_ctx_st *sslCtx;
+
+    EcoTlsSess *sessAry;
+    size_t sessCap;
+    size_t sessNum;
+    uint64_t sessTick;
+
+    bool verifyPeer;
+} EcoChanTlsCtx;
+
+/* TLS channel on top of a socket channel. */
+typedef struct _EcoChanTls {
+    EcoChanSock sock;
+    EcoChanTlsCtx *ctx;
+    struct ssl_st *ssl;
+
+    /* Session cache key of the current peer. */
+    char sessKeyBuf[ECO_TLS_SESS_KEY_BUF_LEN];
+    size_t sessKeyLen;
+
+    /* If the last handshake resumed a cached session. */
+    bool resumed;
+} EcoChanTls;
+
+/**
+ * @brief Initialize a TLS context.
+ * 
+ * @param ctx TLS context.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoChanTlsCtx_Init(EcoChanTlsCtx *ctx);
+
+/**
+ * @brief Create a new TLS context.
+ */
+EcoChanTlsCtx *EcoChanTlsCtx_New(void);
+
+/**
+ * @brief Deinitialize a TLS context.
+ * @note All cached sessions will be dropped.
+ * 
+ * @param ctx TLS context.
+ */
+void EcoChanTlsCtx_Deinit(EcoChanTlsCtx *ctx);
+
+/**
+ * @brief Delete a TLS context.
+ * 
+ * @param ctx TLS context.
+ */
+void EcoChanTlsCtx_Del(EcoChanTlsCtx *ctx);
+
+/**
+ * @brief Set a TLS context option.
+ * 
+ * @param ctx TLS context.
+ * @param opt Option to set.
+ * @param arg Option data to set.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoChanTlsCtx_SetOpt(EcoChanTlsCtx *ctx, EcoChanTlsCtxOpt opt, EcoArg arg);
+
+/**
+ * @brief Initialize a TLS channel.
+ * 
+ * @param tls TLS channel.
+ * @param ctx TLS context used by this channel.
+ */
+void EcoChanTls_Init(EcoChanTls *tls, EcoChanTlsCtx *ctx);
+
+/**
+ * @brief Create a new TLS channel.
+ * 
+ * @param ctx TLS context used by this channel.
+ */
+EcoChanTls *EcoChanTls_New(EcoChanTlsCtx *ctx);
+
+/**
+ * @brief Deinitialize a TLS channel.
+ * @note The connection will be closed if it's still open.
+ * 
+ * @param tls TLS channel.
+ */
+void EcoChanTls_Deinit(EcoChanTls *tls);
+
+/**
+ * @brief Delete a TLS channel.
+ * 
+ * @param tls TLS channel.
+ */
+void EcoChanTls_Del(EcoChanTls *tls);
+
+/**
+ * @brief Set all channel hooks of the HTTP client to the TLS channel.
+ * 
+ * @param tls TLS channel.
+ * @param cli HTTP client.
+ */
+void EcoChanTls_Apply(EcoChanTls *tls, EcoHttpCli *cli);
+
+/**
+ * @brief Channel hooks of TLS channel, the
+ *        hook argument must be `EcoChanTls *`.
+ */
+EcoRes EcoChanTls_OpenHook(EcoChanAddr *addr, EcoArg arg);
+
+EcoRes EcoChanTls_CloseHook(EcoArg arg);
+
+EcoRes EcoChanTls_SetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg);
+
+int EcoChanTls_ReadHook(void *buf, int len, EcoArg arg);
+
+int EcoChanTls_WriteHook(const void *buf, int len, EcoArg arg);
+
+#endif
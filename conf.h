@@ -32,4 +32,70 @@
    dynamically on the heap. */
 #define ECO_CONF_DEF_SND_CHUNK_LEN  512
 
+/* Default receive buffer capacity.
+
+   The receive buffer will be allocated
+   dynamically on the heap, it starts at
+   this capacity and shrinks back to it
+   when responses become small again. */
+#define ECO_CONF_DEF_RCV_BUF_CAP    4096
+
+/* Default maximum receive buffer capacity.
+
+   When reads keep filling the receive
+   buffer, it's doubled up to this
+   capacity. Setting it to the value of
+   `ECO_CONF_DEF_RCV_BUF_CAP` disables
+   adaptive sizing. */
+#define ECO_CONF_DEF_RCV_BUF_MAX_CAP    (256 * 1024)
+
+/* Default maximum length of an abandoned
+   response body to drain.
+
+   Draining the rest of a body keeps
+   the channel alive for the next issue,
+   longer bodies make the channel closed
+   instead. */
+#define ECO_CONF_DEF_DRAIN_MAX_LEN  (64 * 1024)
+
+/* Default maximum time (in milliseconds)
+   to drain an abandoned response body,
+   0 means no limit. */
+#define ECO_CONF_DEF_DRAIN_TIMEOUT  100
+
+/* Default delay (in milliseconds) before
+   racing the next address of a host name,
+   which is recommended by RFC 8305. */
+#define ECO_CONF_DEF_CONN_ATTEMPT_DELAY 250
+
+/* TLS channel support, which is enabled by
+   the build system when OpenSSL is available. */
+#ifndef ECO_CONF_TLS
+#define ECO_CONF_TLS                0
+#endif
+
+/* Default maximum number of cached TLS sessions
+   in a TLS context, one for each peer. */
+#define ECO_CONF_DEF_TLS_SESS_CAP   32
+
+/* Default time to live (in milliseconds)
+   of resolved host names.
+
+   `getaddrinfo()` doesn't tell the TTL of
+   DNS records, so this one is used unless
+   the lookup hook reports one. */
+#define ECO_CONF_DEF_DNS_TTL        60000
+
+/* Default time to live (in milliseconds)
+   of failed host name lookups. */
+#define ECO_CONF_DEF_DNS_NEG_TTL    5000
+
+/* Default maximum number of cached host
+   names in a resolver. */
+#define ECO_CONF_DEF_DNS_CACHE_CAP  256
+
+/* Default number of worker threads
+   of a resolver. */
+#define ECO_CONF_DEF_DNS_THRD_NUM   2
+
 #endif
@@ -0,0 +1,576 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netdb.h>
+#include <errno.h>
+#include <time.h>
+
+#include "echo.h"
+#include "conf.h"
+#include "dns.h"
+
+static uint64_t NowMs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static uint32_t HashName(const char *nameBuf, size_t nameLen) {
+    uint32_t hash = 5381;
+
+    for (size_t i = 0; i < nameLen; i++) {
+        hash = ((hash << 5) + hash) + (uint8_t)nameBuf[i];
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Find the cached entry of the given host name.
+ * 
+ * @return The cached entry, or `NULL` if not found.
+ */
+static EcoDnsEnt *EcoDns_FindEnt(EcoDns *dns, const char *nameBuf,
+                                 size_t nameLen, uint32_t nameHash) {
+    for (size_t i = 0; i < dns->entNum; i++) {
+        EcoDnsEnt *ent = dns->entAry + i;
+
+        if (ent->nameHash == nameHash &&
+            ent->nameLen == nameLen &&
+            memcmp(ent->nameBuf, nameBuf, nameLen) == 0) {
+            return ent;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Get a free entry for a new host name.
+ * @note The least recently used entry will be evicted if the cache is full,
+ *       entries of lookups in progress are never evicted.
+ * 
+ * @return The free entry, or `NULL` if all entries are in progress.
+ */
+static EcoDnsEnt *EcoDns_GetFreeEnt(EcoDns *dns) {
+    EcoDnsEnt *ent = NULL;
+
+    if (dns->entNum < dns->entCap) {
+        return dns->entAry + dns->entNum++;
+    }
+
+    for (size_t i = 0; i < dns->entNum; i++) {
+        if (dns->entAry[i].stat != EcoDnsEntStat_Done) {
+            continue;
+        }
+
+        if (ent == NULL ||
+            dns->entAry[i].useTick < ent->useTick) {
+            ent = dns->entAry + i;
+        }
+    }
+
+    return ent;
+}
+
+/**
+ * @brief Get the next queued entry.
+ */
+static EcoDnsEnt *EcoDns_GetQueuedEnt(EcoDns *dns) {
+    for (size_t i = 0; i < dns->entNum; i++) {
+        if (dns->entAry[i].stat == EcoDnsEntStat_Queued) {
+            return dns->entAry + i;
+        }
+    }
+
+    return NULL;
+}
+
+static void *EcoDns_Work(void *arg) {
+    EcoDns *dns = (EcoDns *)arg;
+    char nameBuf[ECO_CHAN_NAME_BUF_LEN];
+    EcoDnsLookupHook lookupHook;
+    EcoArg lookupHookArg;
+    EcoIpAddr ipAry[ECO_CHAN_IP_MAX_NUM];
+    uint32_t nameHash;
+    size_t nameLen;
+    EcoDnsEnt *ent;
+    size_t ipNum;
+    uint32_t ttl;
+    EcoRes res;
+
+    pthread_mutex_lock(&dns->mutex);
+
+    while (!dns->stop) {
+        ent = EcoDns_GetQueuedEnt(dns);
+        if (ent == NULL) {
+            pthread_cond_wait(&dns->jobCond, &dns->mutex);
+            continue;
+        }
+
+        ent->stat = EcoDnsEntStat_Busy;
+
+        /* Lookup runs unlocked, so copy what it needs. */
+        memcpy(nameBuf, ent->nameBuf, ent->nameLen + 1);
+        nameLen = ent->nameLen;
+        nameHash = ent->nameHash;
+        lookupHook = dns->lookupHook;
+        lookupHookArg = dns->lookupHookArg;
+        ttl = dns->ttl;
+
+        pthread_mutex_unlock(&dns->mutex);
+
+        ipNum = ECO_CHAN_IP_MAX_NUM;
+
+        res = lookupHook(nameBuf, ipAry, &ipNum, &ttl, lookupHookArg);
+        if (res != EcoRes_Ok ||
+            ipNum == 0) {
+            res = EcoRes_BadResolve;
+        }
+
+        pthread_mutex_lock(&dns->mutex);
+
+        ent = EcoDns_FindEnt(dns, nameBuf, nameLen, nameHash);
+        if (ent != NULL &&
+            ent->stat == EcoDnsEntStat_Busy) {
+            ent->res = res;
+            if (res == EcoRes_Ok) {
+                memcpy(ent->ipAry, ipAry, sizeof(EcoIpAddr) * ipNum);
+                ent->ipNum = ipNum;
+            }
+            ent->expTime = NowMs() + (res == EcoRes_Ok ? ttl : dns->negTtl);
+            ent->stat = EcoDnsEntStat_Done;
+        }
+
+        pthread_cond_broadcast(&dns->doneCond);
+    }
+
+    pthread_mutex_unlock(&dns->mutex);
+
+    return NULL;
+}
+
+/**
+ * @brief Start worker threads if they haven't been started.
+ * @note It must be called with the mutex locked.
+ */
+static EcoRes EcoDns_StartThrds(EcoDns *dns) {
+    if (dns->thrdCnt != 0) {
+        return EcoRes_Ok;
+    }
+
+    if (dns->thrdAry == NULL) {
+        dns->thrdAry = (pthread_t *)malloc(sizeof(pthread_t) * dns->thrdNum);
+        if (dns->thrdAry == NULL) {
+            return EcoRes_NoMem;
+        }
+    }
+
+    /* Fewer workers are fine, as long as there's one. */
+    for (size_t i = 0; i < dns->thrdNum; i++) {
+        if (pthread_create(dns->thrdAry + i, NULL, EcoDns_Work, dns) != 0) {
+            break;
+        }
+
+        dns->thrdCnt++;
+    }
+
+    return dns->thrdCnt != 0 ? EcoRes_Ok : EcoRes_Err;
+}
+
+EcoRes EcoDns_Init(EcoDns *dns) {
+    pthread_condattr_t condAttr;
+
+    dns->entAry = NULL;
+    dns->entCap = 0;
+    dns->entNum = 0;
+    dns->entTick = 0;
+    dns->thrdAry = NULL;
+    dns->thrdNum = ECO_CONF_DEF_DNS_THRD_NUM;
+    dns->thrdCnt = 0;
+    dns->stop = false;
+    dns->ttl = ECO_CONF_DEF_DNS_TTL;
+    dns->negTtl = ECO_CONF_DEF_DNS_NEG_TTL;
+    dns->lookupHookArg = NULL;
+    dns->lookupHook = EcoDns_LookupHook;
+    dns->hitNum = 0;
+    dns->missNum = 0;
+
+    dns->entAry = (EcoDnsEnt *)malloc(sizeof(EcoDnsEnt) * ECO_CONF_DEF_DNS_CACHE_CAP);
+    if (dns->entAry == NULL) {
+        return EcoRes_NoMem;
+    }
+
+    dns->entCap = ECO_CONF_DEF_DNS_CACHE_CAP;
+
+    /* Deadlines of waiting are measured in monotonic time. */
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+
+    pthread_mutex_init(&dns->mutex, NULL);
+    pthread_cond_init(&dns->jobCond, NULL);
+    pthread_cond_init(&dns->doneCond, &condAttr);
+
+    pthread_condattr_destroy(&condAttr);
+
+    return EcoRes_Ok;
+}
+
+EcoDns *EcoDns_New(void) {
+    EcoDns *newDns;
+
+    newDns = (EcoDns *)malloc(sizeof(EcoDns));
+    if (newDns == NULL) {
+        return NULL;
+    }
+
+    if (EcoDns_Init(newDns) != EcoRes_Ok) {
+        free(newDns);
+
+        return NULL;
+    }
+
+    return newDns;
+}
+
+void EcoDns_Deinit(EcoDns *dns) {
+    pthread_mutex_lock(&dns->mutex);
+    dns->stop = true;
+    pthread_cond_broadcast(&dns->jobCond);
+    pthread_mutex_unlock(&dns->mutex);
+
+    for (size_t i = 0; i < dns->thrdCnt; i++) {
+        pthread_join(dns->thrdAry[i], NULL);
+    }
+
+    if (dns->thrdAry != NULL) {
+        free(dns->thrdAry);
+        dns->thrdAry = NULL;
+    }
+
+    dns->thrdCnt = 0;
+
+    if (dns->entAry != NULL) {
+        free(dns->entAry);
+        dns->entAry = NULL;
+    }
+
+    dns->entCap = 0;
+    dns->entNum = 0;
+
+    pthread_cond_destroy(&dns->doneCond);
+    pthread_cond_destroy(&dns->jobCond);
+    pthread_mutex_destroy(&dns->mutex);
+}
+
+void EcoDns_Del(EcoDns *dns) {
+    EcoDns_Deinit(dns);
+
+    free(dns);
+}
+
+EcoRes EcoDns_SetOpt(EcoDns *dns, EcoDnsOpt opt, EcoArg arg) {
+    EcoRes res = EcoRes_Ok;
+
+    pthread_mutex_lock(&dns->mutex);
+
+    switch (opt) {
+    case EcoDnsOpt_Ttl:
+        dns->ttl = (uint32_t)(size_t)arg;
+        break;
+
+    case EcoDnsOpt_NegTtl:
+        dns->negTtl = (uint32_t)(size_t)arg;
+        break;
+
+    case EcoDnsOpt_CacheCap: {
+        size_t newCap = (size_t)arg;
+        EcoDnsEnt *newAry;
+
+        if (newCap == 0) {
+            res = EcoRes_BadArg;
+            break;
+        }
+
+        /* Workers still refer to their entries. */
+        for (size_t i = 0; i < dns->entNum; i++) {
+            if (dns->entAry[i].stat != EcoDnsEntStat_Done) {
+                res = EcoRes_Err;
+                break;
+            }
+        }
+
+        if (res != EcoRes_Ok) {
+            break;
+        }
+
+        newAry = (EcoDnsEnt *)malloc(sizeof(EcoDnsEnt) * newCap);
+        if (newAry == NULL) {
+            res = EcoRes_NoMem;
+            break;
+        }
+
+        free(dns->entAry);
+
+        dns->entAry = newAry;
+        dns->entCap = newCap;
+        dns->entNum = 0;
+
+        break;
+    }
+
+    case EcoDnsOpt_ThrdNum:
+        if ((size_t)arg == 0) {
+            res = EcoRes_BadArg;
+            break;
+        }
+
+        if (dns->thrdCnt != 0) {
+            res = EcoRes_Err;
+            break;
+        }
+
+        if (dns->thrdAry != NULL) {
+            free(dns->thrdAry);
+            dns->thrdAry = NULL;
+        }
+
+        dns->thrdNum = (size_t)arg;
+        break;
+
+    case EcoDnsOpt_LookupHookArg:
+        dns->lookupHookArg = arg;
+        break;
+
+    case EcoDnsOpt_LookupHook:
+        if (arg == NULL) {
+            res = EcoRes_BadArg;
+            break;
+        }
+
+        dns->lookupHook = (EcoDnsLookupHook)arg;
+        break;
+
+    default:
+        res = EcoRes_BadOpt;
+        break;
+    }
+
+    pthread_mutex_unlock(&dns->mutex);
+
+    return res;
+}
+
+/**
+ * @brief Look up the cache, and queue a lookup if the name isn't cached or expired.
+ * 
+ * @param wait Wait for the queued lookup or not.
+ */
+static EcoRes EcoDns_Lookup(EcoDns *dns, const char *name, EcoIpAddr *ipAry,
+                            size_t *ipNum, uint32_t timeout, bool wait) {
+    size_t nameLen = strlen(name);
+    struct timespec ddl;
+    bool missed = false;
+    uint32_t nameHash;
+    EcoDnsEnt *ent;
+    EcoRes res;
+
+    if (nameLen == 0 ||
+        nameLen > ECO_CHAN_NAME_MAX_LEN) {
+        return EcoRes_BadArg;
+    }
+
+    nameHash = HashName(name, nameLen);
+
+    if (timeout != 0) {
+        clock_gettime(CLOCK_MONOTONIC, &ddl);
+        ddl.tv_sec += timeout / 1000;
+        ddl.tv_nsec += (long)(timeout % 1000) * 1000000;
+        if (ddl.tv_nsec >= 1000000000) {
+            ddl.tv_sec++;
+            ddl.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&dns->mutex);
+
+    for (;;) {
+        ent = EcoDns_FindEnt(dns, name, nameLen, nameHash);
+
+        if (ent != NULL &&
+            ent->stat == EcoDnsEntStat_Done &&
+            NowMs() < ent->expTime) {
+            if (!missed) {
+                dns->hitNum++;
+            }
+
+            ent->useTick = ++dns->entTick;
+
+            if (ent->res == EcoRes_Ok &&
+                ipAry != NULL) {
+                if (*ipNum > ent->ipNum) {
+                    *ipNum = ent->ipNum;
+                }
+
+                memcpy(ipAry, ent->ipAry, sizeof(EcoIpAddr) * *ipNum);
+            }
+
+            res = ent->res;
+            break;
+        }
+
+        /* Queue a lookup for a new or expired name, or wait
+           for a free entry if all of them are in progress. */
+        if (ent == NULL ||
+            ent->stat == EcoDnsEntStat_Done) {
+            res = EcoDns_StartThrds(dns);
+            if (res != EcoRes_Ok) {
+                break;
+            }
+
+            if (ent == NULL) {
+                ent = EcoDns_GetFreeEnt(dns);
+                if (ent != NULL) {
+                    memcpy(ent->nameBuf, name, nameLen);
+                    ent->nameBuf[nameLen] = '\0';
+                    ent->nameLen = nameLen;
+                    ent->nameHash = nameHash;
+                }
+            }
+
+            if (ent != NULL) {
+                ent->stat = EcoDnsEntStat_Queued;
+                ent->useTick = ++dns->entTick;
+
+                pthread_cond_signal(&dns->jobCond);
+            }
+        }
+
+        if (!missed) {
+            dns->missNum++;
+            missed = true;
+        }
+
+        if (!wait) {
+            res = EcoRes_Ok;
+            break;
+        }
+
+        if (timeout == 0) {
+            pthread_cond_wait(&dns->doneCond, &dns->mutex);
+        } else if (pthread_cond_timedwait(&dns->doneCond, &dns->mutex, &ddl) == ETIMEDOUT) {
+            res = EcoRes_Timeout;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&dns->mutex);
+
+    return res;
+}
+
+EcoRes EcoDns_Resolve(EcoDns *dns, const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                      uint32_t timeout) {
+    return EcoDns_Lookup(dns, name, ipAry, ipNum, timeout, true);
+}
+
+EcoRes EcoDns_Prefetch(EcoDns *dns, const char *name) {
+    return EcoDns_Lookup(dns, name, NULL, NULL, 0, false);
+}
+
+void EcoDns_Apply(EcoDns *dns, EcoHttpCli *cli) {
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ResolveHookArg, dns);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ResolveHook, EcoDns_ResolveHook);
+}
+
+EcoRes EcoDns_ResolveHook(const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                          uint32_t timeout, EcoArg arg) {
+    return EcoDns_Resolve((EcoDns *)arg, name, ipAry, ipNum, timeout);
+}
+
+EcoRes EcoDns_LookupHook(const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                         uint32_t *ttl, EcoArg arg) {
+    struct addrinfo *infoList;
+    struct addrinfo hints;
+    size_t ipCap = *ipNum;
+
+    /* getaddrinfo() reports no TTL, so the default one is kept. */
+    (void)ttl;
+    (void)arg;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+
+    if (getaddrinfo(name, NULL, &hints, &infoList) != 0) {
+        return EcoRes_BadResolve;
+    }
+
+    *ipNum = 0;
+
+    for (struct addrinfo *info = infoList;
+         info != NULL && *ipNum < ipCap;
+         info = info->ai_next) {
+        EcoIpAddr ip;
+        bool dup = false;
+
+        memset(&ip, 0, sizeof(ip));
+
+        if (info->ai_family == AF_INET) {
+            ip.ver = EcoIpVer_4;
+            memcpy(ip.buf, &((struct sockaddr_in *)info->ai_addr)->sin_addr, 4);
+        } else if (info->ai_family == AF_INET6) {
+            ip.ver = EcoIpVer_6;
+            memcpy(ip.buf, &((struct sockaddr_in6 *)info->ai_addr)->sin6_addr, 16);
+        } else {
+            continue;
+        }
+
+        for (size_t i = 0; i < *ipNum; i++) {
+            if (memcmp(ipAry + i, &ip, sizeof(ip)) == 0) {
+                dup = true;
+                break;
+            }
+        }
+
+        if (!dup) {
+            ipAry[(*ipNum)++] = ip;
+        }
+    }
+
+    freeaddrinfo(infoList);
+
+    return *ipNum != 0 ? EcoRes_Ok : EcoRes_BadResolve;
+}
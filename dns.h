@@ -0,0 +1,223 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2023 Alex Chen
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __ECHO_DNS_H__
+#define __ECHO_DNS_H__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "echo.h"
+
+typedef enum _EcoDnsOpt {
+
+    /* Time to live (in milliseconds) of resolved addresses,
+       used when the lookup hook doesn't report one. */
+    EcoDnsOpt_Ttl,
+
+    /* Time to live (in milliseconds) of failed lookups. */
+    EcoDnsOpt_NegTtl,
+
+    /* Set the maximum number of cached host names.
+
+       This option will drop all cached host names,
+       and fails if there are lookups in progress. */
+    EcoDnsOpt_CacheCap,
+
+    /* Number of worker threads, which can only
+       be set before the first lookup. */
+    EcoDnsOpt_ThrdNum,
+
+    /* Host name lookup hook, `EcoDns_LookupHook` by default. */
+    EcoDnsOpt_LookupHookArg,
+    EcoDnsOpt_LookupHook,
+} EcoDnsOpt;
+
+/**
+ * @brief Host name lookup hook function, which is called by worker threads.
+ * 
+ * @param name Lowercase host name.
+ * @param ipAry Buffer to store the addresses in order of preference.
+ * @param ipNum Capacity of `ipAry` on input, number of addresses on output.
+ * @param ttl Time to live (in milliseconds) of the addresses, which is
+ *            preset to the default one and can be changed by the hook.
+ * @param arg Extra user data which can be set by option `EcoDnsOpt_LookupHookArg`.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+typedef EcoRes (*EcoDnsLookupHook)(const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                                   uint32_t *ttl, EcoArg arg);
+
+typedef enum _EcoDnsEntStat {
+    EcoDnsEntStat_Queued,
+    EcoDnsEntStat_Busy,
+    EcoDnsEntStat_Done,
+} EcoDnsEntStat;
+
+/* Cached host name. */
+typedef struct _EcoDnsEnt {
+    char nameBuf[ECO_CHAN_NAME_BUF_LEN];
+    size_t nameLen;
+    uint32_t nameHash;
+
+    EcoDnsEntStat stat;
+
+    /* Lookup result, only valid when done. */
+    EcoRes res;
+    EcoIpAddr ipAry[ECO_CHAN_IP_MAX_NUM];
+    size_t ipNum;
+    uint64_t expTime;
+
+    uint64_t useTick;
+} EcoDnsEnt;
+
+/* Host name resolver, which caches addresses and looks
+   up host names on a small pool of worker threads.
+
+   It's thread-safe, so it can be shared by
+   multiple HTTP clients across threads. */
+typedef struct _EcoDns {
+    pthread_mutex_t mutex;
+
+    /* Signaled when a lookup is queued or workers should stop. */
+    pthread_cond_t jobCond;
+
+    /* Signaled when a lookup is done. */
+    pthread_cond_t doneCond;
+
+    EcoDnsEnt *entAry;
+    size_t entCap;
+    size_t entNum;
+    uint64_t entTick;
+
+    pthread_t *thrdAry;
+    size_t thrdNum;
+    size_t thrdCnt;
+    bool stop;
+
+    uint32_t ttl;
+    uint32_t negTtl;
+
+    EcoArg lookupHookArg;
+    EcoDnsLookupHook lookupHook;
+
+    /* Statistics. */
+    uint64_t hitNum;
+    uint64_t missNum;
+} EcoDns;
+
+/**
+ * @brief Initialize a resolver.
+ * @note Worker threads are started by the first lookup.
+ * 
+ * @param dns Resolver.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoDns_Init(EcoDns *dns);
+
+/**
+ * @brief Create a new resolver.
+ */
+EcoDns *EcoDns_New(void);
+
+/**
+ * @brief Deinitialize a resolver.
+ * @note Worker threads are stopped after their current lookups.
+ * 
+ * @param dns Resolver.
+ */
+void EcoDns_Deinit(EcoDns *dns);
+
+/**
+ * @brief Delete a resolver.
+ * 
+ * @param dns Resolver.
+ */
+void EcoDns_Del(EcoDns *dns);
+
+/**
+ * @brief Set a resolver option.
+ * 
+ * @param dns Resolver.
+ * @param opt Option to set.
+ * @param arg Option data to set.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoDns_SetOpt(EcoDns *dns, EcoDnsOpt opt, EcoArg arg);
+
+/**
+ * @brief Resolve a host name, waiting for the lookup if it isn't cached.
+ * @note Concurrent resolving of the same name shares one lookup.
+ * 
+ * @param dns Resolver.
+ * @param name Lowercase host name.
+ * @param ipAry Buffer to store the addresses in order of preference.
+ * @param ipNum Capacity of `ipAry` on input, number of addresses on output.
+ * @param timeout Timeout in milliseconds, 0 means no timeout.
+ * 
+ * @return `EcoRes_Ok` for success, `EcoRes_Timeout` if the timeout
+ *         expires, otherwise an error code.
+ */
+EcoRes EcoDns_Resolve(EcoDns *dns, const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                      uint32_t timeout);
+
+/**
+ * @brief Queue a lookup of the host name without waiting for it.
+ * @note Nothing is queued if the name is cached or being looked up.
+ * 
+ * @param dns Resolver.
+ * @param name Lowercase host name.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoDns_Prefetch(EcoDns *dns, const char *name);
+
+/**
+ * @brief Set the resolving hook of the HTTP client to the resolver.
+ * 
+ * @param dns Resolver.
+ * @param cli HTTP client.
+ */
+void EcoDns_Apply(EcoDns *dns, EcoHttpCli *cli);
+
+/**
+ * @brief Resolving hook of the HTTP client, the
+ *        hook argument must be `EcoDns *`.
+ */
+EcoRes EcoDns_ResolveHook(const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                          uint32_t timeout, EcoArg arg);
+
+/**
+ * @brief Default lookup hook, which uses `getaddrinfo()`.
+ * @note `getaddrinfo()` doesn't report TTL, so the default one is kept.
+ *       Addresses of both versions are kept in the sorted order of `getaddrinfo()`.
+ */
+EcoRes EcoDns_LookupHook(const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                         uint32_t *ttl, EcoArg arg);
+
+#endif
@@ -22,8 +22,10 @@
  * SOFTWARE.
  */
 
+#include <arpa/inet.h>
 #include <stdbool.h>
 #include <strings.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -31,6 +33,11 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <time.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "echo.h"
 #include "conf.h"
@@ -39,12 +46,22 @@
 
 #define SND_CHUNK_LEN_MIN   512
 
+#define RCV_BUF_CAP_MIN     512
+
 
 
 #if ECO_CONF_DEF_SND_CHUNK_LEN < SND_CHUNK_LEN_MIN
     #error "Configuration ECO_CONF_DEF_SND_CHUNK_LEN is too small."
 #endif
 
+#if ECO_CONF_DEF_RCV_BUF_CAP < RCV_BUF_CAP_MIN
+    #error "Configuration ECO_CONF_DEF_RCV_BUF_CAP is too small."
+#endif
+
+#if ECO_CONF_DEF_RCV_BUF_MAX_CAP < ECO_CONF_DEF_RCV_BUF_CAP
+    #error "Configuration ECO_CONF_DEF_RCV_BUF_MAX_CAP is less than ECO_CONF_DEF_RCV_BUF_CAP."
+#endif
+
 
 
 #define ECO_VER_MAJOR_STR   "1"
@@ -92,6 +109,10 @@ const char *EcoRes_ToStr(EcoRes res) {
     case EcoRes_ReachEnd: return "Reach end";
     case EcoRes_NoChanHook: return "No channel hook set";
     case EcoRes_NoReq: return "No request set";
+    case EcoRes_Timeout: return "Deadline exceeded";
+    case EcoRes_BodyTooBig: return "Body too big";
+    case EcoRes_Aborted: return "Aborted";
+    case EcoRes_BadResolve: return "Host name resolution failed";
     default: return "Unknown result";
     }
 }
@@ -152,6 +173,8 @@ void EcoHdrTab_Init(EcoHdrTab *tab) {
     tab->kvpAry = NULL;
     tab->kvpCap = 0;
     tab->kvpNum = 0;
+    tab->slotNum = 0;
+    tab->modCnt = 0;
 }
 
 EcoHdrTab *EcoHdrTab_New(void) {
@@ -167,13 +190,27 @@ EcoHdrTab *EcoHdrTab_New(void) {
     return newTab;
 }
 
+/**
+ * @brief Free the buffers owned by the key-value pair.
+ */
+static void FreeKvp(EcoKvp *kvp) {
+    if (kvp->keyRef == false) {
+        free(kvp->keyBuf);
+    }
+
+    if (kvp->wireKeyOwned) {
+        free(kvp->wireKeyBuf);
+    }
+
+    if (kvp->valRef == false) {
+        free(kvp->valBuf);
+    }
+}
+
 void EcoHdrTab_Deinit(EcoHdrTab *tab) {
     if (tab->kvpAry != NULL) {
-        for (size_t i = 0; i < tab->kvpNum; i++) {
-            EcoKvp *curKvp = tab->kvpAry + i;
-
-            free(curKvp->keyBuf);
-            free(curKvp->valBuf);
+        for (size_t i = 0; i < tab->slotNum; i++) {
+            FreeKvp(tab->kvpAry + i);
         }
 
         free(tab->kvpAry);
@@ -182,6 +219,8 @@ void EcoHdrTab_Deinit(EcoHdrTab *tab) {
 
     tab->kvpCap = 0;
     tab->kvpNum = 0;
+    tab->slotNum = 0;
+    tab->modCnt++;
 }
 
 void EcoHdrTab_Del(EcoHdrTab *tab) {
@@ -204,6 +243,34 @@ static void LowHdrKey(char *keyBuf, size_t keyLen) {
     }
 }
 
+/**
+ * @brief Capitalize the first letter of each word in the header key.
+ */
+static void CapHdrKey(char *keyBuf, size_t keyLen) {
+    bool capNextCh = true;
+
+    for (size_t i = 0; i < keyLen; i++) {
+        char ch = keyBuf[i];
+
+        if (ch >= 'a' &&
+            ch <= 'z') {
+            if (capNextCh) {
+                capNextCh = false;
+
+                keyBuf[i] = ch - 'a' + 'A';
+            }
+        } else if (ch >= 'A' && ch <= 'Z') {
+            if (capNextCh == false) {
+                keyBuf[i] = ch - 'A' + 'a';
+            }
+        } else {
+            if (capNextCh == false) {
+                capNextCh = true;
+            }
+        }
+    }
+}
+
 /**
  * @brief Check if the byte is valid in header key string.
  * 
@@ -321,30 +388,51 @@ static EcoRes EcoHdrTab_FindByBufAndLen(EcoHdrTab *tab, const char *keyBuf,
     return EcoRes_NotFound;
 }
 
+/**
+ * @brief Get the slot for a new key-value pair, which is an unused
+ *        slot if there is any, or a new empty one.
+ */
 static EcoRes EcoHdrTab_GetNextSlot(EcoHdrTab *tab, EcoKvp **kvp) {
-    if (tab->kvpAry == NULL) {
-        tab->kvpAry = (EcoKvp *)malloc(sizeof(EcoKvp) * KVP_ARY_INIT_CAP);
-        if (tab->kvpAry == NULL) {
-            return EcoRes_NoMem;
-        }
+    EcoKvp *newKvp;
 
-        tab->kvpCap = KVP_ARY_INIT_CAP;
-        tab->kvpNum = 0;
+    if (tab->kvpNum < tab->slotNum) {
+        *kvp = tab->kvpAry + tab->kvpNum;
 
-        *kvp = tab->kvpAry;
-    } else {
-        if (tab->kvpNum + 1 > tab->kvpCap) {
-            tab->kvpAry = (EcoKvp *)realloc(tab->kvpAry, sizeof(EcoKvp) * tab->kvpCap * 2);
-            if (tab->kvpAry == NULL) {
-                return EcoRes_NoMem;
-            }
+        return EcoRes_Ok;
+    }
+
+    if (tab->slotNum == tab->kvpCap) {
+        size_t newCap = tab->kvpCap == 0 ? KVP_ARY_INIT_CAP : tab->kvpCap * 2;
+        EcoKvp *newAry;
 
-            tab->kvpCap *= 2;
+        newAry = (EcoKvp *)realloc(tab->kvpAry, sizeof(EcoKvp) * newCap);
+        if (newAry == NULL) {
+            return EcoRes_NoMem;
         }
 
-        *kvp = tab->kvpAry + tab->kvpNum;
+        tab->kvpAry = newAry;
+        tab->kvpCap = newCap;
     }
 
+    newKvp = tab->kvpAry + tab->slotNum;
+
+    newKvp->keyBuf = NULL;
+    newKvp->wireKeyBuf = NULL;
+    newKvp->valBuf = NULL;
+    newKvp->keyLen = 0;
+    newKvp->valLen = 0;
+    newKvp->keyHash = 0;
+    newKvp->keyCap = 0;
+    newKvp->valCap = 0;
+    newKvp->keyRef = false;
+    newKvp->valRef = false;
+    newKvp->wireKeyOwned = false;
+    newKvp->autoGen = false;
+
+    tab->slotNum++;
+
+    *kvp = newKvp;
+
     return EcoRes_Ok;
 }
 
@@ -356,21 +444,42 @@ static EcoRes EcoHdrTab_AddByBufAndLen(EcoHdrTab *tab,
 
     res = EcoHdrTab_FindByBufAndLen(tab, keyBuf, keyLen, &kvp);
     if (res == EcoRes_NotFound) {
-        EcoHdrTab_GetNextSlot(tab, &kvp);
-
-        kvp->keyBuf = (char *)malloc(keyLen + 1);
-        if (kvp->keyBuf == NULL) {
-            return EcoRes_NoMem;
+        res = EcoHdrTab_GetNextSlot(tab, &kvp);
+        if (res != EcoRes_Ok) {
+            return res;
         }
 
-        kvp->valBuf = (char *)malloc(valLen + 1);
-        if (kvp->valBuf == NULL) {
+        /* Leave room for wire-case key. */
+        if (kvp->keyBuf == NULL ||
+            kvp->keyCap < keyLen) {
+            char *newBuf;
+
+            newBuf = (char *)malloc((keyLen + 1) * 2);
+            if (newBuf == NULL) {
+                return EcoRes_NoMem;
+            }
+
             free(kvp->keyBuf);
-            kvp->keyBuf = NULL;
+            kvp->keyBuf = newBuf;
+            kvp->keyCap = keyLen;
+        }
 
-            return EcoRes_NoMem;
+        if (kvp->valBuf == NULL ||
+            kvp->valCap < valLen) {
+            char *newBuf;
+
+            newBuf = (char *)malloc(valLen + 1);
+            if (newBuf == NULL) {
+                return EcoRes_NoMem;
+            }
+
+            free(kvp->valBuf);
+            kvp->valBuf = newBuf;
+            kvp->valCap = valLen;
         }
 
+        kvp->wireKeyBuf = NULL;
+
         memcpy(kvp->keyBuf, keyBuf, keyLen);
         kvp->keyBuf[keyLen] = '\0';
         memcpy(kvp->valBuf, valBuf, valLen);
@@ -383,28 +492,102 @@ static EcoRes EcoHdrTab_AddByBufAndLen(EcoHdrTab *tab,
 
         kvp->keyHash = EcoHash_HashBuf(kvp->keyBuf, kvp->keyLen);;
 
+        kvp->keyRef = false;
+        kvp->valRef = false;
+        kvp->wireKeyOwned = false;
+        kvp->autoGen = false;
+
         tab->kvpNum++;
+        tab->modCnt++;
 
         return EcoRes_Ok;
     } else {
-        char *newBuf;
 
-        newBuf = (char *)malloc(valLen + 1);
-        if (newBuf == NULL) {
-            return EcoRes_NoMem;
-        }
+        /* Overwrite the value in place if it fits. */
+        if (kvp->valRef ||
+            kvp->valCap < valLen) {
+            char *newBuf;
 
-        free(kvp->valBuf);
-        memcpy(newBuf, valBuf, valLen);
-        newBuf[valLen] = '\0';
+            newBuf = (char *)malloc(valLen + 1);
+            if (newBuf == NULL) {
+                return EcoRes_NoMem;
+            }
+
+            if (kvp->valRef == false) {
+                free(kvp->valBuf);
+            }
 
-        kvp->valBuf = newBuf;
+            kvp->valBuf = newBuf;
+            kvp->valCap = valLen;
+        }
+
+        memcpy(kvp->valBuf, valBuf, valLen);
+        kvp->valBuf[valLen] = '\0';
         kvp->valLen = valLen;
 
+        /* User has taken over this header. */
+        kvp->valRef = false;
+        kvp->autoGen = false;
+
+        tab->modCnt++;
+
         return EcoRes_Ok;
     }
 }
 
+/**
+ * @brief Add a header without copying its key and value.
+ * 
+ * @param tab Header table.
+ * @param keyBuf Lowercase key string buffer, which must outlive the table.
+ * @param keyLen Key string length.
+ * @param wireKeyBuf Wire-case key string, which must outlive the table, can be `NULL`.
+ * @param valBuf Null-terminated value string buffer, which must outlive the table.
+ * @param valLen Value string length.
+ * @param autoGen Whether the header is generated by client.
+ */
+static EcoRes EcoHdrTab_AddRefByBufAndLen(EcoHdrTab *tab,
+                                          const char *keyBuf, size_t keyLen,
+                                          const char *wireKeyBuf,
+                                          const char *valBuf, size_t valLen,
+                                          bool autoGen) {
+    EcoKvp *kvp;
+    EcoRes res;
+
+    res = EcoHdrTab_FindByBufAndLen(tab, keyBuf, keyLen, &kvp);
+    if (res == EcoRes_NotFound) {
+        res = EcoHdrTab_GetNextSlot(tab, &kvp);
+        if (res != EcoRes_Ok) {
+            return res;
+        }
+
+        /* Buffers of an unused slot can't be kept by a referencing pair. */
+        FreeKvp(kvp);
+
+        kvp->keyBuf = (char *)keyBuf;
+        kvp->wireKeyBuf = (char *)wireKeyBuf;
+        kvp->keyLen = keyLen;
+        kvp->keyHash = EcoHash_HashBuf(keyBuf, keyLen);
+        kvp->keyCap = 0;
+        kvp->keyRef = true;
+        kvp->wireKeyOwned = false;
+
+        tab->kvpNum++;
+    } else if (kvp->valRef == false) {
+        free(kvp->valBuf);
+    }
+
+    kvp->valBuf = (char *)valBuf;
+    kvp->valCap = 0;
+    kvp->valLen = valLen;
+    kvp->valRef = true;
+    kvp->autoGen = autoGen;
+
+    tab->modCnt++;
+
+    return EcoRes_Ok;
+}
+
 EcoRes EcoHdrTab_Add(EcoHdrTab *tab, const char *key, const char *val) {
     size_t keyLen = strlen(key);
     size_t valLen = strlen(val);
@@ -429,6 +612,32 @@ EcoRes EcoHdrTab_Add(EcoHdrTab *tab, const char *key, const char *val) {
     return EcoRes_Ok;
 }
 
+EcoRes EcoHdrTab_AddStatic(EcoHdrTab *tab, const char *key, const char *val) {
+    size_t keyLen = strlen(key);
+    size_t valLen = strlen(val);
+    EcoRes res;
+
+    res = ChkHdrKey(key, keyLen);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    /* Referenced key can't be lowercased in place. */
+    for (size_t i = 0; i < keyLen; i++) {
+        if (key[i] >= 'A' &&
+            key[i] <= 'Z') {
+            return EcoRes_BadHdrKey;
+        }
+    }
+
+    res = ChkHdrVal(val, valLen);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    return EcoHdrTab_AddRefByBufAndLen(tab, key, keyLen, NULL, val, valLen, false);
+}
+
 EcoRes EcoHdrTab_AddLine(EcoHdrTab *tab, const char *line) {
     typedef enum _FsmStat {
         FsmStat_1stKeyCh,
@@ -583,18 +792,45 @@ Finally:
     return res;
 }
 
+const char *EcoKvp_GetWireKey(EcoKvp *kvp) {
+    if (kvp->wireKeyBuf == NULL) {
+        char *wireKeyBuf;
+
+        if (kvp->keyRef) {
+            wireKeyBuf = (char *)malloc(kvp->keyLen + 1);
+
+            /* Lowercase key is still valid on the wire. */
+            if (wireKeyBuf == NULL) {
+                return kvp->keyBuf;
+            }
+
+            kvp->wireKeyOwned = true;
+        } else {
+            wireKeyBuf = kvp->keyBuf + kvp->keyCap + 1;
+        }
+
+        memcpy(wireKeyBuf, kvp->keyBuf, kvp->keyLen + 1);
+        CapHdrKey(wireKeyBuf, kvp->keyLen);
+
+        kvp->wireKeyBuf = wireKeyBuf;
+    }
+
+    return kvp->wireKeyBuf;
+}
+
 EcoRes EcoHdrTab_Drop(EcoHdrTab *tab, const char *key) {
     EcoKvp *curKvp;
 
     if (EcoHdrTab_Find(tab, key, &curKvp) == EcoRes_NotFound) {
         return EcoRes_NotFound;
     } else {
-        free(curKvp->keyBuf);
-        free(curKvp->valBuf);
+        FreeKvp(curKvp);
 
-        memmove(curKvp, curKvp + 1, sizeof(EcoKvp) * (tab->kvpNum - 1));
+        memmove(curKvp, curKvp + 1, sizeof(EcoKvp) * (tab->slotNum - (size_t)(curKvp - tab->kvpAry) - 1));
 
         tab->kvpNum--;
+        tab->slotNum--;
+        tab->modCnt++;
 
         return EcoRes_Ok;
     }
@@ -604,23 +840,141 @@ void EcoHdrTab_Clear(EcoHdrTab *tab) {
     EcoHdrTab_Deinit(tab);
 }
 
+void EcoHdrTab_Reset(EcoHdrTab *tab) {
+    for (size_t i = 0; i < tab->kvpNum; i++) {
+        EcoKvp *curKvp = tab->kvpAry + i;
+
+        /* Unused slots only keep owned buffers. */
+        if (curKvp->keyRef) {
+            curKvp->keyBuf = NULL;
+            curKvp->keyCap = 0;
+            curKvp->keyRef = false;
+        }
+
+        if (curKvp->wireKeyOwned) {
+            free(curKvp->wireKeyBuf);
+            curKvp->wireKeyOwned = false;
+        }
+
+        curKvp->wireKeyBuf = NULL;
+
+        if (curKvp->valRef) {
+            curKvp->valBuf = NULL;
+            curKvp->valCap = 0;
+            curKvp->valRef = false;
+        }
+
+        curKvp->autoGen = false;
+    }
+
+    tab->kvpNum = 0;
+    tab->modCnt++;
+}
+
 EcoRes EcoHdrTab_Find(EcoHdrTab *tab, const char *key, EcoKvp **kvp) {
     return EcoHdrTab_FindByBufAndLen(tab, key, strlen(key), kvp);
 }
 
+/**
+ * @brief Convert an unsigned integer to decimal string.
+ * @note The string isn't null-terminated.
+ * 
+ * @param buf String buffer, which has room for at least 20 characters.
+ * @param num Unsigned integer.
+ * 
+ * @return Length of the string.
+ */
+static size_t EcoFmt_Dec(char *buf, uint64_t num) {
+    char tmpBuf[20];
+    size_t len = 0;
+
+    do {
+        tmpBuf[len++] = (char)('0' + num % 10);
+        num /= 10;
+    } while (num != 0);
+
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = tmpBuf[len - 1 - i];
+    }
+
+    return len;
+}
+
+/**
+ * @brief Render value of `Host` header for the channel address.
+ * 
+ * @param addr Channel address.
+ */
+static void EcoChanAddr_RenderHost(EcoChanAddr *addr) {
+    size_t len = 0;
+
+    /* Socket path is meaningless to the peer. */
+    if (addr->type == EcoChanAddrType_Unix) {
+        memcpy(addr->hostBuf, "localhost", 10);
+        addr->hostLen = 9;
+
+        return;
+    }
+
+    if (addr->type == EcoChanAddrType_Name) {
+        memcpy(addr->hostBuf, addr->name, addr->nameLen);
+        len = addr->nameLen;
+        addr->hostBuf[len++] = ':';
+    } else if (addr->type == EcoChanAddrType_Ipv6) {
+        addr->hostBuf[len++] = '[';
+        inet_ntop(AF_INET6, addr->addr6, addr->hostBuf + len, INET6_ADDRSTRLEN);
+        len += strlen(addr->hostBuf + len);
+        addr->hostBuf[len++] = ']';
+        addr->hostBuf[len++] = ':';
+    } else {
+        for (int i = 0; i < 4; i++) {
+            len += EcoFmt_Dec(addr->hostBuf + len, addr->addr[i]);
+            addr->hostBuf[len++] = i < 3 ? '.' : ':';
+        }
+    }
+
+    len += EcoFmt_Dec(addr->hostBuf + len, addr->port);
+    addr->hostBuf[len] = '\0';
+    addr->hostLen = len;
+}
+
 void EcoHttpReq_Init(EcoHttpReq *req) {
     req->scheme = ECO_CONF_DEF_SCHEME;
     req->meth = ECO_CONF_DEF_HTTP_METH;
     req->pathBuf = NULL;
+    req->pathCap = 0;
     req->pathLen = 0;
     req->queryBuf = NULL;
+    req->queryCap = 0;
     req->queryLen = 0;
     memcpy(req->chanAddr.addr, ECO_CONF_DEF_IP_ADDR,
            sizeof(req->chanAddr.addr));
+    req->chanAddr.port = ECO_CONF_DEF_HTTP_PORT;
+    req->chanAddr.type = EcoChanAddrType_Ipv4;
+    req->chanAddr.sockPath[0] = '\0';
+    req->chanAddr.sockPathLen = 0;
+    memset(req->chanAddr.addr6, 0, sizeof(req->chanAddr.addr6));
+    req->chanAddr.name[0] = '\0';
+    req->chanAddr.nameLen = 0;
+    req->chanAddr.ipNum = 0;
+    EcoChanAddr_RenderHost(&req->chanAddr);
     req->ver = ECO_CONF_DEF_HTTP_VER;
     req->hdrTab = NULL;
     req->bodyBuf = NULL;
     req->bodyLen = 0;
+    req->formBuf = NULL;
+    req->formCap = 0;
+    req->formLen = 0;
+    req->connTimeout = 0;
+    req->firstByteTimeout = 0;
+    req->totalTimeout = 0;
+    req->contLenBuf[0] = '\0';
+    req->headBuf = NULL;
+    req->headCap = 0;
+    req->headLen = 0;
+    req->headModCnt = 0;
+    req->headKeepAlive = false;
+    req->headValid = false;
 }
 
 EcoHttpReq *EcoHttpReq_New(void) {
@@ -649,7 +1003,51 @@ void EcoHttpReq_Deinit(EcoHttpReq *req) {
         EcoHdrTab_Del(req->hdrTab);
     }
 
+    if (req->formBuf != NULL) {
+        free(req->formBuf);
+    }
+
+    if (req->headBuf != NULL) {
+        free(req->headBuf);
+    }
+
+    EcoHttpReq_Init(req);
+}
+
+void EcoHttpReq_Reset(EcoHttpReq *req) {
+    char *pathBuf = req->pathBuf;
+    size_t pathCap = req->pathCap;
+    char *queryBuf = req->queryBuf;
+    size_t queryCap = req->queryCap;
+    EcoHdrTab *hdrTab = req->hdrTab;
+    char *formBuf = req->formBuf;
+    size_t formCap = req->formCap;
+    uint8_t *headBuf = req->headBuf;
+    size_t headCap = req->headCap;
+
     EcoHttpReq_Init(req);
+
+    if (pathBuf != NULL) {
+        pathBuf[0] = '\0';
+    }
+
+    if (queryBuf != NULL) {
+        queryBuf[0] = '\0';
+    }
+
+    if (hdrTab != NULL) {
+        EcoHdrTab_Reset(hdrTab);
+    }
+
+    req->pathBuf = pathBuf;
+    req->pathCap = pathCap;
+    req->queryBuf = queryBuf;
+    req->queryCap = queryCap;
+    req->hdrTab = hdrTab;
+    req->formBuf = formBuf;
+    req->formCap = formCap;
+    req->headBuf = headBuf;
+    req->headCap = headCap;
 }
 
 void EcoHttpReq_Del(EcoHttpReq *req) {
@@ -658,14 +1056,14 @@ void EcoHttpReq_Del(EcoHttpReq *req) {
     free(req);
 }
 
-#define ECO_URL_SCHEME_MAX_LEN  (8 - 1)
+#define ECO_URL_SCHEME_MAX_LEN  (16 - 1)
 #define ECO_URL_SCHEME_BUF_LEN  (ECO_URL_SCHEME_MAX_LEN + 1)
 
 #define ECO_URL_PATH_MAX_LEN    (1024 - 1)
 #define ECO_URL_PATH_BUF_LEN    (ECO_URL_PATH_MAX_LEN + 1)
 
 #define ECO_URL_QUERY_MAX_LEN   (1024 - 1)
-#define ECO_URL_QUERY_BUF_LEN   (ECO_URL_PATH_MAX_LEN + 1)
+#define ECO_URL_QUERY_BUF_LEN   (ECO_URL_QUERY_MAX_LEN + 1)
 
 /* URL parsing cache. */
 typedef struct _EcoUrlParCac {
@@ -679,6 +1077,22 @@ typedef struct _EcoUrlParCac {
     uint32_t ipv4Buf[4];
     size_t ipv4Len;
 
+    /* IPv6 address. */
+    bool ipv6Set;
+    uint8_t ipv6Buf[16];
+
+    /* Host name (lowercase), which starts at `hostOff` of the URL. */
+    bool nameSet;
+    char nameBuf[ECO_CHAN_NAME_BUF_LEN];
+    size_t nameLen;
+    size_t hostOff;
+
+    /* Unix domain socket path (percent-decoded). */
+    bool sockPathSet;
+    char sockPathBuf[ECO_CHAN_SOCK_PATH_BUF_LEN];
+    size_t sockPathLen;
+    uint8_t pctByte;
+
     /* Port (optional). */
     bool portSet;
     uint32_t port;
@@ -695,22 +1109,37 @@ typedef struct _EcoUrlParCac {
 } EcoUrlParCac;
 
 void EcoUrlParCac_Init(EcoUrlParCac *cache) {
+    /* Buffers are terminated by the parser, so there's
+       no need to clear them. */
     cache->schemeSet = false;
-    memset(cache->schemeBuf, 0, sizeof(cache->schemeBuf));
+    cache->schemeBuf[0] = '\0';
     cache->schemeLen = 0;
 
     memset(cache->ipv4Buf, 0, sizeof(cache->ipv4Buf));
     cache->ipv4Len = 0;
 
+    cache->ipv6Set = false;
+    memset(cache->ipv6Buf, 0, sizeof(cache->ipv6Buf));
+
+    cache->nameSet = false;
+    cache->nameBuf[0] = '\0';
+    cache->nameLen = 0;
+    cache->hostOff = 0;
+
+    cache->sockPathSet = false;
+    cache->sockPathBuf[0] = '\0';
+    cache->sockPathLen = 0;
+    cache->pctByte = 0;
+
     cache->portSet = false;
     cache->port = 0;
 
     cache->pathSet = false;
-    memset(cache->pathBuf, 0, sizeof(cache->pathBuf));
+    cache->pathBuf[0] = '\0';
     cache->pathLen = 0;
 
     cache->querySet = false;
-    memset(cache->queryBuf, 0, sizeof(cache->queryBuf));
+    cache->queryBuf[0] = '\0';
     cache->queryLen = 0;
 }
 
@@ -735,39 +1164,231 @@ void EcoUrlParCac_Del(EcoUrlParCac *cache) {
     free(cache);
 }
 
-EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
-    typedef enum _FsmStat {
-        FsmStat_Start,
-        FsmStat_Scheme1stCh,
-        FsmStat_SchemeOthCh,
-        FsmStat_ColonAfterProto,
-        FsmStat_Slash1AfterProto,
-        FsmStat_Slash2AfterProto,
-        FsmStat_Ipv41stDigit,
-        FsmStat_Ipv4Dot,
-        FsmStat_Ipv4OthDigit,
-        FsmStat_ColonAfterHost,
-        FsmStat_Host1stDigit,
-        FsmStat_HostOthDigit,
-        FsmStat_PathSlash,
-        FsmStat_PathSegCh,
-        FsmStat_QuesAfterPath,
-        FsmStat_Query1stCh,
-        FsmStat_QueryOthCh,
-    } FsmStat;
+/* Classes of URL characters. */
+#define URL_CH_CLS_PATH     0x01    // Allowed in path segment.
+#define URL_CH_CLS_QUERY    0x02    // Allowed in query string.
 
-    FsmStat fsmStat = FsmStat_Start;
-    size_t urlLen = strlen(url);
+static const uint8_t urlChClsTab[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 3, 0, 0, 3, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 0, 3, 0, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 3,
+    0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 3, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
 
-    for (size_t i = 0; i < urlLen; i++) {
-        char ch = url[i];
+#if defined(__SSE2__)
 
-        switch (fsmStat) {
-        case FsmStat_Start:
-        case FsmStat_Scheme1stCh:
-            if ((ch >= 'a' && ch <= 'z') ||
-                (ch >= 'A' && ch <= 'Z')) {
-                cache->schemeSet = true;
+/**
+ * @brief Check 16 characters at once against a range.
+ */
+static inline __m128i UrlChInRange(__m128i chs, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chs, _mm_set1_epi8((char)(lo - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8((char)(hi + 1)), chs));
+}
+
+static inline __m128i UrlChIs(__m128i chs, char ch) {
+    return _mm_cmpeq_epi8(chs, _mm_set1_epi8(ch));
+}
+
+#endif
+
+/**
+ * @brief Get length of the leading run of characters of the given class.
+ * 
+ * @param buf Characters to scan.
+ * @param len Number of characters.
+ * @param cls `URL_CH_CLS_PATH` or `URL_CH_CLS_QUERY`.
+ */
+static size_t UrlScanRun(const char *buf, size_t len, uint8_t cls) {
+    size_t off = 0;
+
+#if defined(__SSE2__)
+    /* Non-ASCII characters are negative, so they are out of all ranges. */
+    for (; off + 16 <= len; off += 16) {
+        __m128i chs = _mm_loadu_si128((const __m128i *)(buf + off));
+        __m128i ok;
+        uint32_t mask;
+
+        ok = _mm_or_si128(UrlChIs(chs, '!'), UrlChIs(chs, '$'));
+        ok = _mm_or_si128(ok, UrlChIs(chs, '='));
+        ok = _mm_or_si128(ok, UrlChIs(chs, '_'));
+        ok = _mm_or_si128(ok, UrlChIs(chs, '~'));
+        ok = _mm_or_si128(ok, UrlChInRange(chs, 'a', 'z'));
+
+        if (cls == URL_CH_CLS_PATH) {
+            ok = _mm_or_si128(ok, UrlChInRange(chs, '&', '.'));
+            ok = _mm_or_si128(ok, UrlChInRange(chs, '0', ':'));
+            ok = _mm_or_si128(ok, UrlChInRange(chs, '@', 'Z'));
+        } else {
+            ok = _mm_or_si128(ok, UrlChInRange(chs, '&', ';'));
+            ok = _mm_or_si128(ok, UrlChInRange(chs, '?', 'Z'));
+        }
+
+        mask = (uint32_t)_mm_movemask_epi8(ok);
+        if (mask != 0xFFFF) {
+            return off + (size_t)__builtin_ctz(~mask);
+        }
+    }
+#endif
+
+    for (; off < len; off++) {
+        if ((urlChClsTab[(uint8_t)buf[off]] & cls) == 0) {
+            break;
+        }
+    }
+
+    return off;
+}
+
+static bool IsHostNameCh(char ch) {
+    return (ch >= 'a' && ch <= 'z') ||
+           (ch >= 'A' && ch <= 'Z') ||
+           (ch >= '0' && ch <= '9') ||
+           ch == '-' ||
+           ch == '_' ||
+           ch == '.';
+}
+
+/**
+ * @brief Check labels of a host name.
+ * @note Last label can't be numeric, otherwise the name
+ *       would be mistaken for a malformed IPv4 address.
+ * 
+ * @param name Host name.
+ * @param len Length of host name.
+ */
+static EcoRes ChkHostName(const char *name, size_t len) {
+    size_t labelLen = 0;
+    bool numeric = true;
+
+    if (len == 0 ||
+        len > 253) {
+        return EcoRes_BadHost;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if (name[i] == '.') {
+            if (labelLen == 0) {
+                return EcoRes_BadHost;
+            }
+
+            labelLen = 0;
+            numeric = true;
+            continue;
+        }
+
+        if (++labelLen > 63) {
+            return EcoRes_BadHost;
+        }
+
+        if (name[i] < '0' || name[i] > '9') {
+            numeric = false;
+        }
+    }
+
+    if (labelLen == 0 ||
+        numeric) {
+        return EcoRes_BadHost;
+    }
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Parse IPv6 address without brackets.
+ * 
+ * @param buf IPv6 address string, which isn't NUL-terminated.
+ * @param len Length of IPv6 address string.
+ * @param addr6 Buffer to store the IPv6 address, 16 bytes long.
+ */
+static EcoRes ParseIpv6(const char *buf, size_t len, uint8_t *addr6) {
+    char tmpBuf[INET6_ADDRSTRLEN];
+
+    if (len == 0 ||
+        len >= sizeof(tmpBuf)) {
+        return EcoRes_BadHost;
+    }
+
+    memcpy(tmpBuf, buf, len);
+    tmpBuf[len] = '\0';
+
+    if (inet_pton(AF_INET6, tmpBuf, addr6) != 1) {
+        return EcoRes_BadHost;
+    }
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Switch from IPv4 address to host name, copying characters seen so far.
+ */
+static EcoRes EcoUrlParCac_StartName(EcoUrlParCac *cache, const char *url, size_t off) {
+    size_t len = off - cache->hostOff;
+
+    if (len > ECO_CHAN_NAME_MAX_LEN) {
+        return EcoRes_BadHost;
+    }
+
+    memcpy(cache->nameBuf, url + cache->hostOff, len);
+    cache->nameLen = len;
+    cache->nameSet = true;
+
+    memset(cache->ipv4Buf, 0, sizeof(cache->ipv4Buf));
+    cache->ipv4Len = 0;
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
+    typedef enum _FsmStat {
+        FsmStat_Start,
+        FsmStat_Scheme1stCh,
+        FsmStat_SchemeOthCh,
+        FsmStat_ColonAfterProto,
+        FsmStat_Slash1AfterProto,
+        FsmStat_Slash2AfterProto,
+        FsmStat_SockPathCh,
+        FsmStat_SockPathPct1stDigit,
+        FsmStat_SockPathPct2ndDigit,
+        FsmStat_Ipv41stDigit,
+        FsmStat_Ipv4Dot,
+        FsmStat_Ipv4OthDigit,
+        FsmStat_HostNameCh,
+        FsmStat_Ipv6Ch,
+        FsmStat_BracketAfterIpv6,
+        FsmStat_ColonAfterHost,
+        FsmStat_Host1stDigit,
+        FsmStat_HostOthDigit,
+        FsmStat_PathSlash,
+        FsmStat_PathSegCh,
+        FsmStat_QuesAfterPath,
+        FsmStat_Query1stCh,
+        FsmStat_QueryOthCh,
+    } FsmStat;
+
+    FsmStat fsmStat = FsmStat_Start;
+    size_t urlLen = strlen(url);
+
+    for (size_t i = 0; i < urlLen; i++) {
+        char ch = url[i];
+
+        switch (fsmStat) {
+        case FsmStat_Start:
+        case FsmStat_Scheme1stCh:
+            if ((ch >= 'a' && ch <= 'z') ||
+                (ch >= 'A' && ch <= 'Z')) {
+                cache->schemeSet = true;
                 cache->schemeBuf[0] = ch;
                 cache->schemeLen = 1;
 
@@ -822,15 +1443,126 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
 
         case FsmStat_Slash1AfterProto:
             if (ch == '/') {
+
+                /* Authority of "http+unix" scheme is a
+                   percent-encoded socket path. */
+                if (strcmp(cache->schemeBuf, "http+unix") == 0) {
+                    cache->sockPathSet = true;
+
+                    fsmStat = FsmStat_SockPathCh;
+                    break;
+                }
+
                 fsmStat = FsmStat_Slash2AfterProto;
                 break;
             }
 
             return EcoRes_BadChar;
 
+        case FsmStat_SockPathCh:
+            if ((ch >= 'a' && ch <= 'z') ||
+                (ch >= 'A' && ch <= 'Z') ||
+                (ch >= '0' && ch <= '9') ||
+                ch == '-' ||
+                ch == '_' ||
+                ch == '.' ||
+                ch == '~' ||
+                ch == '!' ||
+                ch == '$' ||
+                ch == '&' ||
+                ch == '\'' ||
+                ch == '(' ||
+                ch == ')' ||
+                ch == '*' ||
+                ch == '+' ||
+                ch == ',' ||
+                ch == ';' ||
+                ch == '=' ||
+                ch == '@') {
+                if (cache->sockPathLen == ECO_CHAN_SOCK_PATH_MAX_LEN) {
+                    return EcoRes_BadHost;
+                }
+
+                cache->sockPathBuf[cache->sockPathLen] = ch;
+                cache->sockPathLen++;
+
+                break;
+            }
+
+            if (ch == '%') {
+                fsmStat = FsmStat_SockPathPct1stDigit;
+                break;
+            }
+
+            if (ch == '/') {
+                if (cache->sockPathLen == 0) {
+                    return EcoRes_BadHost;
+                }
+
+                cache->sockPathBuf[cache->sockPathLen] = '\0';
+
+                cache->pathSet = true;
+                cache->pathBuf[0] = ch;
+                cache->pathLen = 1;
+
+                fsmStat = FsmStat_PathSegCh;
+                break;
+            }
+
+            return EcoRes_BadChar;
+
+        case FsmStat_SockPathPct1stDigit:
+        case FsmStat_SockPathPct2ndDigit: {
+            uint8_t nibble;
+
+            if (ch >= '0' && ch <= '9') {
+                nibble = ch - '0';
+            } else if (ch >= 'a' && ch <= 'f') {
+                nibble = ch - 'a' + 10;
+            } else if (ch >= 'A' && ch <= 'F') {
+                nibble = ch - 'A' + 10;
+            } else {
+                return EcoRes_BadChar;
+            }
+
+            if (fsmStat == FsmStat_SockPathPct1stDigit) {
+                cache->pctByte = nibble << 4;
+
+                fsmStat = FsmStat_SockPathPct2ndDigit;
+                break;
+            }
+
+            cache->pctByte |= nibble;
+
+            /* NUL character can't be a part of socket path. */
+            if (cache->pctByte == 0) {
+                return EcoRes_BadHost;
+            }
+
+            if (cache->sockPathLen == ECO_CHAN_SOCK_PATH_MAX_LEN) {
+                return EcoRes_BadHost;
+            }
+
+            cache->sockPathBuf[cache->sockPathLen] = (char)cache->pctByte;
+            cache->sockPathLen++;
+
+            fsmStat = FsmStat_SockPathCh;
+            break;
+        }
+
         case FsmStat_Slash2AfterProto:
         case FsmStat_Ipv41stDigit:
         case FsmStat_Ipv4Dot:
+            if (fsmStat == FsmStat_Slash2AfterProto) {
+                cache->hostOff = i;
+
+                /* IPv6 address is enclosed in brackets. */
+                if (ch == '[') {
+                    fsmStat = FsmStat_Ipv6Ch;
+                    break;
+                }
+            }
+
             if (ch >= '0' &&
                 ch <= '9') {
                 cache->ipv4Buf[cache->ipv4Len] = ch - '0';
@@ -839,6 +1571,20 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
                 break;
             }
 
+            /* Letter makes it a host name. */
+            if ((ch >= 'a' && ch <= 'z') ||
+                (ch >= 'A' && ch <= 'Z')) {
+                EcoRes res = EcoUrlParCac_StartName(cache, url, i);
+                if (res != EcoRes_Ok) {
+                    return res;
+                }
+
+                i--;
+
+                fsmStat = FsmStat_HostNameCh;
+                break;
+            }
+
             return EcoRes_BadChar;
 
         case FsmStat_Ipv4OthDigit:
@@ -854,6 +1600,19 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
                 break;
             }
 
+            if ((ch >= 'a' && ch <= 'z') ||
+                (ch >= 'A' && ch <= 'Z')) {
+                EcoRes res = EcoUrlParCac_StartName(cache, url, i);
+                if (res != EcoRes_Ok) {
+                    return res;
+                }
+
+                i--;
+
+                fsmStat = FsmStat_HostNameCh;
+                break;
+            }
+
             if (ch == '.') {
                 if (cache->ipv4Len >= 3) {
                     return EcoRes_BadHost;
@@ -895,6 +1654,95 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
 
             return EcoRes_BadChar;
 
+        case FsmStat_HostNameCh:
+            if (IsHostNameCh(ch)) {
+                if (cache->nameLen == ECO_CHAN_NAME_MAX_LEN) {
+                    return EcoRes_BadHost;
+                }
+
+                if (ch >= 'A' && ch <= 'Z') {
+                    ch += 'a' - 'A';
+                }
+
+                cache->nameBuf[cache->nameLen] = ch;
+                cache->nameLen++;
+
+                break;
+            }
+
+            if (ch == ':' ||
+                ch == '/') {
+                EcoRes res = ChkHostName(cache->nameBuf, cache->nameLen);
+                if (res != EcoRes_Ok) {
+                    return res;
+                }
+
+                cache->nameBuf[cache->nameLen] = '\0';
+
+                if (ch == ':') {
+                    cache->portSet = true;
+
+                    fsmStat = FsmStat_ColonAfterHost;
+                    break;
+                }
+
+                cache->pathSet = true;
+                cache->pathBuf[0] = ch;
+                cache->pathLen = 1;
+
+                fsmStat = FsmStat_PathSegCh;
+                break;
+            }
+
+            return EcoRes_BadChar;
+
+        case FsmStat_Ipv6Ch:
+            if ((ch >= '0' && ch <= '9') ||
+                (ch >= 'a' && ch <= 'f') ||
+                (ch >= 'A' && ch <= 'F') ||
+                ch == ':' ||
+                ch == '.') {
+                if (i - cache->hostOff > INET6_ADDRSTRLEN) {
+                    return EcoRes_BadHost;
+                }
+
+                break;
+            }
+
+            if (ch == ']') {
+                EcoRes res = ParseIpv6(url + cache->hostOff + 1, i - cache->hostOff - 1,
+                                       cache->ipv6Buf);
+                if (res != EcoRes_Ok) {
+                    return res;
+                }
+
+                cache->ipv6Set = true;
+
+                fsmStat = FsmStat_BracketAfterIpv6;
+                break;
+            }
+
+            return EcoRes_BadChar;
+
+        case FsmStat_BracketAfterIpv6:
+            if (ch == ':') {
+                cache->portSet = true;
+
+                fsmStat = FsmStat_ColonAfterHost;
+                break;
+            }
+
+            if (ch == '/') {
+                cache->pathSet = true;
+                cache->pathBuf[0] = ch;
+                cache->pathLen = 1;
+
+                fsmStat = FsmStat_PathSegCh;
+                break;
+            }
+
+            return EcoRes_BadChar;
+
         case FsmStat_ColonAfterHost:
         case FsmStat_Host1stDigit:
             if (ch >= '0' &&
@@ -933,66 +1781,27 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
             return EcoRes_BadChar;
 
         case FsmStat_PathSlash:
-            if ((ch >= 'a' && ch <= 'z') ||
-                (ch >= 'A' && ch <= 'Z') ||
-                (ch >= '0' && ch <= '9') ||
-                ch == '-' ||
-                ch == '_' ||
-                ch == '.' ||
-                ch == '!' ||
-                ch == '~' ||
-                ch == '*' ||
-                ch == '\'' ||
-                ch == '(' ||
-                ch == ')' ||
-                ch == ':' ||
-                ch == '@' ||
-                ch == '&' ||
-                ch == '=' ||
-                ch == '+' ||
-                ch == '$' ||
-                ch == ',') {
-                cache->pathBuf[cache->pathLen] = ch;
-                cache->pathLen++;
+        case FsmStat_PathSegCh: {
+            size_t runLen;
 
-                if (cache->pathLen == ECO_URL_PATH_MAX_LEN) {
+            /* Characters between delimiters are copied in bulk. */
+            runLen = UrlScanRun(url + i, urlLen - i, URL_CH_CLS_PATH);
+            if (runLen != 0) {
+                if (cache->pathLen + runLen >= ECO_URL_PATH_MAX_LEN) {
                     return EcoRes_BadPath;
                 }
 
+                memcpy(cache->pathBuf + cache->pathLen, url + i, runLen);
+                cache->pathLen += runLen;
+                i += runLen - 1;
+
                 fsmStat = FsmStat_PathSegCh;
                 break;
             }
 
-            return EcoRes_BadChar;
-
-        case FsmStat_PathSegCh:
-            if ((ch >= 'a' && ch <= 'z') ||
-                (ch >= 'A' && ch <= 'Z') ||
-                (ch >= '0' && ch <= '9') ||
-                ch == '-' ||
-                ch == '_' ||
-                ch == '.' ||
-                ch == '!' ||
-                ch == '~' ||
-                ch == '*' ||
-                ch == '\'' ||
-                ch == '(' ||
-                ch == ')' ||
-                ch == ':' ||
-                ch == '@' ||
-                ch == '&' ||
-                ch == '=' ||
-                ch == '+' ||
-                ch == '$' ||
-                ch == ',') {
-                cache->pathBuf[cache->pathLen] = ch;
-                cache->pathLen++;
-
-                if (cache->pathLen == ECO_URL_PATH_MAX_LEN) {
-                    return EcoRes_BadPath;
-                }
-
-                break;
+            /* Empty path segment isn't allowed. */
+            if (fsmStat == FsmStat_PathSlash) {
+                return EcoRes_BadChar;
             }
 
             if (ch == '/') {
@@ -1015,71 +1824,31 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
             }
 
             return EcoRes_BadChar;
+        }
 
         case FsmStat_QuesAfterPath:
         case FsmStat_Query1stCh:
-            if ((ch >= 'a' && ch <= 'z') ||
-                (ch >= 'A' && ch <= 'Z') ||
-                (ch >= '0' && ch <= '9') ||
-                ch == ';' ||
-                ch == '/' ||
-                ch == '?' ||
-                ch == ':' ||
-                ch == '@' ||
-                ch == '&' ||
-                ch == '=' ||
-                ch == '+' ||
-                ch == '$' ||
-                ch == ',' ||
-                ch == '-' ||
-                ch == '_' ||
-                ch == '.' ||
-                ch == '!' ||
-                ch == '~' ||
-                ch == '*' ||
-                ch == '\'' ||
-                ch == '(' ||
-                ch == ')' ) {
-                cache->querySet = true;
-                cache->queryBuf[0] = ch;
-                cache->queryLen = 1;
+        case FsmStat_QueryOthCh: {
+            size_t runLen;
 
-                fsmStat = FsmStat_QueryOthCh;
-                break;
+            runLen = UrlScanRun(url + i, urlLen - i, URL_CH_CLS_QUERY);
+            if (runLen == 0) {
+                return EcoRes_BadChar;
             }
 
-            return EcoRes_BadChar;
+            if (cache->queryLen + runLen > ECO_URL_QUERY_MAX_LEN) {
+                return EcoRes_BadQuery;
+            }
 
-        case FsmStat_QueryOthCh:
-            if ((ch >= 'a' && ch <= 'z') ||
-                (ch >= 'A' && ch <= 'Z') ||
-                (ch >= '0' && ch <= '9') ||
-                ch == ';' ||
-                ch == '/' ||
-                ch == '?' ||
-                ch == ':' ||
-                ch == '@' ||
-                ch == '&' ||
-                ch == '=' ||
-                ch == '+' ||
-                ch == '$' ||
-                ch == ',' ||
-                ch == '-' ||
-                ch == '_' ||
-                ch == '.' ||
-                ch == '!' ||
-                ch == '~' ||
-                ch == '*' ||
-                ch == '\'' ||
-                ch == '(' ||
-                ch == ')' ) {
-                cache->queryBuf[cache->queryLen] = ch;
-                cache->queryLen++;
+            memcpy(cache->queryBuf + cache->queryLen, url + i, runLen);
+            cache->queryLen += runLen;
+            i += runLen - 1;
 
-                break;
-            }
+            cache->querySet = true;
 
-            return EcoRes_BadChar;
+            fsmStat = FsmStat_QueryOthCh;
+            break;
+        }
         }
     }
 
@@ -1094,12 +1863,40 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
     case FsmStat_Ipv4Dot:
         return EcoRes_BadFmt;
 
+    case FsmStat_SockPathCh:
+        if (cache->sockPathLen == 0) {
+            return EcoRes_BadFmt;
+        }
+
+        cache->sockPathBuf[cache->sockPathLen] = '\0';
+        break;
+
+    case FsmStat_SockPathPct1stDigit:
+    case FsmStat_SockPathPct2ndDigit:
+        return EcoRes_BadFmt;
+
     case FsmStat_Ipv4OthDigit:
         if (cache->ipv4Len != 3) {
             return EcoRes_BadFmt;
         }
         break;
 
+    case FsmStat_HostNameCh: {
+        EcoRes res = ChkHostName(cache->nameBuf, cache->nameLen);
+        if (res != EcoRes_Ok) {
+            return res;
+        }
+
+        cache->nameBuf[cache->nameLen] = '\0';
+        break;
+    }
+
+    case FsmStat_Ipv6Ch:
+        return EcoRes_BadFmt;
+
+    case FsmStat_BracketAfterIpv6:
+        break;
+
     case FsmStat_ColonAfterHost:
     case FsmStat_Host1stDigit:
         return EcoRes_BadFmt;
@@ -1124,96 +1921,145 @@ EcoRes EcoUrlParCac_ParseUrl(EcoUrlParCac *cache, const char *url) {
     return EcoRes_Ok;
 }
 
-static EcoRes EcoHttpReq_SetOpt_Url(EcoHttpReq *req, const char *url) {
-    EcoChanAddr *addr = &req->chanAddr;
-    EcoUrlParCac *cache;
-    char *pathBuf;
-    char *queryBuf;
-    EcoRes res;
+/**
+ * @brief Make sure the string buffer can hold a string of the given length.
+ * @note Content of the buffer is kept.
+ * 
+ * @param buf String buffer.
+ * @param cap Maximum string length the buffer can hold.
+ * @param len String length to hold.
+ */
+static EcoRes ReserveStrBuf(char **buf, size_t *cap, size_t len) {
+    char *newBuf;
 
-    /* Create URL parsing cache. */
-    cache = EcoUrlParCac_New();
-    if (cache == NULL) {
-        return EcoRes_NoMem;
+    if (*buf != NULL &&
+        *cap >= len) {
+        return EcoRes_Ok;
     }
 
-    /* Parse URL. */
-    res = EcoUrlParCac_ParseUrl(cache, url);
-    if (res != EcoRes_Ok) {
-        goto Finally;
+    newBuf = (char *)realloc(*buf, len + 1);
+    if (newBuf == NULL) {
+        return EcoRes_NoMem;
     }
 
+    *buf = newBuf;
+    *cap = len;
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Get scheme and channel address from a parsed URL.
+ * @note Host of the channel address isn't rendered.
+ * 
+ * @param cache URL parsing cache.
+ * @param scheme Scheme.
+ * @param addr Channel address.
+ */
+static EcoRes EcoUrlParCac_GetAddr(const EcoUrlParCac *cache, EcoScheme *scheme, EcoChanAddr *addr) {
+
     /* Check scheme. */
     if (cache->schemeSet) {
         if (strcmp(cache->schemeBuf, "http") == 0) {
-            req->scheme = EcoScheme_Http;
+            *scheme = EcoScheme_Http;
         } else if (strcmp(cache->schemeBuf, "https") == 0) {
-            req->scheme = EcoScheme_Https;
+            *scheme = EcoScheme_Https;
+        } else if (strcmp(cache->schemeBuf, "http+unix") == 0) {
+            *scheme = EcoScheme_HttpUnix;
         } else {
-            res = EcoRes_BadScheme;
-            goto Finally;
+            return EcoRes_BadScheme;
         }
     } else {
         if (ECO_CONF_DEF_SCHEME == EcoScheme_Https) {
-            req->scheme = EcoScheme_Https;
+            *scheme = EcoScheme_Https;
         } else {
-            req->scheme = EcoScheme_Http;
+            *scheme = EcoScheme_Http;
         }
     }
 
-    /* Copy path and query string. */
-    if (cache->pathSet) {
-        pathBuf = (char *)malloc(cache->pathLen + 1);
-        if (pathBuf == NULL) {
-            res = EcoRes_NoMem;
-            goto Finally;
+    /* Copy socket path, or IP address and port. */
+    if (cache->sockPathSet) {
+        addr->type = EcoChanAddrType_Unix;
+        memcpy(addr->sockPath, cache->sockPathBuf, cache->sockPathLen + 1);
+        addr->sockPathLen = cache->sockPathLen;
+        addr->port = 0;
+    } else {
+        if (cache->nameSet) {
+
+            /* Resolved addresses are filled by the client. */
+            addr->type = EcoChanAddrType_Name;
+            memcpy(addr->name, cache->nameBuf, cache->nameLen + 1);
+            addr->nameLen = cache->nameLen;
+            addr->ipNum = 0;
+        } else if (cache->ipv6Set) {
+            addr->type = EcoChanAddrType_Ipv6;
+            memcpy(addr->addr6, cache->ipv6Buf, 16);
+        } else {
+            addr->type = EcoChanAddrType_Ipv4;
         }
 
-        memcpy(pathBuf, cache->pathBuf, cache->pathLen + 1);
-    }
-    if (cache->querySet) {
-        queryBuf = (char *)malloc(cache->queryLen + 1);
-        if (pathBuf == NULL) {
-            free(pathBuf);
+        addr->addr[0] = (uint8_t)cache->ipv4Buf[0];
+        addr->addr[1] = (uint8_t)cache->ipv4Buf[1];
+        addr->addr[2] = (uint8_t)cache->ipv4Buf[2];
+        addr->addr[3] = (uint8_t)cache->ipv4Buf[3];
 
-            res = EcoRes_NoMem;
-            goto Finally;
+        if (cache->portSet) {
+            addr->port = (uint16_t)cache->port;
+        } else {
+            if (*scheme == EcoScheme_Https) {
+                addr->port = ECO_CONF_DEF_HTTPS_PORT;
+            } else {
+                addr->port = ECO_CONF_DEF_HTTP_PORT;
+            }
         }
+    }
+
+    return EcoRes_Ok;
+}
+
+static EcoRes EcoHttpReq_SetOpt_Url(EcoHttpReq *req, const char *url) {
+    EcoUrlParCac *cache;
+    EcoRes res;
 
-        memcpy(queryBuf, cache->queryBuf, cache->queryLen + 1);
+    /* Create URL parsing cache. */
+    cache = EcoUrlParCac_New();
+    if (cache == NULL) {
+        return EcoRes_NoMem;
     }
 
-    /* Copy IP address and port. */
-    addr->addr[0] = (uint8_t)cache->ipv4Buf[0];
-    addr->addr[1] = (uint8_t)cache->ipv4Buf[1];
-    addr->addr[2] = (uint8_t)cache->ipv4Buf[2];
-    addr->addr[3] = (uint8_t)cache->ipv4Buf[3];
+    /* Parse URL. */
+    res = EcoUrlParCac_ParseUrl(cache, url);
+    if (res != EcoRes_Ok) {
+        goto Finally;
+    }
 
-    if (cache->portSet) {
-        addr->port = (uint16_t)cache->port;
-    } else {
-        if (req->scheme == EcoScheme_Https) {
-            addr->port = ECO_CONF_DEF_HTTPS_PORT;
-        } else {
-            addr->port = ECO_CONF_DEF_HTTP_PORT;
+    /* Reserve room for path and query string. */
+    if (cache->pathSet) {
+        res = ReserveStrBuf(&req->pathBuf, &req->pathCap, cache->pathLen);
+        if (res != EcoRes_Ok) {
+            goto Finally;
         }
     }
+    if (cache->querySet) {
+        res = ReserveStrBuf(&req->queryBuf, &req->queryCap, cache->queryLen);
+        if (res != EcoRes_Ok) {
+            goto Finally;
+        }
+    }
+
+    /* Check scheme, and copy socket path, or IP address and port. */
+    res = EcoUrlParCac_GetAddr(cache, &req->scheme, &req->chanAddr);
+    if (res != EcoRes_Ok) {
+        goto Finally;
+    }
 
     /* Replace path and query string */
     if (cache->pathSet) {
-        if (req->pathBuf != NULL) {
-            free(req->pathBuf);
-        }
-
-        req->pathBuf = pathBuf;
+        memcpy(req->pathBuf, cache->pathBuf, cache->pathLen + 1);
         req->pathLen = cache->pathLen;
     }
     if (cache->querySet) {
-        if (req->queryBuf != NULL) {
-            free(req->queryBuf);
-        }
-
-        req->queryBuf = queryBuf;
+        memcpy(req->queryBuf, cache->queryBuf, cache->queryLen + 1);
         req->queryLen = cache->queryLen;
     }
 
@@ -1225,84 +2071,299 @@ Finally:
     return res;
 }
 
-/**
- * @brief Parse host IPv4 address string.
- * 
- * @param req HTTP request.
- * @param host Host IPv4 address string.
- */
-EcoRes EcoHttpReq_SetOpt_Host(EcoHttpReq *req, const char *host) {
-    typedef enum _FsmStat {
-        FsmStat_1stChInNum,
-        FsmStat_OthChOrDot,
-    } FsmStat;
+void EcoUrl_Init(EcoUrl *url) {
+    url->scheme = ECO_CONF_DEF_SCHEME;
+    memcpy(url->chanAddr.addr, ECO_CONF_DEF_IP_ADDR,
+           sizeof(url->chanAddr.addr));
+    url->chanAddr.port = ECO_CONF_DEF_HTTP_PORT;
+    url->chanAddr.type = EcoChanAddrType_Ipv4;
+    url->chanAddr.sockPath[0] = '\0';
+    url->chanAddr.sockPathLen = 0;
+    memset(url->chanAddr.addr6, 0, sizeof(url->chanAddr.addr6));
+    url->chanAddr.name[0] = '\0';
+    url->chanAddr.nameLen = 0;
+    url->chanAddr.ipNum = 0;
+    EcoChanAddr_RenderHost(&url->chanAddr);
+    url->strBuf = NULL;
+    url->pathOff = 0;
+    url->pathLen = 0;
+    url->queryOff = 0;
+    url->queryLen = 0;
+    url->pathSet = false;
+    url->querySet = false;
+}
 
-    EcoChanAddr *chanAddr = &req->chanAddr;
-    FsmStat fsmStat = FsmStat_1stChInNum;
-    size_t hostLen = strlen(host);
-    int numBuf[4] = {0};
-    int numIdx = 0;
+EcoUrl *EcoUrl_New(void) {
+    EcoUrl *newUrl;
 
-    for (int i = 0; i < hostLen; i++) {
-        char ch = host[i];
+    newUrl = (EcoUrl *)malloc(sizeof(EcoUrl));
+    if (newUrl == NULL) {
+        return NULL;
+    }
 
-        switch (fsmStat) {
-        case FsmStat_1stChInNum:
-            if (ch >= '0' && ch <= '9') {
-                numBuf[numIdx] = ch - '0';
+    EcoUrl_Init(newUrl);
 
-                fsmStat = FsmStat_OthChOrDot;
-                break;
-            }
+    return newUrl;
+}
 
-            return EcoRes_BadChar;
+void EcoUrl_Deinit(EcoUrl *url) {
+    if (url->strBuf != NULL) {
+        free(url->strBuf);
+    }
 
-        case FsmStat_OthChOrDot:
-            if (numBuf[numIdx] == 0) {
-                if (ch == '.') {
-                    numIdx++;
-                    if (numIdx == 4) {
-                        return EcoRes_BadFmt;
-                    }
+    EcoUrl_Init(url);
+}
 
-                    fsmStat = FsmStat_1stChInNum;
-                    break;
-                }
-            } else {
-                if (ch >= '0' && ch <= '9') {
-                    numBuf[numIdx] *= 10;
-                    numBuf[numIdx] += ch - '0';
-                    if (numBuf[numIdx] > 255) {
-                        return EcoRes_BadFmt;
-                    }
+void EcoUrl_Del(EcoUrl *url) {
+    EcoUrl_Deinit(url);
 
-                    break;
-                }
+    free(url);
+}
 
-                if (ch == '.') {
-                    numIdx++;
-                    if (numIdx == 4) {
-                        return EcoRes_BadFmt;
-                    }
+EcoRes EcoUrl_Parse(EcoUrl *url, const char *str) {
+    EcoUrlParCac *cache;
+    EcoChanAddr addr;
+    EcoScheme scheme;
+    char *strBuf;
+    EcoRes res;
 
-                    fsmStat = FsmStat_1stChInNum;
-                    break;
-                }
-            }
+    cache = EcoUrlParCac_New();
+    if (cache == NULL) {
+        return EcoRes_NoMem;
+    }
 
-            return EcoRes_BadChar;
-        }
+    res = EcoUrlParCac_ParseUrl(cache, str);
+    if (res != EcoRes_Ok) {
+        goto Finally;
     }
 
-    if (fsmStat != FsmStat_OthChOrDot ||
-        numIdx != 3) {
-        return EcoRes_BadFmt;
+    res = EcoUrlParCac_GetAddr(cache, &scheme, &addr);
+    if (res != EcoRes_Ok) {
+        goto Finally;
     }
 
-    chanAddr->addr[0] = (uint8_t)numBuf[0];
+    EcoChanAddr_RenderHost(&addr);
+
+    /* Path and query string are laid out back to back. */
+    strBuf = (char *)malloc(cache->pathLen + 1 + cache->queryLen + 1);
+    if (strBuf == NULL) {
+        res = EcoRes_NoMem;
+        goto Finally;
+    }
+
+    memcpy(strBuf, cache->pathBuf, cache->pathLen);
+    strBuf[cache->pathLen] = '\0';
+    memcpy(strBuf + cache->pathLen + 1, cache->queryBuf, cache->queryLen);
+    strBuf[cache->pathLen + 1 + cache->queryLen] = '\0';
+
+    /* URL is kept as is until parsing succeeds. */
+    if (url->strBuf != NULL) {
+        free(url->strBuf);
+    }
+
+    url->scheme = scheme;
+    url->chanAddr = addr;
+    url->strBuf = strBuf;
+    url->pathOff = 0;
+    url->pathLen = cache->pathLen;
+    url->queryOff = cache->pathLen + 1;
+    url->queryLen = cache->queryLen;
+    url->pathSet = cache->pathSet;
+    url->querySet = cache->querySet;
+
+    res = EcoRes_Ok;
+
+Finally:
+    EcoUrlParCac_Del(cache);
+
+    return res;
+}
+
+static EcoRes EcoHttpReq_SetOpt_ParsedUrl(EcoHttpReq *req, const EcoUrl *url) {
+    EcoRes res;
+
+    /* Reserve room for path and query string. */
+    if (url->pathSet) {
+        res = ReserveStrBuf(&req->pathBuf, &req->pathCap, url->pathLen);
+        if (res != EcoRes_Ok) {
+            return res;
+        }
+    }
+    if (url->querySet) {
+        res = ReserveStrBuf(&req->queryBuf, &req->queryCap, url->queryLen);
+        if (res != EcoRes_Ok) {
+            return res;
+        }
+    }
+
+    req->scheme = url->scheme;
+    req->chanAddr = url->chanAddr;
+
+    if (url->pathSet) {
+        memcpy(req->pathBuf, url->strBuf + url->pathOff, url->pathLen + 1);
+        req->pathLen = url->pathLen;
+    }
+    if (url->querySet) {
+        memcpy(req->queryBuf, url->strBuf + url->queryOff, url->queryLen + 1);
+        req->queryLen = url->queryLen;
+    }
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Set host name.
+ * 
+ * @param req HTTP request.
+ * @param host Host name, which contains at least one letter.
+ */
+static EcoRes EcoHttpReq_SetOpt_HostName(EcoHttpReq *req, const char *host) {
+    EcoChanAddr *chanAddr = &req->chanAddr;
+    size_t hostLen = strlen(host);
+    EcoRes res;
+
+    for (size_t i = 0; i < hostLen; i++) {
+        if (!IsHostNameCh(host[i])) {
+            return EcoRes_BadChar;
+        }
+    }
+
+    res = ChkHostName(host, hostLen);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    for (size_t i = 0; i < hostLen; i++) {
+        char ch = host[i];
+
+        if (ch >= 'A' && ch <= 'Z') {
+            ch += 'a' - 'A';
+        }
+
+        chanAddr->name[i] = ch;
+    }
+
+    chanAddr->name[hostLen] = '\0';
+    chanAddr->nameLen = hostLen;
+    chanAddr->ipNum = 0;
+    chanAddr->type = EcoChanAddrType_Name;
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Parse host IPv4 or IPv6 address string, or host name.
+ * 
+ * @param req HTTP request.
+ * @param host Host IPv4 or IPv6 (brackets are optional) address string, or host name.
+ */
+EcoRes EcoHttpReq_SetOpt_Host(EcoHttpReq *req, const char *host) {
+    typedef enum _FsmStat {
+        FsmStat_1stChInNum,
+        FsmStat_OthChOrDot,
+    } FsmStat;
+
+    EcoChanAddr *chanAddr = &req->chanAddr;
+    FsmStat fsmStat = FsmStat_1stChInNum;
+    size_t hostLen = strlen(host);
+    int numBuf[4] = {0};
+    int numIdx = 0;
+
+    /* Any colon makes it an IPv6 address. */
+    if (strchr(host, ':') != NULL) {
+        uint8_t addr6[16];
+        EcoRes res;
+
+        if (host[0] == '[') {
+            if (hostLen < 2 ||
+                host[hostLen - 1] != ']') {
+                return EcoRes_BadFmt;
+            }
+
+            res = ParseIpv6(host + 1, hostLen - 2, addr6);
+        } else {
+            res = ParseIpv6(host, hostLen, addr6);
+        }
+
+        if (res != EcoRes_Ok) {
+            return EcoRes_BadFmt;
+        }
+
+        memcpy(chanAddr->addr6, addr6, 16);
+        chanAddr->type = EcoChanAddrType_Ipv6;
+
+        return EcoRes_Ok;
+    }
+
+    /* Any letter makes it a host name. */
+    for (size_t i = 0; i < hostLen; i++) {
+        if ((host[i] >= 'a' && host[i] <= 'z') ||
+            (host[i] >= 'A' && host[i] <= 'Z')) {
+            return EcoHttpReq_SetOpt_HostName(req, host);
+        }
+    }
+
+    for (int i = 0; i < hostLen; i++) {
+        char ch = host[i];
+
+        switch (fsmStat) {
+        case FsmStat_1stChInNum:
+            if (ch >= '0' && ch <= '9') {
+                numBuf[numIdx] = ch - '0';
+
+                fsmStat = FsmStat_OthChOrDot;
+                break;
+            }
+
+            return EcoRes_BadChar;
+
+        case FsmStat_OthChOrDot:
+            if (numBuf[numIdx] == 0) {
+                if (ch == '.') {
+                    numIdx++;
+                    if (numIdx == 4) {
+                        return EcoRes_BadFmt;
+                    }
+
+                    fsmStat = FsmStat_1stChInNum;
+                    break;
+                }
+            } else {
+                if (ch >= '0' && ch <= '9') {
+                    numBuf[numIdx] *= 10;
+                    numBuf[numIdx] += ch - '0';
+                    if (numBuf[numIdx] > 255) {
+                        return EcoRes_BadFmt;
+                    }
+
+                    break;
+                }
+
+                if (ch == '.') {
+                    numIdx++;
+                    if (numIdx == 4) {
+                        return EcoRes_BadFmt;
+                    }
+
+                    fsmStat = FsmStat_1stChInNum;
+                    break;
+                }
+            }
+
+            return EcoRes_BadChar;
+        }
+    }
+
+    if (fsmStat != FsmStat_OthChOrDot ||
+        numIdx != 3) {
+        return EcoRes_BadFmt;
+    }
+
+    chanAddr->addr[0] = (uint8_t)numBuf[0];
     chanAddr->addr[1] = (uint8_t)numBuf[1];
     chanAddr->addr[2] = (uint8_t)numBuf[2];
     chanAddr->addr[3] = (uint8_t)numBuf[3];
+    chanAddr->type = EcoChanAddrType_Ipv4;
 
     return EcoRes_Ok;
 }
@@ -1315,6 +2376,7 @@ EcoRes EcoHttpReq_SetOpt(EcoHttpReq *req, EcoHttpReqOpt opt, EcoArg arg) {
         switch ((size_t)arg) {
         case EcoScheme_Http:
         case EcoScheme_Https:
+        case EcoScheme_HttpUnix:
             break;
 
         default:
@@ -1333,6 +2395,17 @@ EcoRes EcoHttpReq_SetOpt(EcoHttpReq *req, EcoHttpReqOpt opt, EcoArg arg) {
 
         break;
 
+    case EcoHttpReqOpt_ParsedUrl:
+        res = EcoHttpReq_SetOpt_ParsedUrl(req, (const EcoUrl *)arg);
+        if (res != EcoRes_Ok) {
+            return res;
+        }
+
+        /* Host has been rendered when the URL was parsed. */
+        req->headValid = false;
+
+        return EcoRes_Ok;
+
     case EcoHttpReqOpt_Host:
         res = EcoHttpReq_SetOpt_Host(req, (char *)arg);
         if (res != EcoRes_Ok) {
@@ -1343,80 +2416,58 @@ EcoRes EcoHttpReq_SetOpt(EcoHttpReq *req, EcoHttpReqOpt opt, EcoArg arg) {
 
     case EcoHttpReqOpt_Addr:
         memcpy(req->chanAddr.addr, (uint8_t *)arg, 4);
+        req->chanAddr.type = EcoChanAddrType_Ipv4;
         break;
 
     case EcoHttpReqOpt_Port:
         req->chanAddr.port = (uint16_t)(size_t)arg;
         break;
 
-    case EcoHttpReqOpt_Path: {
-        size_t pathLen;
-        char *pathBuf;
+    case EcoHttpReqOpt_Path:
+    case EcoHttpReqOpt_Query: {
+        char **bufPtr = opt == EcoHttpReqOpt_Path ? &req->pathBuf : &req->queryBuf;
+        size_t *capPtr = opt == EcoHttpReqOpt_Path ? &req->pathCap : &req->queryCap;
+        size_t *lenPtr = opt == EcoHttpReqOpt_Path ? &req->pathLen : &req->queryLen;
+        size_t len;
 
         // TODO: I probably should parse not simply copy it :(
 
-        /* If `arg` is NULL or it's empty string, set path string to empty. */
-        if (arg == NULL || (pathLen = strlen((char *)arg)) == 0) {
-            if (req->pathBuf != NULL) {
-                free(req->pathBuf);
-                req->pathBuf = NULL;
+        /* If `arg` is NULL or it's empty string, set the string to empty. */
+        if (arg == NULL || (len = strlen((char *)arg)) == 0) {
+            if (*bufPtr != NULL) {
+                (*bufPtr)[0] = '\0';
             }
 
-            req->pathLen = 0;
+            *lenPtr = 0;
 
             break;
         }
 
-        /* Create a new string for storing path string. */
-        pathBuf = (char *)malloc(pathLen + 1);
-        if (pathBuf == NULL) {
-            return EcoRes_NoMem;
-        }
-
-        memcpy(pathBuf, arg, pathLen + 1);
-
-        if (req->pathBuf != NULL) {
-            free(req->pathBuf);
+        /* Buffer is reused if it's large enough. */
+        res = ReserveStrBuf(bufPtr, capPtr, len);
+        if (res != EcoRes_Ok) {
+            return res;
         }
 
-        req->pathBuf = pathBuf;
-        req->pathLen = pathLen;
+        memcpy(*bufPtr, arg, len + 1);
+        *lenPtr = len;
 
         break;
     }
 
-    case EcoHttpReqOpt_Query: {
-        size_t queryLen;
-        char *queryBuf;
-
-        // TODO: I probably should parse not simply copy it :(
-
-        /* If `arg` is NULL or it's empty string, set query string to empty. */
-        if (arg == NULL || (queryLen = strlen((char *)arg)) == 0) {
-            if (req->queryBuf != NULL) {
-                free(req->queryBuf);
-                req->queryBuf = NULL;
-            }
-
-            req->queryLen = 0;
-
-            break;
-        }
-
-        /* Create a new string for storing query string. */
-        queryBuf = (char *)malloc(queryLen + 1);
-        if (queryBuf == NULL) {
-            return EcoRes_NoMem;
-        }
-
-        memcpy(queryBuf, arg, queryLen + 1);
+    case EcoHttpReqOpt_SockPath: {
+        size_t pathLen;
 
-        if (req->queryBuf != NULL) {
-            free(req->queryBuf);
+        if (arg == NULL ||
+            (pathLen = strlen((char *)arg)) == 0 ||
+            pathLen > ECO_CHAN_SOCK_PATH_MAX_LEN) {
+            return EcoRes_BadArg;
         }
 
-        req->queryBuf = queryBuf;
-        req->queryLen = queryLen;
+        memcpy(req->chanAddr.sockPath, arg, pathLen + 1);
+        req->chanAddr.sockPathLen = pathLen;
+        req->chanAddr.type = EcoChanAddrType_Unix;
+        req->scheme = EcoScheme_HttpUnix;
 
         break;
     }
@@ -1444,10 +2495,184 @@ EcoRes EcoHttpReq_SetOpt(EcoHttpReq *req, EcoHttpReqOpt opt, EcoArg arg) {
         req->bodyLen = (size_t)arg;
         break;
 
+    /* Deadlines don't appear in the request head,
+       so the cached one is still valid. */
+    case EcoHttpReqOpt_ConnTimeout:
+        req->connTimeout = (uint32_t)(size_t)arg;
+        return EcoRes_Ok;
+
+    case EcoHttpReqOpt_FirstByteTimeout:
+        req->firstByteTimeout = (uint32_t)(size_t)arg;
+        return EcoRes_Ok;
+
+    case EcoHttpReqOpt_TotalTimeout:
+        req->totalTimeout = (uint32_t)(size_t)arg;
+        return EcoRes_Ok;
+
     default:
         return EcoRes_BadOpt;
     }
 
+    /* Address may have been changed. */
+    EcoChanAddr_RenderHost(&req->chanAddr);
+
+    req->headValid = false;
+
+    return EcoRes_Ok;
+}
+
+/* Characters kept as is when percent-encoding, with
+   space encoded as '+'; others map to 0. */
+static const char pctEncTab[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    '+', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '-', '.', 0,
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 0, 0, 0, 0, 0, 0,
+    0, 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O',
+    'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 0, 0, 0, 0, '_',
+    0, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
+    'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', 0, 0, 0, '~', 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+/**
+ * @brief Get length of the percent-encoded string.
+ */
+static size_t PctEncLen(const char *str) {
+    size_t len = 0;
+
+    for (; *str != '\0'; str++) {
+        len += pctEncTab[(uint8_t)*str] != 0 ? 1 : 3;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Percent-encode a string into the buffer, which must be large enough.
+ * 
+ * @return Length of the encoded string.
+ */
+static size_t PctEnc(char *buf, const char *str) {
+    static const char hexChTab[] = "0123456789ABCDEF";
+    size_t len = 0;
+
+    for (; *str != '\0'; str++) {
+        uint8_t byte = (uint8_t)*str;
+
+        if (pctEncTab[byte] != 0) {
+            buf[len++] = pctEncTab[byte];
+        } else {
+            buf[len++] = '%';
+            buf[len++] = hexChTab[byte >> 4];
+            buf[len++] = hexChTab[byte & 0x0F];
+        }
+    }
+
+    return len;
+}
+
+/**
+ * @brief Make sure the string buffer can hold a string of the given length,
+ *        growing it geometrically so that repeated appending is cheap.
+ * @note Content of the buffer is kept.
+ */
+static EcoRes GrowStrBuf(char **buf, size_t *cap, size_t len) {
+    size_t newCap;
+
+    if (*buf != NULL &&
+        *cap >= len) {
+        return EcoRes_Ok;
+    }
+
+    newCap = *buf != NULL ? *cap * 2 : 0;
+    if (newCap < len) {
+        newCap = len;
+    }
+
+    return ReserveStrBuf(buf, cap, newCap);
+}
+
+/**
+ * @brief Append a "key=value" pair to a form-urlencoded string.
+ * 
+ * @param buf String buffer.
+ * @param cap Maximum string length the buffer can hold.
+ * @param len String length.
+ * @param key Key string.
+ * @param val Value string.
+ */
+static EcoRes AppendFormParam(char **buf, size_t *cap, size_t *len, const char *key, const char *val) {
+    size_t newLen = *len;
+    EcoRes res;
+
+    if (key == NULL ||
+        val == NULL ||
+        key[0] == '\0') {
+        return EcoRes_BadArg;
+    }
+
+    /* Length is measured first so that encoding goes
+       straight into the buffer. */
+    newLen += (*len != 0 ? 1 : 0) + PctEncLen(key) + 1 + PctEncLen(val);
+
+    res = GrowStrBuf(buf, cap, newLen);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    if (*len != 0) {
+        (*buf)[(*len)++] = '&';
+    }
+
+    *len += PctEnc(*buf + *len, key);
+    (*buf)[(*len)++] = '=';
+    *len += PctEnc(*buf + *len, val);
+    (*buf)[*len] = '\0';
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoHttpReq_AddQueryParam(EcoHttpReq *req, const char *key, const char *val) {
+    EcoRes res;
+
+    res = AppendFormParam(&req->queryBuf, &req->queryCap, &req->queryLen, key, val);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    req->headValid = false;
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoHttpReq_AddFormParam(EcoHttpReq *req, const char *key, const char *val) {
+    EcoRes res;
+
+    /* Form is started over if body has been replaced. */
+    if (req->formBuf == NULL ||
+        req->bodyBuf != (uint8_t *)req->formBuf) {
+        req->formLen = 0;
+    }
+
+    res = AppendFormParam(&req->formBuf, &req->formCap, &req->formLen, key, val);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    /* Buffer may have been moved. */
+    req->bodyBuf = (uint8_t *)req->formBuf;
+    req->bodyLen = req->formLen;
+
+    req->headValid = false;
+
     return EcoRes_Ok;
 }
 
@@ -1457,7 +2682,9 @@ void EcoHttpRsp_Init(EcoHttpRsp *rsp) {
     rsp->hdrTab = NULL;
     rsp->contLen = 0;
     rsp->bodyBuf = NULL;
+    rsp->bodyCap = 0;
     rsp->bodyLen = 0;
+    rsp->bodyRef = false;
 }
 
 EcoHttpRsp *EcoHttpRsp_New(void) {
@@ -1484,11 +2711,26 @@ void EcoHttpRsp_Deinit(EcoHttpRsp *rsp) {
 
     rsp->contLen = 0;
 
-    if (rsp->bodyBuf != NULL) {
+    if (rsp->bodyBuf != NULL &&
+        rsp->bodyRef == false) {
         free(rsp->bodyBuf);
-        rsp->bodyBuf = NULL;
     }
 
+    rsp->bodyBuf = NULL;
+    rsp->bodyCap = 0;
+    rsp->bodyLen = 0;
+    rsp->bodyRef = false;
+}
+
+void EcoHttpRsp_Reset(EcoHttpRsp *rsp) {
+    rsp->ver = EcoHttpVer_Unknown;
+    rsp->statCode = EcoStatCode_Unknown;
+
+    if (rsp->hdrTab != NULL) {
+        EcoHdrTab_Reset(rsp->hdrTab);
+    }
+
+    rsp->contLen = 0;
     rsp->bodyLen = 0;
 }
 
@@ -1502,10 +2744,20 @@ void EcoHttpCli_Init(EcoHttpCli *cli) {
     cli->req = NULL;
     cli->rsp = NULL;
 
+    cli->parseCache = NULL;
+
     cli->sndChunkBuf = NULL;
     cli->sndChunkCap = ECO_CONF_DEF_SND_CHUNK_LEN;
     cli->sndChunkLen = 0;
 
+    cli->rcvBuf = NULL;
+    cli->rcvBufCap = ECO_CONF_DEF_RCV_BUF_CAP;
+    cli->rcvBufMinCap = ECO_CONF_DEF_RCV_BUF_CAP;
+    cli->rcvBufMaxCap = ECO_CONF_DEF_RCV_BUF_MAX_CAP;
+    cli->rcvPeakLen = 0;
+    cli->rcvBufOff = 0;
+    cli->rcvBufLen = 0;
+
     cli->chanHookArg = NULL;
     cli->chanOpenHook = NULL;
     cli->chanCloseHook = NULL;
@@ -1522,8 +2774,43 @@ void EcoHttpCli_Init(EcoHttpCli *cli) {
     cli->bodyHookArg = NULL;
     cli->bodyWriteHook = NULL;
 
+    cli->rspStatHookArg = NULL;
+    cli->rspStatHook = NULL;
+
+    cli->rspHdrLineHookArg = NULL;
+    cli->rspHdrLineHook = NULL;
+    cli->resolveHookArg = NULL;
+    cli->resolveHook = NULL;
+
+    cli->bodyBuf = NULL;
+    cli->bodyCap = 0;
+    cli->bodyOverflow = EcoBodyOverflow_Fail;
+
+    cli->drainMaxLen = ECO_CONF_DEF_DRAIN_MAX_LEN;
+    cli->drainTimeout = ECO_CONF_DEF_DRAIN_TIMEOUT;
+
+    cli->rspHdrFilterTab = NULL;
+    cli->rspHdrFilter = EcoHdrFilter_None;
+
+    cli->connDdl = 0;
+    cli->firstByteDdl = 0;
+    cli->totalDdl = 0;
+
+    memset(&cli->stats, 0, sizeof(cli->stats));
+    cli->stats.rcvBufCap = ECO_CONF_DEF_RCV_BUF_CAP;
+
     cli->chanOpened = false;
     cli->keepAlive = false;
+    cli->reuseRsp = false;
+    cli->rcvBufFull = false;
+    cli->pullBody = false;
+    cli->bodyPending = false;
+    cli->bodyPaused = false;
+    cli->lenientParse = false;
+
+    /* State of the channel is unknown until the first push. */
+    cli->connBudgetSet = true;
+    cli->rwBudgetSet = true;
 }
 
 EcoHttpCli *EcoHttpCli_New(void) {
@@ -1555,10 +2842,22 @@ void EcoHttpCli_Deinit(EcoHttpCli *cli) {
         EcoHttpRsp_Del(cli->rsp);
     }
 
+    if (cli->rspHdrFilterTab != NULL) {
+        EcoHdrTab_Del(cli->rspHdrFilterTab);
+    }
+
     if (cli->sndChunkBuf != NULL) {
         free(cli->sndChunkBuf);
     }
 
+    if (cli->rcvBuf != NULL) {
+        free(cli->rcvBuf);
+    }
+
+    if (cli->parseCache != NULL) {
+        free(cli->parseCache);
+    }
+
     EcoHttpCli_Init(cli);
 }
 
@@ -1572,6 +2871,8 @@ EcoRes EcoHttpCli_SetOpt(EcoHttpCli *cli, EcoHttpCliOpt opt, EcoArg arg) {
     switch (opt) {
     case EcoHttpCliOpt_ChanHookArg:
         cli->chanHookArg = arg;
+        cli->connBudgetSet = true;
+        cli->rwBudgetSet = true;
         break;
 
     case EcoHttpCliOpt_ChanOpenHook:
@@ -1584,6 +2885,8 @@ EcoRes EcoHttpCli_SetOpt(EcoHttpCli *cli, EcoHttpCliOpt opt, EcoArg arg) {
 
     case EcoHttpCliOpt_ChanSetOptHook:
         cli->chanSetOptHook = (EcoChanSetOptHook)arg;
+        cli->connBudgetSet = true;
+        cli->rwBudgetSet = true;
         break;
 
     case EcoHttpCliOpt_ChanReadHook:
@@ -1618,10 +2921,60 @@ EcoRes EcoHttpCli_SetOpt(EcoHttpCli *cli, EcoHttpCliOpt opt, EcoArg arg) {
         cli->bodyWriteHook = (EcoBodyWriteHook)arg;
         break;
 
+    case EcoHttpCliOpt_RspStatHookArg:
+        cli->rspStatHookArg = arg;
+        break;
+
+    case EcoHttpCliOpt_RspStatHook:
+        cli->rspStatHook = (EcoRspStatHook)arg;
+        break;
+
+    case EcoHttpCliOpt_RspHdrLineHookArg:
+        cli->rspHdrLineHookArg = arg;
+        break;
+
+    case EcoHttpCliOpt_RspHdrLineHook:
+        cli->rspHdrLineHook = (EcoRspHdrLineHook)arg;
+        break;
+
+    case EcoHttpCliOpt_ResolveHookArg:
+        cli->resolveHookArg = arg;
+        break;
+
+    case EcoHttpCliOpt_ResolveHook:
+        cli->resolveHook = (EcoResolveHook)arg;
+        break;
+
     case EcoHttpCliOpt_KeepAlive:
         cli->keepAlive = (size_t)arg ? true : false;
         break;
 
+    case EcoHttpCliOpt_ReuseRsp:
+        cli->reuseRsp = (size_t)arg ? true : false;
+        break;
+
+    case EcoHttpCliOpt_BodyBuf:
+        cli->bodyBuf = (uint8_t *)arg;
+        break;
+
+    case EcoHttpCliOpt_BodyCap:
+        cli->bodyCap = (size_t)arg;
+        break;
+
+    case EcoHttpCliOpt_BodyOverflow:
+        switch ((size_t)arg) {
+        case EcoBodyOverflow_Fail:
+        case EcoBodyOverflow_Stream:
+        case EcoBodyOverflow_Grow:
+            break;
+
+        default:
+            return EcoRes_BadArg;
+        }
+
+        cli->bodyOverflow = (EcoBodyOverflow)(size_t)arg;
+        break;
+
     case EcoHttpCliOpt_Request:
         if (cli->req != NULL) {
             EcoHttpReq_Del(cli->req);
@@ -1660,6 +3013,80 @@ EcoRes EcoHttpCli_SetOpt(EcoHttpCli *cli, EcoHttpCliOpt opt, EcoArg arg) {
         break;
     }
 
+    case EcoHttpCliOpt_RcvBufCap: {
+        size_t newBufCap = (size_t)arg;
+
+        if (newBufCap < RCV_BUF_CAP_MIN) {
+            return EcoRes_BadArg;
+        }
+
+        /* Body bytes received with the head are still
+           in the buffer until the body is finished. */
+        if (cli->bodyPending || cli->bodyPaused) {
+            return EcoRes_Again;
+        }
+
+        /* The buffer will be allocated with the new
+           capacity when it's used next time. */
+        if (cli->rcvBuf != NULL) {
+            free(cli->rcvBuf);
+            cli->rcvBuf = NULL;
+        }
+
+        cli->rcvBufCap = newBufCap;
+        cli->rcvBufMinCap = newBufCap;
+        if (cli->rcvBufMaxCap < newBufCap) {
+            cli->rcvBufMaxCap = newBufCap;
+        }
+
+        cli->stats.rcvBufCap = newBufCap;
+
+        break;
+    }
+
+    case EcoHttpCliOpt_RcvBufMaxCap: {
+        size_t newMaxCap = (size_t)arg;
+
+        if (newMaxCap < cli->rcvBufMinCap) {
+            return EcoRes_BadArg;
+        }
+
+        cli->rcvBufMaxCap = newMaxCap;
+
+        break;
+    }
+
+    case EcoHttpCliOpt_PullBody:
+        cli->pullBody = (arg != NULL);
+        break;
+
+    case EcoHttpCliOpt_DrainMaxLen:
+        cli->drainMaxLen = (size_t)arg;
+        break;
+
+    case EcoHttpCliOpt_DrainTimeout:
+        cli->drainTimeout = (uint64_t)(size_t)arg;
+        break;
+
+    case EcoHttpCliOpt_RspHdrFilter:
+        if ((EcoHdrFilter)(size_t)arg > EcoHdrFilter_Deny) {
+            return EcoRes_BadArg;
+        }
+
+        cli->rspHdrFilter = (EcoHdrFilter)(size_t)arg;
+        break;
+
+    case EcoHttpCliOpt_RspHdrFilterTab:
+        if (cli->rspHdrFilterTab != NULL) {
+            EcoHdrTab_Del(cli->rspHdrFilterTab);
+        }
+        cli->rspHdrFilterTab = (EcoHdrTab *)arg;
+        break;
+
+    case EcoHttpCliOpt_LenientParse:
+        cli->lenientParse = (arg != NULL);
+        break;
+
     default:
         return EcoRes_BadOpt;
     }
@@ -1667,9 +3094,56 @@ EcoRes EcoHttpCli_SetOpt(EcoHttpCli *cli, EcoHttpCliOpt opt, EcoArg arg) {
     return EcoRes_Ok;
 }
 
+void EcoHttpCli_GetChanHooks(EcoHttpCli *cli, EcoChanHooks *hooks) {
+    hooks->arg = cli->chanHookArg;
+    hooks->openHook = cli->chanOpenHook;
+    hooks->closeHook = cli->chanCloseHook;
+    hooks->setOptHook = cli->chanSetOptHook;
+    hooks->readHook = cli->chanReadHook;
+    hooks->writeHook = cli->chanWriteHook;
+}
+
+void EcoHttpCli_SetChanHooks(EcoHttpCli *cli, const EcoChanHooks *hooks) {
+    cli->chanHookArg = hooks->arg;
+    cli->chanOpenHook = hooks->openHook;
+    cli->chanCloseHook = hooks->closeHook;
+    cli->chanSetOptHook = hooks->setOptHook;
+    cli->chanReadHook = hooks->readHook;
+    cli->chanWriteHook = hooks->writeHook;
+
+    cli->connBudgetSet = true;
+    cli->rwBudgetSet = true;
+}
+
+/**
+ * @brief Generate a header unless user has set it.
+ * @note Both key and value are referenced, so this doesn't allocate
+ *       memory once the header table has room for the header.
+ * 
+ * @param tab Header table.
+ * @param key Lowercase key string.
+ * @param wireKey Wire-case key string.
+ * @param valBuf Value string buffer.
+ * @param valLen Value string length.
+ */
+static EcoRes EcoCli_AutoGenHdr(EcoHdrTab *tab, const char *key, const char *wireKey,
+                                const char *valBuf, size_t valLen) {
+    size_t keyLen = strlen(key);
+    EcoKvp *kvp;
+
+    if (EcoHdrTab_FindByBufAndLen(tab, key, keyLen, &kvp) == EcoRes_Ok &&
+        kvp->autoGen == false) {
+        return EcoRes_Ok;
+    }
+
+    return EcoHdrTab_AddRefByBufAndLen(tab, key, keyLen, wireKey, valBuf, valLen, true);
+}
+
 static EcoRes EcoCli_AutoGenHdrs(EcoHttpCli *cli) {
     EcoHttpReq *req = cli->req;
     EcoChanAddr *chanAddr = &req->chanAddr;
+    EcoKvp *kvp;
+    size_t len;
     EcoRes res;
 
     /* If request header table is not created yet, create it. */
@@ -1680,113 +3154,290 @@ static EcoRes EcoCli_AutoGenHdrs(EcoHttpCli *cli) {
         }
     }
 
-    res = EcoHdrTab_Find(req->hdrTab, "host", NULL);
-    if (res == EcoRes_NotFound) {
-        res = EcoHdrTab_AddFmt(req->hdrTab, "host", "%u.%u.%u.%u:%u",
-                               chanAddr->addr[0], chanAddr->addr[1],
-                               chanAddr->addr[2], chanAddr->addr[3],
-                               chanAddr->port);
+    res = EcoCli_AutoGenHdr(req->hdrTab, "host", "Host",
+                            chanAddr->hostBuf, chanAddr->hostLen);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    res = EcoCli_AutoGenHdr(req->hdrTab, "user-agent", "User-Agent",
+                            ECO_USER_AGENT_STR, sizeof(ECO_USER_AGENT_STR) - 1);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    len = EcoFmt_Dec(req->contLenBuf, req->bodyLen);
+    req->contLenBuf[len] = '\0';
+
+    res = EcoCli_AutoGenHdr(req->hdrTab, "content-length", "Content-Length",
+                            req->contLenBuf, len);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    /* Body built by `EcoHttpReq_AddFormParam` is form-urlencoded. */
+    if (req->formBuf != NULL &&
+        req->bodyBuf == (uint8_t *)req->formBuf) {
+        res = EcoCli_AutoGenHdr(req->hdrTab, "content-type", "Content-Type",
+                                "application/x-www-form-urlencoded", 33);
         if (res != EcoRes_Ok) {
             return res;
         }
+    } else if (EcoHdrTab_Find(req->hdrTab, "content-type", &kvp) == EcoRes_Ok &&
+               kvp->autoGen) {
+        EcoHdrTab_Drop(req->hdrTab, "content-type");
     }
 
-    res = EcoHdrTab_Find(req->hdrTab, "user-agent", NULL);
-    if (res == EcoRes_NotFound) {
-        res = EcoHdrTab_AddFmt(req->hdrTab, "user-agent", ECO_USER_AGENT_STR);
+    /* If keep-alive is enabled, make sure request
+       has `Connection: keep-alive` header. */
+    if (cli->keepAlive) {
+        res = EcoCli_AutoGenHdr(req->hdrTab, "connection", "Connection",
+                                "keep-alive", 10);
         if (res != EcoRes_Ok) {
             return res;
         }
+    } else if (EcoHdrTab_Find(req->hdrTab, "connection", &kvp) == EcoRes_Ok &&
+               kvp->autoGen) {
+        EcoHdrTab_Drop(req->hdrTab, "connection");
     }
 
-    res = EcoHdrTab_Find(req->hdrTab, "content-length", NULL);
-    if (res == EcoRes_NotFound) {
-        res = EcoHdrTab_AddFmt(req->hdrTab, "content-length", "%zu", req->bodyLen);
-        if (res != EcoRes_Ok) {
-            return res;
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Get the current time of the monotonic clock in milliseconds.
+ */
+static uint64_t EcoTime_NowMs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Get the earlier one of two deadlines.
+ * @note Deadline 0 means no deadline.
+ */
+static uint64_t EarlierDdl(uint64_t ddl1, uint64_t ddl2) {
+    if (ddl1 == 0) {
+        return ddl2;
+    }
+
+    if (ddl2 == 0) {
+        return ddl1;
+    }
+
+    return ddl1 < ddl2 ? ddl1 : ddl2;
+}
+
+/**
+ * @brief Check if the deadline has expired.
+ * @note Deadline 0 never expires.
+ */
+static bool IsDdlExpired(uint64_t ddl) {
+    return ddl != 0 && EcoTime_NowMs() >= ddl;
+}
+
+/**
+ * @brief Push the remaining budget before the deadline into the channel.
+ * @note Channel that doesn't support the option is not treated as an error,
+ *       the deadline will still be checked after each channel operation.
+ * @note Without deadline, budget 0 is pushed once to clear the bounded
+ *       budget that a previous push may have left in the channel.
+ * 
+ * @param cli HTTP client.
+ * @param opt Channel option used to carry the budget.
+ * @param ddl Deadline, 0 means no deadline.
+ */
+static EcoRes EcoCli_PushDdl(EcoHttpCli *cli, EcoChanOpt opt, uint64_t ddl) {
+    uint64_t budget = 0;
+    uint64_t now;
+    bool budgetSet;
+    EcoRes res;
+
+    budgetSet = opt == EcoChanOpt_ConnTimeout ? cli->connBudgetSet : cli->rwBudgetSet;
+
+    if (ddl != 0) {
+        now = EcoTime_NowMs();
+        if (now >= ddl) {
+            return EcoRes_Timeout;
         }
+
+        budget = ddl - now;
+    } else if (budgetSet == false) {
+        return EcoRes_Ok;
     }
 
-    /* If keep-alive is enabled, make sure request
-       has `Connection: keep-alive` header. */
-    if (cli->keepAlive) {
-        res = EcoHdrTab_Add(req->hdrTab, "connection", "keep-alive");
+    if (cli->chanSetOptHook == NULL) {
+        return EcoRes_Ok;
+    }
+
+    res = cli->chanSetOptHook(opt, (EcoArg)(size_t)budget, cli->chanHookArg);
+    if (res != EcoRes_Ok &&
+        res != EcoRes_BadOpt) {
+        return EcoRes_BadChanSetOpt;
+    }
+
+    budgetSet = budget != 0;
+
+    if (opt == EcoChanOpt_ConnTimeout) {
+        cli->connBudgetSet = budgetSet;
+    } else {
+        cli->rwBudgetSet = budgetSet;
+    }
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Open channel within the connect deadline.
+ * 
+ * @param cli HTTP client.
+ * @param addr Channel address.
+ */
+static EcoRes EcoCli_OpenChan(EcoHttpCli *cli, EcoChanAddr *addr) {
+    uint64_t ddl;
+    EcoRes res;
+
+    ddl = EarlierDdl(cli->connDdl, EarlierDdl(cli->firstByteDdl, cli->totalDdl));
+
+    /* Resolving host name counts against the connecting budget. */
+    if (addr->type == EcoChanAddrType_Name) {
+        uint32_t timeout = 0;
+
+        if (cli->resolveHook == NULL) {
+            return EcoRes_BadResolve;
+        }
+
+        if (ddl != 0) {
+            uint64_t now = EcoTime_NowMs();
+
+            if (now >= ddl) {
+                return EcoRes_Timeout;
+            }
+
+            timeout = (uint32_t)(ddl - now);
+        }
+
+        addr->ipNum = ECO_CHAN_IP_MAX_NUM;
+
+        res = cli->resolveHook(addr->name, addr->ipAry, &addr->ipNum, timeout, cli->resolveHookArg);
         if (res != EcoRes_Ok) {
             return res;
         }
+
+        if (addr->ipNum == 0) {
+            return EcoRes_BadResolve;
+        }
+    }
+
+    res = EcoCli_PushDdl(cli, EcoChanOpt_ConnTimeout, ddl);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    res = cli->chanOpenHook(addr, cli->chanHookArg);
+    if (res != EcoRes_Ok) {
+        return IsDdlExpired(ddl) ? EcoRes_Timeout : res;
     }
 
     return EcoRes_Ok;
 }
 
 /**
- * @brief Capitalize the first letter of each word in the header key.
+ * @brief Close channel if it has been opened.
+ * 
+ * @param cli HTTP client.
  */
-static void CapHdrKey(char *keyBuf, size_t keyLen) {
-    bool capNextCh = true;
-
-    for (size_t i = 0; i < keyLen; i++) {
-        char ch = keyBuf[i];
+static void EcoCli_CloseChan(EcoHttpCli *cli) {
+    if (cli->chanOpened == false) {
+        return;
+    }
 
-        if (ch >= 'a' &&
-            ch <= 'z') {
-            if (capNextCh) {
-                capNextCh = false;
+    cli->chanCloseHook(cli->chanHookArg);
 
-                keyBuf[i] = ch - 'a' + 'A';
-            }
-        } else if (ch >= 'A' && ch <= 'Z') {
-            if (capNextCh == false) {
-                keyBuf[i] = ch - 'A' + 'a';
-            }
-        } else {
-            if (capNextCh == false) {
-                capNextCh = true;
-            }
-        }
-    }
+    cli->chanOpened = false;
 }
 
-static void EcoCli_CapReqHdrKey(EcoHttpCli *cli) {
-    EcoHttpReq *req = cli->req;
+/**
+ * @brief Read data from channel within the deadline.
+ * 
+ * @param cli HTTP client.
+ * @param buf Buffer to store read data.
+ * @param len Data length to read.
+ * 
+ * @return The actual length of the read data, or a negative error code.
+ */
+static int EcoCli_ReadChan(EcoHttpCli *cli, void *buf, int len) {
+    uint64_t ddl;
+    EcoRes res;
+    int rdLen;
 
-    if (req == NULL || req->hdrTab == NULL) {
-        return;
+    ddl = EarlierDdl(cli->firstByteDdl, cli->totalDdl);
+
+    res = EcoCli_PushDdl(cli, EcoChanOpt_ReadWriteTimeout, ddl);
+    if (res != EcoRes_Ok) {
+        return res;
     }
 
-    for (size_t i = 0; i < req->hdrTab->kvpNum; i++) {
-        EcoKvp *curKvp = req->hdrTab->kvpAry + i;
+    rdLen = cli->chanReadHook(buf, len, cli->chanHookArg);
 
-        CapHdrKey(curKvp->keyBuf, curKvp->keyLen);
-    }
-}
+    cli->stats.readNum++;
 
-static void EcoCli_CapRspHdrKey(EcoHttpCli *cli) {
-    EcoHttpRsp *rsp = cli->rsp;
+    if (rdLen > 0) {
+        cli->stats.rcvLen += (uint64_t)rdLen;
 
-    if (rsp == NULL || rsp->hdrTab == NULL) {
-        return;
+        /* The first byte has arrived. */
+        cli->firstByteDdl = 0;
+
+        return rdLen;
     }
 
-    for (size_t i = 0; i < rsp->hdrTab->kvpNum; i++) {
-        EcoKvp *curKvp = rsp->hdrTab->kvpAry + i;
-        
-        CapHdrKey(curKvp->keyBuf, curKvp->keyLen);
+    if (IsDdlExpired(ddl)) {
+        return EcoRes_Timeout;
     }
+
+    return rdLen;
 }
 
-static void EcoCli_LowReqHdrKey(EcoHttpCli *cli) {
-    EcoHttpReq *req = cli->req;
+/**
+ * @brief Write all data to channel within the deadline.
+ * @note Short writes of the channel are continued until all data is written.
+ * 
+ * @param cli HTTP client.
+ * @param buf Data buffer.
+ * @param len Data length.
+ */
+static EcoRes EcoCli_WriteChan(EcoHttpCli *cli, const void *buf, int len) {
+    uint64_t ddl;
+    EcoRes res;
+    int remLen;
+    int wrLen;
 
-    if (req == NULL || req->hdrTab == NULL) {
-        return;
-    }
+    ddl = EarlierDdl(cli->firstByteDdl, cli->totalDdl);
 
-    for (size_t i = 0; i < req->hdrTab->kvpNum; i++) {
-        EcoKvp *curKvp = req->hdrTab->kvpAry + i;
+    remLen = len;
+    while (remLen != 0) {
+        res = EcoCli_PushDdl(cli, EcoChanOpt_ReadWriteTimeout, ddl);
+        if (res != EcoRes_Ok) {
+            return res;
+        }
+
+        wrLen = cli->chanWriteHook((const uint8_t *)buf + len - remLen, remLen, cli->chanHookArg);
+        if (wrLen <= 0 ||
+            wrLen > remLen) {
+            if (IsDdlExpired(ddl)) {
+                return EcoRes_Timeout;
+            }
 
-        LowHdrKey(curKvp->keyBuf, curKvp->keyLen);
+            return EcoRes_BadChanWrite;
+        }
+
+        remLen -= wrLen;
     }
+
+    return EcoRes_Ok;
 }
 
 /**
@@ -1799,16 +3450,16 @@ static void EcoCli_LowReqHdrKey(EcoHttpCli *cli) {
  * @param len Data length.
  */
 static EcoRes SendReqData(EcoHttpCli *cli, void *buf, int len) {
+    EcoRes res;
     int restLen;
     int remLen;
     int curLen;
-    int wrLen;
 
     /* If the send cache is full, send them immediately. */
     if (cli->sndChunkLen == cli->sndChunkCap) {
-        wrLen = cli->chanWriteHook(cli->sndChunkBuf, cli->sndChunkLen, cli->chanHookArg);
-        if (wrLen != cli->sndChunkLen) {
-            return EcoRes_BadChanWrite;
+        res = EcoCli_WriteChan(cli, cli->sndChunkBuf, cli->sndChunkLen);
+        if (res != EcoRes_Ok) {
+            return res;
         }
 
         cli->sndChunkLen = 0;
@@ -1824,10 +3475,12 @@ static EcoRes SendReqData(EcoHttpCli *cli, void *buf, int len) {
         }
 
         if (curLen == cli->sndChunkCap) {
-            wrLen = cli->chanWriteHook((uint8_t *)buf + len - remLen, curLen, cli->chanHookArg);
-            if (wrLen != cli->sndChunkLen) {
-                return EcoRes_BadChanWrite;
+            res = EcoCli_WriteChan(cli, (uint8_t *)buf + len - remLen, curLen);
+            if (res != EcoRes_Ok) {
+                return res;
             }
+
+            remLen -= curLen;
         } else {
             memcpy(cli->sndChunkBuf + cli->sndChunkLen, (uint8_t *)buf + len - remLen, curLen);
             cli->sndChunkLen += curLen;
@@ -1836,9 +3489,9 @@ static EcoRes SendReqData(EcoHttpCli *cli, void *buf, int len) {
 
             /* If the send cache is full, send them immediately. */
             if (cli->sndChunkLen == cli->sndChunkCap) {
-                wrLen = cli->chanWriteHook(cli->sndChunkBuf, cli->sndChunkLen, cli->chanHookArg);
-                if (wrLen != cli->sndChunkLen) {
-                    return EcoRes_BadChanWrite;
+                res = EcoCli_WriteChan(cli, cli->sndChunkBuf, cli->sndChunkLen);
+                if (res != EcoRes_Ok) {
+                    return res;
                 }
 
                 cli->sndChunkLen = 0;
@@ -1856,15 +3509,15 @@ static EcoRes SendReqData(EcoHttpCli *cli, void *buf, int len) {
  * @param cli HTTP client.
  */
 static EcoRes FlushReqData(EcoHttpCli *cli) {
-    int wrLen;
+    EcoRes res;
 
     if (cli->sndChunkLen == 0) {
         return EcoRes_Ok;
     }
 
-    wrLen = cli->chanWriteHook(cli->sndChunkBuf, cli->sndChunkLen, cli->chanHookArg);
-    if (wrLen != cli->sndChunkLen) {
-        return EcoRes_Err;
+    res = EcoCli_WriteChan(cli, cli->sndChunkBuf, cli->sndChunkLen);
+    if (res != EcoRes_Ok) {
+        return res;
     }
 
     cli->sndChunkLen = 0;
@@ -1872,106 +3525,218 @@ static EcoRes FlushReqData(EcoHttpCli *cli) {
     return EcoRes_Ok;
 }
 
-static EcoRes SendReqMsg(EcoHttpCli *cli) {
-    EcoHttpReq *req = cli->req;
-    char tmpBuf[32];
-    int sndLen;
-    int wrLen;
-    int ret;
-    EcoRes res;
+#define REQ_HEAD_INIT_CAP   256
 
-    /* Allocate memory for send chunk if needed. */
-    if (cli->sndChunkBuf == NULL) {
-        cli->sndChunkBuf = (uint8_t *)malloc(cli->sndChunkCap);
-        if (cli->sndChunkBuf == NULL) {
+/**
+ * @brief Append data to the cached request head.
+ * 
+ * @param req HTTP request.
+ * @param buf Data buffer.
+ * @param len Data length.
+ */
+static EcoRes AppendReqHead(EcoHttpReq *req, const void *buf, size_t len) {
+    if (req->headLen + len > req->headCap) {
+        size_t newCap = req->headCap == 0 ? REQ_HEAD_INIT_CAP : req->headCap;
+        uint8_t *newBuf;
+
+        while (newCap < req->headLen + len) {
+            newCap *= 2;
+        }
+
+        newBuf = (uint8_t *)realloc(req->headBuf, newCap);
+        if (newBuf == NULL) {
             return EcoRes_NoMem;
         }
+
+        req->headBuf = newBuf;
+        req->headCap = newCap;
     }
 
-    /* Clear residual data if needed. */
-    if (cli->sndChunkLen != 0) {
-        cli->sndChunkLen = 0;
+    memcpy(req->headBuf + req->headLen, buf, len);
+    req->headLen += len;
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Render start line, header lines and empty line of the request.
+ * 
+ * @param cli HTTP client.
+ */
+static EcoRes EcoCli_RenderReqHead(EcoHttpCli *cli) {
+    EcoHttpReq *req = cli->req;
+    const char *str;
+    EcoRes res;
+
+    req->headLen = 0;
+
+    /* Render start line. */
+    str = EcoHttpMeth_ToStr(req->meth);
+    res = AppendReqHead(req, str, strlen(str));
+    if (res != EcoRes_Ok) {
+        return res;
     }
 
-    /* Send start line. */
-    sndLen = snprintf(tmpBuf, sizeof(tmpBuf), "%s ", EcoHttpMeth_ToStr(req->meth));
-    res = SendReqData(cli, tmpBuf, sndLen);
+    res = AppendReqHead(req, " ", 1);
     if (res != EcoRes_Ok) {
         return res;
     }
 
-    /* Send URL path. */
-    if (req->pathBuf != NULL) {
-        res = SendReqData(cli, req->pathBuf, req->pathLen);
-        if (res != EcoRes_Ok) {
-            return res;
-        }
+    if (req->pathLen != 0) {
+        res = AppendReqHead(req, req->pathBuf, req->pathLen);
     } else {
-        res = SendReqData(cli, "/", 1);
-        if (res != EcoRes_Ok) {
-            return res;
-        }
+        res = AppendReqHead(req, "/", 1);
+    }
+    if (res != EcoRes_Ok) {
+        return res;
     }
 
-    /* Send URL query string. */
-    if (req->queryBuf != NULL) {
-        res = SendReqData(cli, "?", 1);
+    if (req->queryLen != 0) {
+        res = AppendReqHead(req, "?", 1);
         if (res != EcoRes_Ok) {
             return res;
         }
 
-        res = SendReqData(cli, req->queryBuf, req->queryLen);
+        res = AppendReqHead(req, req->queryBuf, req->queryLen);
         if (res != EcoRes_Ok) {
             return res;
         }
     }
 
-    /* Send HTTP version. */
-    sndLen = snprintf(tmpBuf, sizeof(tmpBuf), " HTTP/%s\r\n", EcoHttpVer_ToStr(req->ver));
-    res = SendReqData(cli, tmpBuf, sndLen);
+    res = AppendReqHead(req, " HTTP/", 6);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    str = EcoHttpVer_ToStr(req->ver);
+    res = AppendReqHead(req, str, strlen(str));
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    res = AppendReqHead(req, "\r\n", 2);
     if (res != EcoRes_Ok) {
         return res;
     }
 
-    /* Send header lines. */
-    for (size_t i = 0; i < cli->req->hdrTab->kvpNum; i++) {
-        EcoKvp *curKvp = cli->req->hdrTab->kvpAry + i;
+    /* Render header lines. */
+    for (size_t i = 0; i < req->hdrTab->kvpNum; i++) {
+        EcoKvp *curKvp = req->hdrTab->kvpAry + i;
 
-        res = SendReqData(cli, curKvp->keyBuf, curKvp->keyLen);
+        res = AppendReqHead(req, EcoKvp_GetWireKey(curKvp), curKvp->keyLen);
         if (res != EcoRes_Ok) {
             return res;
         }
 
-        res = SendReqData(cli, ": ", 2);
+        res = AppendReqHead(req, ": ", 2);
         if (res != EcoRes_Ok) {
             return res;
         }
 
-        res = SendReqData(cli, curKvp->valBuf, curKvp->valLen);
+        res = AppendReqHead(req, curKvp->valBuf, curKvp->valLen);
         if (res != EcoRes_Ok) {
             return res;
         }
 
-        res = SendReqData(cli, "\r\n", 2);
+        res = AppendReqHead(req, "\r\n", 2);
         if (res != EcoRes_Ok) {
             return res;
         }
     }
 
-    /* Send empty line. */
-    res = SendReqData(cli, "\r\n", 2);
+    /* Render empty line. */
+    res = AppendReqHead(req, "\r\n", 2);
     if (res != EcoRes_Ok) {
         return res;
     }
 
-    /* Send body data. */
-    if (cli->req->bodyBuf != NULL) {
-        res = SendReqData(cli, cli->req->bodyBuf, cli->req->bodyLen);
-        if (res != EcoRes_Ok) {
-            return res;
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Check if the cached request head can be sent as is.
+ * 
+ * @param cli HTTP client.
+ */
+static bool EcoCli_IsReqHeadValid(EcoHttpCli *cli) {
+    EcoHttpReq *req = cli->req;
+
+    return req->headValid &&
+           req->hdrTab != NULL &&
+           req->hdrTab->modCnt == req->headModCnt &&
+           req->headKeepAlive == (cli->keepAlive ? true : false);
+}
+
+/**
+ * @brief Prepare request head for this issue.
+ * @note Necessary headers are generated and the head
+ *       is rendered only if the cached one is stale.
+ * 
+ * @param cli HTTP client.
+ */
+static EcoRes EcoCli_PrepReqHead(EcoHttpCli *cli) {
+    EcoHttpReq *req = cli->req;
+    EcoRes res;
+
+    if (EcoCli_IsReqHeadValid(cli)) {
+        return EcoRes_Ok;
+    }
+
+    req->headValid = false;
+
+    /* Automatically generate necessary request headers. */
+    res = EcoCli_AutoGenHdrs(cli);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    res = EcoCli_RenderReqHead(cli);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    req->headModCnt = req->hdrTab->modCnt;
+    req->headKeepAlive = cli->keepAlive ? true : false;
+    req->headValid = true;
+
+    return EcoRes_Ok;
+}
+
+static EcoRes SendReqMsg(EcoHttpCli *cli) {
+    EcoHttpReq *req = cli->req;
+    EcoRes res;
+
+    /* Without body, the cached request head is written as is. */
+    if (req->bodyBuf == NULL ||
+        req->bodyLen == 0) {
+        return EcoCli_WriteChan(cli, req->headBuf, (int)req->headLen);
+    }
+
+    /* Allocate memory for send chunk if needed. */
+    if (cli->sndChunkBuf == NULL) {
+        cli->sndChunkBuf = (uint8_t *)malloc(cli->sndChunkCap);
+        if (cli->sndChunkBuf == NULL) {
+            return EcoRes_NoMem;
         }
     }
 
+    /* Clear residual data if needed. */
+    if (cli->sndChunkLen != 0) {
+        cli->sndChunkLen = 0;
+    }
+
+    /* Send request head. */
+    res = SendReqData(cli, req->headBuf, (int)req->headLen);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
+    /* Send body data. */
+    res = SendReqData(cli, req->bodyBuf, (int)req->bodyLen);
+    if (res != EcoRes_Ok) {
+        return res;
+    }
+
     /* Flush the send cache. */
     res = FlushReqData(cli);
     if (res != EcoRes_Ok) {
@@ -1990,6 +3755,16 @@ static EcoRes SendReqMsg(EcoHttpCli *cli) {
 #define ECO_HDR_VAL_MAX_LEN     (1024 - 1)
 #define ECO_HDR_VAL_BUF_LEN     (ECO_HDR_VAL_MAX_LEN + 1)
 
+/* States of response message parsing. */
+typedef enum _RspFsmStat {
+    RspFsmStat_StatLine = 0,
+    RspFsmStat_HdrLine,
+    RspFsmStat_EmpLine,
+    RspFsmStat_SaveBodyData,
+    RspFsmStat_WriteBodyData,
+    RspFsmStat_PullBodyData,
+} RspFsmStat;
+
 typedef struct _ParseCache {
     uint32_t rspMsgFsmStat;
 
@@ -2012,6 +3787,14 @@ typedef struct _ParseCache {
 
     uint32_t bodyOff;
     uint32_t bodyLen;
+
+    /* Flags. */
+
+    /* Body is abandoned as decided by response hooks. */
+    uint32_t skipBody: 1;
+
+    /* Server has refused keep-alive. */
+    uint32_t connClose: 1;
 } ParseCache;
 
 void ParseCache_Init(ParseCache *cache) {
@@ -2036,205 +3819,564 @@ void ParseCache_Init(ParseCache *cache) {
 
     cache->bodyOff = 0;
     cache->bodyLen = 0;
+
+    cache->skipBody = false;
+    cache->connClose = false;
 }
 
 void ParseCache_Deinit(ParseCache *cache) {
     ParseCache_Init(cache);
 }
 
-static EcoRes EcoCli_ParseStatLine(EcoHttpCli *cli, ParseCache *cache, const void *buf, int availLen, int *procLen) {
-    typedef enum _FsmStat {
-        FsmStat_Start = 0,
+/* Classes of bytes in status and header lines, which index
+   the transition tables of the line parsers below. */
+typedef enum _ByteCls {
+    ByteCls_Other = 0,  // Control characters and non-ASCII bytes.
+    ByteCls_Vchar,      // Visible characters not listed below.
+    ByteCls_Alpha,      // Letters not listed below, and '-'.
+    ByteCls_ChH,
+    ByteCls_ChT,
+    ByteCls_ChP,
+    ByteCls_Digit0,
+    ByteCls_Digit,      // Digits from '1' to '9'.
+    ByteCls_Slash,
+    ByteCls_Dot,
+    ByteCls_Colon,
+    ByteCls_Space,
+    ByteCls_Tab,
+    ByteCls_Cr,
+    ByteCls_Lf,
+
+    ByteCls_Num,
+} ByteCls;
+
+#define B_OT ByteCls_Other
+#define B_VC ByteCls_Vchar
+#define B_AL ByteCls_Alpha
+#define B_CH ByteCls_ChH
+#define B_CT ByteCls_ChT
+#define B_CP ByteCls_ChP
+#define B_D0 ByteCls_Digit0
+#define B_D1 ByteCls_Digit
+#define B_SL ByteCls_Slash
+#define B_DT ByteCls_Dot
+#define B_CO ByteCls_Colon
+#define B_SP ByteCls_Space
+#define B_TB ByteCls_Tab
+#define B_CR ByteCls_Cr
+#define B_LF ByteCls_Lf
+
+static const uint8_t byteClsTab[256] = {
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_TB, B_LF, B_OT, B_OT, B_CR, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_SP, B_VC, B_VC, B_VC, B_VC, B_VC, B_VC, B_VC, B_VC, B_VC, B_VC, B_VC, B_VC, B_AL, B_DT, B_SL,
+    B_D0, B_D1, B_D1, B_D1, B_D1, B_D1, B_D1, B_D1, B_D1, B_D1, B_CO, B_VC, B_VC, B_VC, B_VC, B_VC,
+    B_VC, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_CH, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL,
+    B_CP, B_AL, B_AL, B_AL, B_CT, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_VC, B_VC, B_VC, B_VC, B_VC,
+    B_VC, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL,
+    B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_AL, B_VC, B_VC, B_VC, B_VC, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+    B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT, B_OT,
+};
 
-        FsmStat_ChHGot,
-        FsmStat_ChT1Got,
-        FsmStat_ChT2Got,
-        FsmStat_ChPGot,
-        FsmStat_ChSlashGot,
-        FsmStat_VerMajorGot,
-        FsmStat_ChDotGot,
-        FsmStat_VerMinorGot,
+#undef B_OT
+#undef B_VC
+#undef B_AL
+#undef B_CH
+#undef B_CT
+#undef B_CP
+#undef B_D0
+#undef B_D1
+#undef B_SL
+#undef B_DT
+#undef B_CO
+#undef B_SP
+#undef B_TB
+#undef B_CR
+#undef B_LF
+
+static const char hdrKeyLcChTab[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+    0x40, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
+    'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F,
+    0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF,
+    0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF,
+    0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,
+    0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF,
+    0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF,
+    0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF,
+};
 
-        FsmStat_SpcAfterVerGot,
+/* Transition packs the next state in the high nibble,
+   and the action to take in the low nibble. */
+#define TR(stat, act) (uint8_t)((stat) << 4 | (act))
+#define TR_STAT(tr) ((tr) >> 4)
+#define TR_ACT(tr) ((tr) & 0x0F)
+
+typedef enum _StatLineStat {
+    StatLineStat_Start = 0,
+
+    StatLineStat_ChH,
+    StatLineStat_ChT1,
+    StatLineStat_ChT2,
+    StatLineStat_ChP,
+    StatLineStat_ChSlash,
+    StatLineStat_VerMajor,
+    StatLineStat_ChDot,
+    StatLineStat_VerMinor,
+
+    StatLineStat_SpcAfterVer,
+
+    StatLineStat_StatCode,
+
+    StatLineStat_SpcAfterStatCode,
+
+    StatLineStat_ReasonPhrase,
+
+    StatLineStat_TrailingCr,
+    StatLineStat_Done,
+
+    StatLineStat_Num,
+} StatLineStat;
+
+typedef enum _StatLineAct {
+    StatLineAct_None = 0,
+    StatLineAct_Err,
+    StatLineAct_Done,
+    StatLineAct_Major,
+    StatLineAct_Minor,
+    StatLineAct_CodeFirst,
+    StatLineAct_CodeAppend,
+    StatLineAct_RfFirst,
+    StatLineAct_RfAppend,
+    StatLineAct_RfAppendTrunc,
+    StatLineAct_RfEnd,
+    StatLineAct_RfEndDone,
+    StatLineAct_RfEmpty,
+    StatLineAct_RfEmptyDone,
+} StatLineAct;
+
+#define RST TR(StatLineStat_Start, StatLineAct_None)
+#define ERR TR(StatLineStat_Start, StatLineAct_Err)
+#define HH  TR(StatLineStat_ChH, StatLineAct_None)
+#define TT1 TR(StatLineStat_ChT1, StatLineAct_None)
+#define TT2 TR(StatLineStat_ChT2, StatLineAct_None)
+#define PP  TR(StatLineStat_ChP, StatLineAct_None)
+#define SLS TR(StatLineStat_ChSlash, StatLineAct_None)
+#define MAJ TR(StatLineStat_VerMajor, StatLineAct_Major)
+#define DOT TR(StatLineStat_ChDot, StatLineAct_None)
+#define MIN TR(StatLineStat_VerMinor, StatLineAct_Minor)
+#define SAV TR(StatLineStat_SpcAfterVer, StatLineAct_None)
+#define CDF TR(StatLineStat_StatCode, StatLineAct_CodeFirst)
+#define CDA TR(StatLineStat_StatCode, StatLineAct_CodeAppend)
+#define SAC TR(StatLineStat_SpcAfterStatCode, StatLineAct_None)
+#define RFF TR(StatLineStat_ReasonPhrase, StatLineAct_RfFirst)
+#define RFA TR(StatLineStat_ReasonPhrase, StatLineAct_RfAppend)
+#define RFT TR(StatLineStat_ReasonPhrase, StatLineAct_RfAppendTrunc)
+#define RFE TR(StatLineStat_TrailingCr, StatLineAct_RfEnd)
+#define RFD TR(StatLineStat_Done, StatLineAct_RfEndDone)
+#define RME TR(StatLineStat_TrailingCr, StatLineAct_RfEmpty)
+#define RMD TR(StatLineStat_Done, StatLineAct_RfEmptyDone)
+#define FIN TR(StatLineStat_Done, StatLineAct_Done)
+#define DON TR(StatLineStat_Done, StatLineAct_None)
+
+/* Bytes that can't continue "HTTP/x.y ddd" restart the match. */
+static const uint8_t statLineTransTab[StatLineStat_Num][ByteCls_Num] = {
+    /*                       Oth  Vch  Alp  H    T    P    0    1-9  /    .    :    SP   HT   CR   LF */
+    /* Start            */ { RST, RST, RST, HH,  RST, RST, RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChH              */ { RST, RST, RST, HH,  TT1, RST, RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChT1             */ { RST, RST, RST, HH,  TT2, RST, RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChT2             */ { RST, RST, RST, HH,  RST, PP,  RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChP              */ { RST, RST, RST, HH,  RST, RST, RST, RST, SLS, RST, RST, RST, RST, RST, RST },
+    /* ChSlash          */ { RST, RST, RST, HH,  RST, RST, MAJ, MAJ, RST, RST, RST, RST, RST, RST, RST },
+    /* VerMajor         */ { RST, RST, RST, HH,  RST, RST, RST, RST, RST, DOT, RST, SAV, RST, RST, RST },
+    /* ChDot            */ { RST, RST, RST, HH,  RST, RST, MIN, MIN, RST, RST, RST, RST, RST, RST, RST },
+    /* VerMinor         */ { RST, RST, RST, HH,  RST, RST, RST, RST, RST, RST, RST, SAV, RST, RST, RST },
+    /* SpcAfterVer      */ { RST, RST, RST, HH,  RST, RST, RST, CDF, RST, RST, RST, RST, RST, RST, RST },
+    /* StatCode         */ { ERR, ERR, ERR, ERR, ERR, ERR, CDA, CDA, ERR, ERR, ERR, SAC, ERR, ERR, ERR },
+    /* SpcAfterStatCode */ { ERR, ERR, RFF, RFF, RFF, RFF, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR },
+    /* ReasonPhrase     */ { ERR, ERR, RFA, RFA, RFA, RFA, ERR, ERR, ERR, ERR, ERR, RFA, ERR, RFE, ERR },
+    /* TrailingCr       */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, FIN },
+    /* Done             */ { DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON },
+};
 
-        FsmStat_StatCodeGot,
+/* Reason phrase may be missing or consist of any bytes, which is
+   truncated if too long, and bare LF ends the line. */
+static const uint8_t statLineLenientTransTab[StatLineStat_Num][ByteCls_Num] = {
+    /*                       Oth  Vch  Alp  H    T    P    0    1-9  /    .    :    SP   HT   CR   LF */
+    /* Start            */ { RST, RST, RST, HH,  RST, RST, RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChH              */ { RST, RST, RST, HH,  TT1, RST, RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChT1             */ { RST, RST, RST, HH,  TT2, RST, RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChT2             */ { RST, RST, RST, HH,  RST, PP,  RST, RST, RST, RST, RST, RST, RST, RST, RST },
+    /* ChP              */ { RST, RST, RST, HH,  RST, RST, RST, RST, SLS, RST, RST, RST, RST, RST, RST },
+    /* ChSlash          */ { RST, RST, RST, HH,  RST, RST, MAJ, MAJ, RST, RST, RST, RST, RST, RST, RST },
+    /* VerMajor         */ { RST, RST, RST, HH,  RST, RST, RST, RST, RST, DOT, RST, SAV, RST, RST, RST },
+    /* ChDot            */ { RST, RST, RST, HH,  RST, RST, MIN, MIN, RST, RST, RST, RST, RST, RST, RST },
+    /* VerMinor         */ { RST, RST, RST, HH,  RST, RST, RST, RST, RST, RST, RST, SAV, RST, RST, RST },
+    /* SpcAfterVer      */ { RST, RST, RST, HH,  RST, RST, RST, CDF, RST, RST, RST, RST, RST, RST, RST },
+    /* StatCode         */ { ERR, ERR, ERR, ERR, ERR, ERR, CDA, CDA, ERR, ERR, ERR, SAC, ERR, RME, RMD },
+    /* SpcAfterStatCode */ { RFF, RFF, RFF, RFF, RFF, RFF, RFF, RFF, RFF, RFF, RFF, RFF, RFF, ERR, ERR },
+    /* ReasonPhrase     */ { RFT, RFT, RFT, RFT, RFT, RFT, RFT, RFT, RFT, RFT, RFT, RFT, RFT, RFE, RFD },
+    /* TrailingCr       */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, FIN },
+    /* Done             */ { DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON },
+};
 
-        FsmStat_SpcAfterStatCodeGot,
+#undef RST
+#undef ERR
+#undef HH
+#undef TT1
+#undef TT2
+#undef PP
+#undef SLS
+#undef MAJ
+#undef DOT
+#undef MIN
+#undef SAV
+#undef CDF
+#undef CDA
+#undef SAC
+#undef RFF
+#undef RFA
+#undef RFT
+#undef RFE
+#undef RFD
+#undef RME
+#undef RMD
+#undef FIN
+#undef DON
+
+typedef enum _HdrLineStat {
+    HdrLineStat_Start = 0,
+
+    HdrLineStat_Key,
+
+    HdrLineStat_ChColon,
+
+    HdrLineStat_ChSpace,
+
+    HdrLineStat_Val,
+
+    HdrLineStat_TrailingCr,
+    HdrLineStat_Done,
+
+    HdrLineStat_Num,
+} HdrLineStat;
+
+typedef enum _HdrLineAct {
+    HdrLineAct_None = 0,
+    HdrLineAct_Err,
+    HdrLineAct_Done,
+    HdrLineAct_KeyFirst,
+    HdrLineAct_KeyAppend,
+    HdrLineAct_KeyEnd,
+    HdrLineAct_ValFirst,
+    HdrLineAct_ValAppend,
+    HdrLineAct_ValEnd,
+    HdrLineAct_ValEndDone,
+    HdrLineAct_ValEmpty,
+    HdrLineAct_ValEmptyDone,
+} HdrLineAct;
+
+#define ERR TR(HdrLineStat_Start, HdrLineAct_Err)
+#define KYF TR(HdrLineStat_Key, HdrLineAct_KeyFirst)
+#define KYA TR(HdrLineStat_Key, HdrLineAct_KeyAppend)
+#define KYE TR(HdrLineStat_ChColon, HdrLineAct_KeyEnd)
+#define SPC TR(HdrLineStat_ChSpace, HdrLineAct_None)
+#define VLF TR(HdrLineStat_Val, HdrLineAct_ValFirst)
+#define VLA TR(HdrLineStat_Val, HdrLineAct_ValAppend)
+#define VLE TR(HdrLineStat_TrailingCr, HdrLineAct_ValEnd)
+#define VLD TR(HdrLineStat_Done, HdrLineAct_ValEndDone)
+#define VME TR(HdrLineStat_TrailingCr, HdrLineAct_ValEmpty)
+#define VMD TR(HdrLineStat_Done, HdrLineAct_ValEmptyDone)
+#define FIN TR(HdrLineStat_Done, HdrLineAct_Done)
+#define DON TR(HdrLineStat_Done, HdrLineAct_None)
+
+static const uint8_t hdrLineTransTab[HdrLineStat_Num][ByteCls_Num] = {
+    /*                       Oth  Vch  Alp  H    T    P    0    1-9  /    .    :    SP   HT   CR   LF */
+    /* Start            */ { ERR, ERR, KYF, KYF, KYF, KYF, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR },
+    /* Key              */ { ERR, KYA, KYA, KYA, KYA, KYA, KYA, KYA, KYA, KYA, KYE, KYA, ERR, ERR, ERR },
+    /* ChColon          */ { ERR, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, SPC, ERR, ERR, ERR },
+    /* ChSpace          */ { ERR, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, SPC, ERR, ERR, ERR },
+    /* Val              */ { ERR, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, ERR, VLE, ERR },
+    /* TrailingCr       */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, FIN },
+    /* Done             */ { DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON },
+};
 
-        FsmStat_ReasonPhraseGot,
+/* Key and value may consist of any bytes, tabs may precede the
+   value, which may be empty, and bare LF ends the line. */
+static const uint8_t hdrLineLenientTransTab[HdrLineStat_Num][ByteCls_Num] = {
+    /*                       Oth  Vch  Alp  H    T    P    0    1-9  /    .    :    SP   HT   CR   LF */
+    /* Start            */ { KYF, KYF, KYF, KYF, KYF, KYF, KYF, KYF, KYF, KYF, ERR, KYF, KYF, KYF, KYF },
+    /* Key              */ { KYA, KYA, KYA, KYA, KYA, KYA, KYA, KYA, KYA, KYA, KYE, KYA, KYA, KYA, KYA },
+    /* ChColon          */ { VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, SPC, SPC, VME, VMD },
+    /* ChSpace          */ { VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, VLF, SPC, SPC, VME, VMD },
+    /* Val              */ { VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLA, VLE, VLD },
+    /* TrailingCr       */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, FIN },
+    /* Done             */ { DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON },
+};
 
-        FsmStat_TrailingChCrGot,
-        FsmStat_TrailingChLfGot,
+#undef ERR
+#undef KYF
+#undef KYA
+#undef KYE
+#undef SPC
+#undef VLF
+#undef VLA
+#undef VLE
+#undef VLD
+#undef VME
+#undef VMD
+#undef FIN
+#undef DON
+
+typedef enum _EmpLineStat {
+    EmpLineStat_Start = 0,
+
+    EmpLineStat_TrailingCr,
+    EmpLineStat_Done,
+
+    EmpLineStat_Num,
+} EmpLineStat;
+
+typedef enum _EmpLineAct {
+    EmpLineAct_None = 0,
+    EmpLineAct_Err,
+    EmpLineAct_Done,
+} EmpLineAct;
+
+#define ERR TR(EmpLineStat_Start, EmpLineAct_Err)
+#define ECR TR(EmpLineStat_TrailingCr, EmpLineAct_None)
+#define FIN TR(EmpLineStat_Done, EmpLineAct_Done)
+#define DON TR(EmpLineStat_Done, EmpLineAct_None)
+
+static const uint8_t empLineTransTab[EmpLineStat_Num][ByteCls_Num] = {
+    /*                       Oth  Vch  Alp  H    T    P    0    1-9  /    .    :    SP   HT   CR   LF */
+    /* Start            */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ECR, ERR },
+    /* TrailingCr       */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, FIN },
+    /* Done             */ { DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON },
+};
 
-        FsmStat_Done = FsmStat_TrailingChLfGot,
-    } FsmStat;
+/* Bare LF is an empty line. */
+static const uint8_t empLineLenientTransTab[EmpLineStat_Num][ByteCls_Num] = {
+    /*                       Oth  Vch  Alp  H    T    P    0    1-9  /    .    :    SP   HT   CR   LF */
+    /* Start            */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ECR, FIN },
+    /* TrailingCr       */ { ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, ERR, FIN },
+    /* Done             */ { DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON, DON },
+};
 
-    for (int i = 0; i < availLen; i++) {
-        uint8_t byte = ((uint8_t *)buf)[i];
+#undef ERR
+#undef ECR
+#undef FIN
+#undef DON
 
-        switch (cache->statLineFsmStat) {
-        StartParse:
-            cache->statLineFsmStat = FsmStat_Start;
+#undef TR
 
-        case FsmStat_Start:
-            if (byte == 'H') {
-                cache->statLineFsmStat = FsmStat_ChHGot;
-                break;
-            }
+/**
+ * @brief Find the end of the line in the buffer for lenient parsing.
+ * 
+ * @param buf Buffer starting at the beginning of the line.
+ * @param availLen Available length of the buffer.
+ * @param lineLen Length of the line without CRLF or bare LF.
+ * @param procLen Length of the line including CRLF or bare LF.
+ * 
+ * @return `true` if the line is complete in the buffer.
+ */
+static bool FindLineEnd(const uint8_t *buf, int availLen, int *lineLen, int *procLen) {
+    const uint8_t *lineEnd;
 
-            break;
+    lineEnd = (const uint8_t *)memchr(buf, '\n', (size_t)availLen);
+    if (lineEnd == NULL) {
+        return false;
+    }
 
-        case FsmStat_ChHGot:
-            if (byte == 'T') {
-                cache->statLineFsmStat = FsmStat_ChT1Got;
-                break;
-            }
+    *procLen = (int)(lineEnd - buf) + 1;
+    *lineLen = *procLen - 1;
+
+    if (*lineLen != 0 &&
+        buf[*lineLen - 1] == '\r') {
+        (*lineLen)--;
+    }
 
-            goto StartParse;
+    return true;
+}
+
+/**
+ * @brief Parse a complete status line in bulk for lenient parsing.
+ * 
+ * @return `EcoRes_Again` if the line isn't complete in the buffer.
+ */
+static EcoRes EcoCli_ParseStatLineFast(ParseCache *cache, const uint8_t *buf, int availLen, int *procLen) {
+    int lineLen;
+    int off;
 
-        case FsmStat_ChT1Got:
-            if (byte == 'T') {
-                cache->statLineFsmStat = FsmStat_ChT2Got;
-                break;
-            }
+    if (FindLineEnd(buf, availLen, &lineLen, procLen) == false) {
+        return EcoRes_Again;
+    }
 
-            goto StartParse;
+    /* "HTTP/x.y ddd" is the least required. */
+    if (lineLen < 12 ||
+        memcmp(buf, "HTTP/", 5) != 0 ||
+        buf[5] < '0' || buf[5] > '9' ||
+        buf[6] != '.' ||
+        buf[7] < '0' || buf[7] > '9' ||
+        buf[8] != ' ') {
+        return EcoRes_BadStatLine;
+    }
 
-        case FsmStat_ChT2Got:
-            if (byte == 'P') {
-                cache->statLineFsmStat = FsmStat_ChPGot;
-                break;
-            }
+    cache->verMajor = buf[5] - '0';
+    cache->verMinor = buf[7] - '0';
+    cache->statCode = 0;
 
-            goto StartParse;
+    for (off = 9; off < 12; off++) {
+        if (buf[off] < '0' || buf[off] > '9') {
+            return EcoRes_BadStatLine;
+        }
 
-        case FsmStat_ChPGot:
-            if (byte == '/') {
-                cache->statLineFsmStat = FsmStat_ChSlashGot;
-                break;
-            }
+        cache->statCode = cache->statCode * 10 + (buf[off] - '0');
+    }
 
-            goto StartParse;
+    /* Reason phrase is optional, and truncated if too long. */
+    if (lineLen > 12) {
+        cache->rfLen = (size_t)(lineLen - 13);
+        if (cache->rfLen > ECO_RF_MAX_LEN) {
+            cache->rfLen = ECO_RF_MAX_LEN;
+        }
 
-        case FsmStat_ChSlashGot:
-            if (byte >= '0' &&
-                byte <= '9') {
-                cache->verMajor = byte - '0';
+        memcpy(cache->rfBuf, buf + 13, cache->rfLen);
+    } else {
+        cache->rfLen = 0;
+    }
 
-                cache->statLineFsmStat = FsmStat_VerMajorGot;
-                break;
-            }
+    cache->rfBuf[cache->rfLen] = '\0';
 
-            goto StartParse;
+    return EcoRes_Ok;
+}
 
-        case FsmStat_VerMajorGot:
-            if (byte == '.') {
-                cache->statLineFsmStat = FsmStat_ChDotGot;
-                break;
+static EcoRes EcoCli_ParseStatLine(EcoHttpCli *cli, ParseCache *cache, const void *buf, int availLen, int *procLen) {
+    const uint8_t (*transTab)[ByteCls_Num];
+    int i = 0;
+
+    /* Complete status line is parsed in bulk when lenient. */
+    if (cli->lenientParse &&
+        cache->statLineFsmStat == StatLineStat_Start) {
+        EcoRes res;
+
+        res = EcoCli_ParseStatLineFast(cache, (const uint8_t *)buf, availLen, procLen);
+        if (res != EcoRes_Again) {
+            if (res == EcoRes_Ok) {
+                cache->statLineFsmStat = StatLineStat_Done;
             }
 
-            if (byte == ' ') {
-                cache->statLineFsmStat = FsmStat_SpcAfterVerGot;
-                break;
-            }
+            return res;
+        }
+    }
 
-            goto StartParse;
+    /* Most responses start with "HTTP/1.1 ", which is matched at once. */
+    if (cache->statLineFsmStat == StatLineStat_Start &&
+        availLen >= 9 &&
+        memcmp(buf, "HTTP/1.1 ", 9) == 0) {
+        cache->verMajor = 1;
+        cache->verMinor = 1;
 
-        case FsmStat_ChDotGot:
-            if (byte >= '0' &&
-                byte <= '9') {
-                cache->verMinor = byte - '0';
+        cache->statLineFsmStat = StatLineStat_SpcAfterVer;
+        i = 9;
+    }
 
-                cache->statLineFsmStat = FsmStat_VerMinorGot;
-                break;
-            }
+    transTab = cli->lenientParse ? statLineLenientTransTab : statLineTransTab;
 
-            goto StartParse;
+    for (; i < availLen; i++) {
+        uint8_t byte = ((uint8_t *)buf)[i];
+        uint8_t tr = transTab[cache->statLineFsmStat][byteClsTab[byte]];
 
-        case FsmStat_VerMinorGot:
-            if (byte == ' ') {
-                cache->statLineFsmStat = FsmStat_SpcAfterVerGot;
-                break;
-            }
+        cache->statLineFsmStat = TR_STAT(tr);
 
-            goto StartParse;
+        switch (TR_ACT(tr)) {
+        case StatLineAct_None:
+            break;
 
-        case FsmStat_SpcAfterVerGot:
-            if (byte >= '1' &&
-                byte <= '9') {
-                cache->statCode = byte - '0';
+        case StatLineAct_Err:
+            return EcoRes_BadStatLine;
 
-                cache->statLineFsmStat = FsmStat_StatCodeGot;
-                break;
-            }
+        case StatLineAct_Done:
+            *procLen = i + 1;
 
-            goto StartParse;
+            return EcoRes_Ok;
 
-        case FsmStat_StatCodeGot:
-            if (byte >= '0' &&
-                byte <= '9') {
-                cache->statCode *= 10;
-                cache->statCode += byte - '0';
+        case StatLineAct_Major:
+            cache->verMajor = byte - '0';
+            break;
 
-                break;
-            }
+        case StatLineAct_Minor:
+            cache->verMinor = byte - '0';
+            break;
 
-            if (byte == ' ') {
-                cache->statLineFsmStat = FsmStat_SpcAfterStatCodeGot;
-                break;
-            }
+        case StatLineAct_CodeFirst:
+            cache->statCode = byte - '0';
+            break;
 
-            return EcoRes_BadStatLine;
+        case StatLineAct_CodeAppend:
+            cache->statCode *= 10;
+            cache->statCode += byte - '0';
+            break;
 
-        case FsmStat_SpcAfterStatCodeGot:
-            if ((byte >= 'a' && byte <= 'z') ||
-                (byte >= 'A' && byte <= 'Z') ||
-                byte == '-') {
-                cache->rfBuf[0] = byte;
-                cache->rfLen = 1;
+        case StatLineAct_RfFirst:
+            cache->rfBuf[0] = byte;
+            cache->rfLen = 1;
+            break;
 
-                cache->statLineFsmStat = FsmStat_ReasonPhraseGot;
-                break;
+        case StatLineAct_RfAppend:
+            if (cache->rfLen == ECO_RF_MAX_LEN) {
+                return EcoRes_BadReasonPhase;
             }
 
-            return EcoRes_BadStatLine;
-
-        case FsmStat_ReasonPhraseGot:
-            if ((byte >= 'a' && byte <= 'z') ||
-                (byte >= 'A' && byte <= 'Z') ||
-                byte == ' ' ||
-                byte == '-') {
-                if (cache->rfLen == ECO_RF_MAX_LEN) {
-                    return EcoRes_BadReasonPhase;
-                }
+            cache->rfBuf[cache->rfLen] = byte;
+            cache->rfLen++;
+            break;
 
+        case StatLineAct_RfAppendTrunc:
+            if (cache->rfLen < ECO_RF_MAX_LEN) {
                 cache->rfBuf[cache->rfLen] = byte;
                 cache->rfLen++;
-
-                break;
             }
 
-            if (byte == '\r') {
-                cache->rfBuf[cache->rfLen] = '\0';
-
-                cache->statLineFsmStat = FsmStat_TrailingChCrGot;
-                break;
-            }
+            break;
 
-            return EcoRes_BadStatLine;
+        case StatLineAct_RfEnd:
+            cache->rfBuf[cache->rfLen] = '\0';
+            break;
 
-        case FsmStat_TrailingChCrGot:
-            if (byte == '\n') {
-                *procLen = i + 1;
+        case StatLineAct_RfEndDone:
+            cache->rfBuf[cache->rfLen] = '\0';
 
-                cache->statLineFsmStat = FsmStat_TrailingChLfGot;
-                return EcoRes_Ok;
-            }
+            *procLen = i + 1;
 
-            return EcoRes_BadStatLine;
+            return EcoRes_Ok;
 
-        case FsmStat_TrailingChLfGot:
+        case StatLineAct_RfEmpty:
+            cache->rfBuf[0] = '\0';
+            cache->rfLen = 0;
             break;
+
+        case StatLineAct_RfEmptyDone:
+            cache->rfBuf[0] = '\0';
+            cache->rfLen = 0;
+
+            *procLen = i + 1;
+
+            return EcoRes_Ok;
         }
     }
 
@@ -2271,149 +4413,177 @@ static EcoStatCode EcoStatCode_FromNum(uint32_t statCode) {
     }
 }
 
-static const char hdrKeyLcChTab[] = {
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '-', 0, 0,
-    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 0, 0, 0, 0, 0, 0,
-    0, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
-    'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y',  'z', 0, 0, 0, 0, 0,
-    0, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
-    'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y',  'z', 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-};
+/**
+ * @brief Parse a complete header line in bulk for lenient parsing.
+ * 
+ * @return `EcoRes_Again` if the line isn't complete in the buffer.
+ */
+static EcoRes EcoCli_ParseHdrLineFast(ParseCache *cache, const uint8_t *buf, int availLen, int *procLen) {
+    const uint8_t *colon;
+    int lineLen;
+    int valOff;
 
-static EcoRes EcoCli_ParseHdrLine(EcoHttpCli *cli, ParseCache *cache, const void *buf, int availLen, int *procLen) {
-    typedef enum _FsmStat {
-        FsmStat_Start = 0,
+    if (FindLineEnd(buf, availLen, &lineLen, procLen) == false) {
+        return EcoRes_Again;
+    }
+
+    colon = (const uint8_t *)memchr(buf, ':', (size_t)lineLen);
+    if (colon == NULL ||
+        colon == buf) {
+        return EcoRes_BadHdrLine;
+    }
+
+    cache->keyLen = (size_t)(colon - buf);
+    if (cache->keyLen > ECO_HDR_KEY_MAX_LEN) {
+        return EcoRes_BadHdrKey;
+    }
+
+    for (size_t i = 0; i < cache->keyLen; i++) {
+        cache->keyBuf[i] = hdrKeyLcChTab[buf[i]];
+    }
 
-        FsmStat_KeyGot,
+    cache->keyBuf[cache->keyLen] = '\0';
 
-        FsmStat_ChColonGot,
+    valOff = (int)cache->keyLen + 1;
+    while (valOff < lineLen &&
+           (buf[valOff] == ' ' || buf[valOff] == '\t')) {
+        valOff++;
+    }
 
-        FsmStat_ChSpaceGot,
+    cache->valLen = (size_t)(lineLen - valOff);
+    if (cache->valLen > ECO_HDR_VAL_MAX_LEN) {
+        return EcoRes_BadHdrVal;
+    }
 
-        FsmStat_ValGot,
+    memcpy(cache->valBuf, buf + valOff, cache->valLen);
+    cache->valBuf[cache->valLen] = '\0';
 
-        FsmStat_TrailingChCrGot,
-        FsmStat_TrailingChLfGot,
+    return EcoRes_Ok;
+}
 
-        FsmStat_Done = FsmStat_TrailingChLfGot,
-    } FsmStat;
+static EcoRes EcoCli_ParseHdrLine(EcoHttpCli *cli, ParseCache *cache, const void *buf, int availLen, int *procLen) {
+    const uint8_t (*transTab)[ByteCls_Num];
+
+    /* Complete header line is parsed in bulk when lenient. */
+    if (cli->lenientParse &&
+        cache->hdrLineFsmStat == HdrLineStat_Start) {
+        EcoRes res;
+
+        res = EcoCli_ParseHdrLineFast(cache, (const uint8_t *)buf, availLen, procLen);
+        if (res != EcoRes_Again) {
+            if (res == EcoRes_Ok) {
+                cache->hdrLineFsmStat = HdrLineStat_Done;
+            }
+
+            return res;
+        }
+    }
+
+    transTab = cli->lenientParse ? hdrLineLenientTransTab : hdrLineTransTab;
 
     for (int i = 0; i < availLen; i++) {
         uint8_t byte = ((uint8_t *)buf)[i];
+        uint8_t tr = transTab[cache->hdrLineFsmStat][byteClsTab[byte]];
 
-        switch (cache->hdrLineFsmStat) {
-        case FsmStat_Start:
-            if ((byte >= 'a' && byte <= 'z') ||
-                (byte >= 'A' && byte <= 'Z') ||
-                byte == '-') {
-                cache->keyBuf[0] = hdrKeyLcChTab[byte];
-                cache->keyLen = 1;
+        cache->hdrLineFsmStat = TR_STAT(tr);
 
-                cache->hdrLineFsmStat = FsmStat_KeyGot;
-                break;
-            }
+        switch (TR_ACT(tr)) {
+        case HdrLineAct_None:
+            break;
 
+        case HdrLineAct_Err:
             return EcoRes_BadHdrLine;
 
-        case FsmStat_KeyGot:
-            if (byte == ':') {
-                cache->keyBuf[cache->keyLen] = '\0';
-
-                cache->hdrLineFsmStat = FsmStat_ChColonGot;
-                break;
-            }
+        case HdrLineAct_Done:
+            *procLen = i + 1;
 
-            if (byte >= 0x20 && byte <= 0x7E) {
-                if (cache->keyLen == ECO_HDR_KEY_MAX_LEN) {
-                    return EcoRes_BadHdrKey;
-                }
+            return EcoRes_Ok;
 
-                cache->keyBuf[cache->keyLen] = hdrKeyLcChTab[byte];
-                cache->keyLen++;
+        case HdrLineAct_KeyFirst:
+            cache->keyBuf[0] = hdrKeyLcChTab[byte];
+            cache->keyLen = 1;
+            break;
 
-                cache->hdrLineFsmStat = FsmStat_KeyGot;
-                break;
+        case HdrLineAct_KeyAppend:
+            if (cache->keyLen == ECO_HDR_KEY_MAX_LEN) {
+                return EcoRes_BadHdrKey;
             }
 
-            return EcoRes_BadHdrLine;
+            cache->keyBuf[cache->keyLen] = hdrKeyLcChTab[byte];
+            cache->keyLen++;
+            break;
 
-        case FsmStat_ChColonGot:
-            if (byte == ' ') {
-                cache->hdrLineFsmStat = FsmStat_ChSpaceGot;
-                break;
-            }
+        case HdrLineAct_KeyEnd:
+            cache->keyBuf[cache->keyLen] = '\0';
+            break;
 
-            if (byte >= 0x21 &&
-                byte <= 0x7E) {
-                cache->valBuf[0] = byte;
-                cache->valLen = 1;
+        case HdrLineAct_ValFirst:
+            cache->valBuf[0] = byte;
+            cache->valLen = 1;
+            break;
 
-                cache->hdrLineFsmStat = FsmStat_ValGot;
-                break;
+        case HdrLineAct_ValAppend:
+            if (cache->valLen == ECO_HDR_VAL_MAX_LEN) {
+                return EcoRes_BadHdrVal;
             }
 
-            return EcoRes_BadHdrLine;
+            cache->valBuf[cache->valLen] = byte;
+            cache->valLen++;
+            break;
 
-        case FsmStat_ChSpaceGot:
-            if (byte == ' ') {
-                break;
-            }
+        case HdrLineAct_ValEnd:
+            cache->valBuf[cache->valLen] = '\0';
+            break;
 
-            if (byte >= 0x21 &&
-                byte <= 0x7E) {
-                cache->valBuf[0] = byte;
-                cache->valLen = 1;
+        case HdrLineAct_ValEndDone:
+            cache->valBuf[cache->valLen] = '\0';
 
-                cache->hdrLineFsmStat = FsmStat_ValGot;
-                break;
-            }
+            *procLen = i + 1;
 
-            return EcoRes_BadHdrLine;
+            return EcoRes_Ok;
 
-        case FsmStat_ValGot:
-            if (byte >= 0x20 &&
-                byte <= 0x7E) {
-                if (cache->valLen == ECO_HDR_VAL_MAX_LEN) {
-                    return EcoRes_BadHdrVal;
-                }
+        case HdrLineAct_ValEmpty:
+            cache->valBuf[0] = '\0';
+            cache->valLen = 0;
+            break;
 
-                cache->valBuf[cache->valLen] = byte;
-                cache->valLen++;
+        case HdrLineAct_ValEmptyDone:
+            cache->valBuf[0] = '\0';
+            cache->valLen = 0;
 
-                break;
-            }
+            *procLen = i + 1;
 
-            if (byte == '\r') {
-                cache->valBuf[cache->valLen] = '\0';
+            return EcoRes_Ok;
+        }
+    }
 
-                cache->hdrLineFsmStat = FsmStat_TrailingChCrGot;
-                break;
-            }
+    *procLen = availLen;
 
-            return EcoRes_BadHdrLine;
+    return EcoRes_Again;
+}
 
-        case FsmStat_TrailingChCrGot:
-            if (byte == '\n') {
-                *procLen = i + 1;
+static EcoRes EcoCli_ParseEmpLine(EcoHttpCli *cli, ParseCache *cache, const void *buf, int availLen, int *procLen) {
+    const uint8_t (*transTab)[ByteCls_Num];
 
-                cache->hdrLineFsmStat = FsmStat_TrailingChLfGot;
-                return EcoRes_Ok;
-            }
+    transTab = cli->lenientParse ? empLineLenientTransTab : empLineTransTab;
 
-            return EcoRes_BadHdrLine;
+    for (int i = 0; i < availLen; i++) {
+        uint8_t byte = ((uint8_t *)buf)[i];
+        uint8_t tr = transTab[cache->hdrLineFsmStat][byteClsTab[byte]];
 
-        case FsmStat_TrailingChLfGot:
+        cache->hdrLineFsmStat = TR_STAT(tr);
+
+        switch (TR_ACT(tr)) {
+        case EmpLineAct_None:
             break;
+
+        case EmpLineAct_Err:
+            return EcoRes_BadEmpLine;
+
+        case EmpLineAct_Done:
+            *procLen = i + 1;
+
+            return EcoRes_Ok;
         }
     }
 
@@ -2422,96 +4592,296 @@ static EcoRes EcoCli_ParseHdrLine(EcoHttpCli *cli, ParseCache *cache, const void
     return EcoRes_Again;
 }
 
-static EcoRes EcoCli_ParseEmpLine(EcoHttpCli *cli, ParseCache *cache, const void *buf, int availLen, int *procLen) {
-    typedef enum _FsmStat {
-        FsmStat_Start = 0,
-
-        FsmStat_TrailingChCrGot,
-        FsmStat_TrailingChLfGot,
+/**
+ * @brief Prepare response body buffer for the given content length.
+ * 
+ * @param cli HTTP client.
+ * @param contLen Content length.
+ * 
+ * @return `EcoRes_Ok` if body should be saved in the body buffer,
+ *         `EcoRes_Again` if body should be passed to the body write hook,
+ *         otherwise an error code.
+ */
+static EcoRes EcoCli_PrepBodyBuf(EcoHttpCli *cli, size_t contLen) {
+    EcoHttpRsp *rsp = cli->rsp;
+    size_t bodyCap;
 
-        FsmStat_Done = FsmStat_TrailingChLfGot,
-    } FsmStat;
+    /* Without a user supplied buffer, body write hook takes precedence. */
+    if (cli->bodyBuf == NULL &&
+        cli->bodyWriteHook != NULL) {
+        return EcoRes_Again;
+    }
 
-    for (int i = 0; i < availLen; i++) {
-        uint8_t byte = ((uint8_t *)buf)[i];
+    if (cli->bodyBuf != NULL) {
+        bodyCap = cli->bodyCap;
+    } else if (cli->bodyCap != 0) {
+        bodyCap = cli->bodyCap;
+    } else {
+        bodyCap = SIZE_MAX;
+    }
 
-        switch (cache->hdrLineFsmStat) {
-        case FsmStat_Start:
-            if (byte == '\r') {
-                cache->hdrLineFsmStat = FsmStat_TrailingChCrGot;
-                break;
+    if (contLen > bodyCap) {
+        switch (cli->bodyOverflow) {
+        case EcoBodyOverflow_Stream:
+            if (cli->bodyWriteHook == NULL) {
+                return EcoRes_BodyTooBig;
             }
 
-            return EcoRes_BadEmpLine;
+            return EcoRes_Again;
+
+        case EcoBodyOverflow_Grow:
+            break;
+
+        default:
+            return EcoRes_BodyTooBig;
+        }
+    } else if (cli->bodyBuf != NULL) {
+        if (rsp->bodyBuf != NULL &&
+            rsp->bodyRef == false) {
+            free(rsp->bodyBuf);
+        }
+
+        rsp->bodyBuf = cli->bodyBuf;
+        rsp->bodyCap = cli->bodyCap;
+        rsp->bodyRef = true;
+
+        return EcoRes_Ok;
+    }
+
+    /* User supplied buffer can't be grown. */
+    if (rsp->bodyRef) {
+        rsp->bodyBuf = NULL;
+        rsp->bodyCap = 0;
+        rsp->bodyRef = false;
+    }
+
+    /* Allocate buffer for body data, unless
+       the reused one is large enough. */
+    if (contLen != 0 &&
+        rsp->bodyCap < contLen) {
+        uint8_t *newBuf;
+
+        newBuf = (uint8_t *)malloc(contLen);
+        if (newBuf == NULL) {
+            return EcoRes_NoMem;
+        }
+
+        free(rsp->bodyBuf);
+
+        rsp->bodyBuf = newBuf;
+        rsp->bodyCap = contLen;
+    }
+
+    return EcoRes_Ok;
+}
+
+/**
+ * @brief Halve receive buffer if the last issue left it mostly unused.
+ * @note It never shrinks below the initial capacity.
+ * 
+ * @param cli HTTP client.
+ */
+static void EcoCli_ShrinkRcvBuf(EcoHttpCli *cli) {
+    uint8_t *newBuf;
+    size_t newCap;
+
+    if (cli->rcvBuf == NULL ||
+        cli->rcvBufCap <= cli->rcvBufMinCap ||
+        cli->rcvPeakLen >= cli->rcvBufCap / 4) {
+        return;
+    }
+
+    newCap = cli->rcvBufCap / 2;
+    if (newCap < cli->rcvBufMinCap) {
+        newCap = cli->rcvBufMinCap;
+    }
+
+    /* Keep the larger buffer if it can't be shrunk. */
+    newBuf = (uint8_t *)realloc(cli->rcvBuf, newCap);
+    if (newBuf == NULL) {
+        return;
+    }
+
+    cli->rcvBuf = newBuf;
+    cli->rcvBufCap = newCap;
+
+    cli->stats.rcvBufCap = newCap;
+    cli->stats.rcvBufShrinkNum++;
+}
+
+/**
+ * @brief Read data from channel into receive buffer.
+ * @note The buffer is allocated on first use, and doubled up to
+ *       the maximum capacity whenever the previous read filled it.
+ * 
+ * @param cli HTTP client.
+ * 
+ * @return The actual length of the read data, or a negative error code.
+ */
+static int EcoCli_ReadRcvBuf(EcoHttpCli *cli) {
+    size_t readCap;
+    int rcvLen;
+
+    if (cli->rcvBuf == NULL) {
+        cli->rcvBuf = (uint8_t *)malloc(cli->rcvBufCap);
+        if (cli->rcvBuf == NULL) {
+            return EcoRes_NoMem;
+        }
+    } else if (cli->rcvBufFull &&
+               cli->rcvBufCap < cli->rcvBufMaxCap) {
+        uint8_t *newBuf;
+        size_t newCap;
+
+        newCap = cli->rcvBufCap * 2;
+        if (newCap > cli->rcvBufMaxCap) {
+            newCap = cli->rcvBufMaxCap;
+        }
+
+        /* Data in the buffer has been consumed, so there's no need to
+           copy it, and keep the smaller buffer if it can't be grown. */
+        newBuf = (uint8_t *)malloc(newCap);
+        if (newBuf != NULL) {
+            free(cli->rcvBuf);
+
+            cli->rcvBuf = newBuf;
+            cli->rcvBufCap = newCap;
+
+            cli->stats.rcvBufCap = newCap;
+            cli->stats.rcvBufGrowNum++;
+        }
+    }
+
+    readCap = cli->rcvBufCap;
+    if (readCap > INT_MAX) {
+        readCap = INT_MAX;
+    }
+
+    rcvLen = EcoCli_ReadChan(cli, cli->rcvBuf, (int)readCap);
+    if (rcvLen < 0) {
+        return rcvLen;
+    }
+
+    cli->rcvBufFull = (size_t)rcvLen == readCap;
+
+    if ((size_t)rcvLen > cli->rcvPeakLen) {
+        cli->rcvPeakLen = (size_t)rcvLen;
+    }
+
+    return rcvLen;
+}
+
+/**
+ * @brief Apply the decision made by a response hook.
+ * 
+ * @param cache Parse cache.
+ * @param act Decision of the hook.
+ * 
+ * @return `EcoRes_Aborted` if the response is aborted, otherwise `EcoRes_Ok`.
+ */
+static EcoRes ParseCache_ApplyRspAct(ParseCache *cache, EcoRspAct act) {
+    switch (act) {
+    case EcoRspAct_SkipBody:
+        cache->skipBody = true;
+        break;
+
+    case EcoRspAct_Abort:
+        return EcoRes_Aborted;
 
-        case FsmStat_TrailingChCrGot:
-            if (byte == '\n') {
-                *procLen = i + 1;
+    default:
+        break;
+    }
 
-                cache->hdrLineFsmStat = FsmStat_TrailingChLfGot;
-                return EcoRes_Ok;
-            }
+    return EcoRes_Ok;
+}
 
-            return EcoRes_BadEmpLine;
+/**
+ * @brief Check if the parsed response header should be added to the
+ *        header table according to the response header filter.
+ * 
+ * @param cli HTTP client.
+ * @param cache Parse cache holding the header.
+ */
+static bool EcoCli_KeepRspHdr(EcoHttpCli *cli, ParseCache *cache) {
+    bool listed;
 
-        case FsmStat_TrailingChLfGot:
-            break;
-        }
+    if (cli->rspHdrFilter == EcoHdrFilter_None) {
+        return true;
     }
 
-    *procLen = availLen;
+    listed = cli->rspHdrFilterTab != NULL &&
+             EcoHdrTab_FindByBufAndLen(cli->rspHdrFilterTab, cache->keyBuf,
+                                       cache->keyLen, NULL) == EcoRes_Ok;
 
-    return EcoRes_Again;
+    return cli->rspHdrFilter == EcoHdrFilter_Allow ? listed : !listed;
 }
 
-static EcoRes ParseRspMsg(EcoHttpCli *cli) {
-    typedef enum _FsmStat {
-        FsmStat_StatLine = 0,
-        FsmStat_HdrLine,
-        FsmStat_EmpLine,
-        FsmStat_SaveBodyData,
-        FsmStat_WriteBodyData,
-    } FsmStat;
-
-    ParseCache cache;
-    uint8_t rcvBuf[512];
+/**
+ * @brief Continue parsing response from where it stopped, starting with
+ *        the unconsumed data in receive buffer.
+ * 
+ * @param cli HTTP client.
+ * 
+ * @return `EcoRes_Ok` when the response ends, `EcoRes_Again` when body
+ *         write hook applies backpressure, otherwise an error code.
+ */
+static EcoRes EcoCli_ContParseRsp(EcoHttpCli *cli) {
+    ParseCache *cache = cli->parseCache;
+    uint8_t *rcvBuf;
     int rcvLen;
     int remLen;
     int procLen;
     EcoRes res;
 
-    ParseCache_Init(&cache);
+    while (true) {
 
-    /* Create a HTTP response if it does not exist,
-       or if it exists, then deinitialize it. */
-    if (cli->rsp == NULL) {
-        cli->rsp = EcoHttpRsp_New();
-        if (cli->rsp == NULL) {
-            return EcoRes_NoMem;
+        /* Once body length is known, read body data
+           straight into the rest of the body buffer. */
+        if (cache->rspMsgFsmStat == RspFsmStat_SaveBodyData) {
+            EcoHttpRsp *rsp = cli->rsp;
+            size_t waitLen;
+
+            waitLen = (size_t)cache->contLen - rsp->bodyLen;
+            if (waitLen > INT_MAX) {
+                waitLen = INT_MAX;
+            }
+
+            rcvLen = EcoCli_ReadChan(cli, rsp->bodyBuf + rsp->bodyLen, (int)waitLen);
+            if (rcvLen < 0) {
+                return (EcoRes)rcvLen;
+            }
+
+            rsp->bodyLen += (size_t)rcvLen;
+
+            if (rsp->bodyLen == cache->contLen) {
+                return EcoRes_Ok;
+            }
+
+            continue;
         }
-    } else {
-        EcoHttpRsp_Deinit(cli->rsp);
-    }
 
-    /* Create a new header table for HTTP response. */
-    cli->rsp->hdrTab = EcoHdrTab_New();
-    if (cli->rsp->hdrTab == NULL) {
-        return EcoRes_NoMem;
-    }
+        if (cli->rcvBufOff == cli->rcvBufLen) {
+            rcvLen = EcoCli_ReadRcvBuf(cli);
+            if (rcvLen < 0) {
+                return (EcoRes)rcvLen;
+            }
 
-    while (true) {
-        rcvLen = cli->chanReadHook(rcvBuf, (int)sizeof(rcvBuf), cli->chanHookArg);
-        if (rcvLen < 0) {
-            return (EcoRes)rcvLen;
+            cli->rcvBufOff = 0;
+            cli->rcvBufLen = (size_t)rcvLen;
         }
 
-        remLen = rcvLen;
+        rcvBuf = cli->rcvBuf;
+        rcvLen = (int)cli->rcvBufLen;
+        remLen = (int)(cli->rcvBufLen - cli->rcvBufOff);
+
+        /* All data will be consumed unless parsing stops early. */
+        cli->rcvBufOff = cli->rcvBufLen;
+
         while (remLen != 0) {
-            switch (cache.rspMsgFsmStat) {
-            case FsmStat_StatLine:
+            switch (cache->rspMsgFsmStat) {
+            case RspFsmStat_StatLine:
 
                 /* Try to parse the status line. */
-                res = EcoCli_ParseStatLine(cli, &cache, rcvBuf + rcvLen - remLen, remLen, &procLen);
+                res = EcoCli_ParseStatLine(cli, cache, rcvBuf + rcvLen - remLen, remLen, &procLen);
                 if (res != EcoRes_Ok &&
                     res != EcoRes_Again) {
                     return res;
@@ -2524,33 +4894,46 @@ static EcoRes ParseRspMsg(EcoHttpCli *cli) {
                     EcoStatCode code;
 
                     /* Validate the HTTP version. */
-                    ver = EcoHttpVer_FromNum(cache.verMajor, cache.verMinor);
+                    ver = EcoHttpVer_FromNum(cache->verMajor, cache->verMinor);
                     if (ver == EcoHttpVer_Unknown) {
                         return EcoRes_BadHttpVer;
                     }
 
                     cli->rsp->ver = ver;
-                    cli->rsp->statCode = cache.statCode;
+                    cli->rsp->statCode = cache->statCode;
+
+                    if (cli->rspStatHook != NULL) {
+                        EcoRspAct act;
+
+                        act = cli->rspStatHook(ver, cli->rsp->statCode, cli->rspStatHookArg);
 
-                    cache.rspMsgFsmStat = FsmStat_HdrLine;
+                        res = ParseCache_ApplyRspAct(cache, act);
+                        if (res != EcoRes_Ok) {
+                            return res;
+                        }
+                    }
+
+                    cache->rspMsgFsmStat = RspFsmStat_HdrLine;
                 }
 
                 remLen -= procLen;
 
                 break;
 
-            case FsmStat_HdrLine: {
+            case RspFsmStat_HdrLine: {
                 uint8_t byte = *(rcvBuf + rcvLen - remLen);
 
-                /* If the current byte is CR character, then
-                   it may reach the end of the header line. */
-                if (byte == '\r') {
-                    cache.rspMsgFsmStat = FsmStat_EmpLine;
+                /* If a new line starts with CR character, or bare LF
+                   when lenient, then it may reach the end of the
+                   header line. */
+                if ((byte == '\r' || (byte == '\n' && cli->lenientParse)) &&
+                    cache->hdrLineFsmStat == 0) {
+                    cache->rspMsgFsmStat = RspFsmStat_EmpLine;
                     break;
                 }
 
                 /* Try to parse this header line. */
-                res = EcoCli_ParseHdrLine(cli, &cache, rcvBuf + rcvLen - remLen, remLen, &procLen);
+                res = EcoCli_ParseHdrLine(cli, cache, rcvBuf + rcvLen - remLen, remLen, &procLen);
                 if (res != EcoRes_Ok &&
                     res != EcoRes_Again) {
                     return res;
@@ -2559,22 +4942,40 @@ static EcoRes ParseRspMsg(EcoHttpCli *cli) {
                 /* If this header line is parsed successfully,
                    then add it to the header table. */
                 if (res == EcoRes_Ok) {
-                    cache.hdrLineFsmStat = 0;
-
-                    res = EcoHdrTab_Add(cli->rsp->hdrTab, cache.keyBuf, cache.valBuf);
-                    if (res != EcoRes_Ok) {
-                        return res;
-                    }
+                    cache->hdrLineFsmStat = 0;
 
                     /* If this header line is "Content-Length",
                        then get the content length. */
-                    if (strcmp(cache.keyBuf, "content-length") == 0) {
+                    if (strcmp(cache->keyBuf, "content-length") == 0) {
                         char *endPtr;
 
-                        cache.contLen = (uint32_t)strtol(cache.valBuf, &endPtr, 10);
+                        cache->contLen = (uint32_t)strtol(cache->valBuf, &endPtr, 10);
                         if (*endPtr != '\0') {
                             return EcoRes_BadHdrVal;
                         }
+                    } else if (strcmp(cache->keyBuf, "connection") == 0) {
+                        cache->connClose = strcmp(cache->valBuf, "close") == 0;
+                    }
+
+                    /* Headers filtered out are not stored. */
+                    if (EcoCli_KeepRspHdr(cli, cache)) {
+                        res = EcoHdrTab_Add(cli->rsp->hdrTab, cache->keyBuf, cache->valBuf);
+                        if (res != EcoRes_Ok) {
+                            return res;
+                        }
+                    }
+
+                    if (cli->rspHdrLineHook != NULL) {
+                        EcoRspAct act;
+
+                        act = cli->rspHdrLineHook(cache->keyBuf, cache->keyLen,
+                                                  cache->valBuf, cache->valLen,
+                                                  cli->rspHdrLineHookArg);
+
+                        res = ParseCache_ApplyRspAct(cache, act);
+                        if (res != EcoRes_Ok) {
+                            return res;
+                        }
                     }
                 }
 
@@ -2583,44 +4984,61 @@ static EcoRes ParseRspMsg(EcoHttpCli *cli) {
                 break;
             }
 
-            case FsmStat_EmpLine:
-                res = EcoCli_ParseEmpLine(cli, &cache, rcvBuf + rcvLen - remLen, remLen, &procLen);
+            case RspFsmStat_EmpLine:
+                res = EcoCli_ParseEmpLine(cli, cache, rcvBuf + rcvLen - remLen, remLen, &procLen);
                 if (res != EcoRes_Ok &&
                     res != EcoRes_Again) {
                     return res;
                 }
 
                 if (res == EcoRes_Ok) {
-                    cli->rsp->contLen = cache.contLen;
+                    cli->rsp->contLen = cache->contLen;
 
                     /* If the current method is HEAD. */
                     if (cli->req->meth == EcoHttpMeth_Head) {
                         return EcoRes_Ok;
                     }
 
-                    /* Determine whther to save or write body data. */
-                    if (cli->bodyWriteHook == NULL) {
-                        if (cache.contLen == 0) {
-                            return EcoRes_Ok;
+                    /* Leave the body to be pulled by user, starting
+                       with the body data received along with the head.
+                       Body to skip is left the same way, and abandoned
+                       after parsing. */
+                    if (cli->pullBody ||
+                        cache->skipBody) {
+                        if (cache->contLen != 0) {
+                            cli->rcvBufOff = (size_t)(rcvLen - remLen + procLen);
+                            cli->rcvBufLen = (size_t)rcvLen;
+                            cli->bodyPending = true;
+
+                            cache->rspMsgFsmStat = RspFsmStat_PullBodyData;
                         }
 
-                        /* Allocate buffer for body data. */
-                        cli->rsp->bodyBuf = (uint8_t *)malloc((size_t)cache.contLen);
-                        if (cli->rsp->bodyBuf == NULL) {
-                            return EcoRes_NoMem;
+                        return EcoRes_Ok;
+                    }
+
+                    /* Determine whther to save or write body data. */
+                    res = EcoCli_PrepBodyBuf(cli, (size_t)cache->contLen);
+                    if (res != EcoRes_Ok &&
+                        res != EcoRes_Again) {
+                        return res;
+                    }
+
+                    if (res == EcoRes_Ok) {
+                        if (cache->contLen == 0) {
+                            return EcoRes_Ok;
                         }
 
                         cli->rsp->bodyLen = 0;
 
-                        cache.rspMsgFsmStat = FsmStat_SaveBodyData;
+                        cache->rspMsgFsmStat = RspFsmStat_SaveBodyData;
                     } else {
-                        if (cache.contLen == 0) {
+                        if (cache->contLen == 0) {
                             cli->bodyWriteHook(0, NULL, 0, cli->bodyHookArg);
 
                             return EcoRes_Ok;
                         }
 
-                        cache.rspMsgFsmStat = FsmStat_WriteBodyData;
+                        cache->rspMsgFsmStat = RspFsmStat_WriteBodyData;
                     }
                 }
 
@@ -2628,12 +5046,12 @@ static EcoRes ParseRspMsg(EcoHttpCli *cli) {
 
                 break;
 
-            case FsmStat_SaveBodyData: {
+            case RspFsmStat_SaveBodyData: {
                 EcoHttpRsp *rsp = cli->rsp;
                 int waitLen;
                 int curLen;
 
-                waitLen = cache.contLen - rsp->bodyLen;
+                waitLen = cache->contLen - rsp->bodyLen;
                 if (remLen > waitLen) {
                     curLen = waitLen;
                 } else {
@@ -2646,41 +5064,50 @@ static EcoRes ParseRspMsg(EcoHttpCli *cli) {
 
                 remLen -= curLen;
 
-                if (rsp->bodyLen == cache.contLen) {
+                if (rsp->bodyLen == cache->contLen) {
                     return EcoRes_Ok;
                 }
 
                 break;
             }
 
-            case FsmStat_WriteBodyData: {
+            case RspFsmStat_WriteBodyData: {
                 int waitLen;
                 int curLen;
                 int wrLen;
 
-                waitLen = cache.contLen - cache.bodyLen;
+                waitLen = cache->contLen - cache->bodyLen;
                 if (remLen > waitLen) {
                     curLen = waitLen;
                 } else {
                     curLen = remLen;
                 }
 
-                wrLen = cli->bodyWriteHook(cache.bodyOff, rcvBuf + rcvLen - remLen, curLen, cli->bodyHookArg);
-                if (wrLen < 0) {
+                wrLen = cli->bodyWriteHook(cache->bodyOff, rcvBuf + rcvLen - remLen, curLen, cli->bodyHookArg);
+                if (wrLen == EcoRes_Again) {
+                    wrLen = 0;
+                } else if (wrLen < 0) {
                     return (EcoRes)wrLen;
-                }
-
-                if (wrLen != curLen) {
+                } else if (wrLen > curLen) {
                     return EcoRes_Err;
                 }
 
-                cache.bodyOff += curLen;
-                cache.bodyLen += curLen;
+                cache->bodyOff += wrLen;
+                cache->bodyLen += wrLen;
 
-                remLen -= curLen;
+                remLen -= wrLen;
+
+                /* Stop reading until user resumes, and keep
+                   the rest of data in receive buffer. */
+                if (wrLen < curLen) {
+                    cli->rcvBufOff = (size_t)(rcvLen - remLen);
+                    cli->bodyPaused = true;
 
-                if (cache.bodyLen == cache.contLen) {
-                    cli->bodyWriteHook(cache.bodyOff, NULL, 0, cli->bodyHookArg);
+                    return EcoRes_Again;
+                }
+
+                if (cache->bodyLen == cache->contLen) {
+                    cli->bodyWriteHook(cache->bodyOff, NULL, 0, cli->bodyHookArg);
 
                     return EcoRes_Ok;
                 }
@@ -2692,6 +5119,49 @@ static EcoRes ParseRspMsg(EcoHttpCli *cli) {
     }
 }
 
+static EcoRes ParseRspMsg(EcoHttpCli *cli) {
+    if (cli->parseCache == NULL) {
+        cli->parseCache = (ParseCache *)malloc(sizeof(ParseCache));
+        if (cli->parseCache == NULL) {
+            return EcoRes_NoMem;
+        }
+    }
+
+    ParseCache_Init(cli->parseCache);
+
+    /* Give back the memory of a receive buffer grown
+       for large responses once they've stopped. */
+    EcoCli_ShrinkRcvBuf(cli);
+
+    cli->rcvPeakLen = 0;
+    cli->rcvBufOff = 0;
+    cli->rcvBufLen = 0;
+    cli->rcvBufFull = false;
+
+    /* Create a HTTP response if it does not exist, or if it
+       exists, then reset or deinitialize it. */
+    if (cli->rsp == NULL) {
+        cli->rsp = EcoHttpRsp_New();
+        if (cli->rsp == NULL) {
+            return EcoRes_NoMem;
+        }
+    } else if (cli->reuseRsp) {
+        EcoHttpRsp_Reset(cli->rsp);
+    } else {
+        EcoHttpRsp_Deinit(cli->rsp);
+    }
+
+    /* Create a new header table for HTTP response. */
+    if (cli->rsp->hdrTab == NULL) {
+        cli->rsp->hdrTab = EcoHdrTab_New();
+        if (cli->rsp->hdrTab == NULL) {
+            return EcoRes_NoMem;
+        }
+    }
+
+    return EcoCli_ContParseRsp(cli);
+}
+
 /**
  * @brief Call HTTP request header hook.
  * @note Hook won't be called if it's not set yet.
@@ -2715,7 +5185,7 @@ static EcoRes EcoCli_CallReqHdrHook(EcoHttpCli *cli) {
             EcoKvp *kvp = tab->kvpAry + i;
 
             res = cli->reqHdrHook(tab->kvpNum, i,
-                                  kvp->keyBuf, kvp->keyLen,
+                                  EcoKvp_GetWireKey(kvp), kvp->keyLen,
                                   kvp->valBuf, kvp->valLen,
                                   cli->rspHdrHookArg);
             if (res != EcoRes_Ok) {
@@ -2750,7 +5220,7 @@ static EcoRes EcoCli_CallRspHdrHook(EcoHttpCli *cli) {
             EcoKvp *kvp = tab->kvpAry + i;
 
             res = cli->rspHdrHook(tab->kvpNum, i,
-                                  kvp->keyBuf, kvp->keyLen,
+                                  EcoKvp_GetWireKey(kvp), kvp->keyLen,
                                   kvp->valBuf, kvp->valLen,
                                   cli->rspHdrHookArg);
             if (res != EcoRes_Ok) {
@@ -2762,16 +5232,75 @@ static EcoRes EcoCli_CallRspHdrHook(EcoHttpCli *cli) {
     return EcoRes_Ok;
 }
 
+/**
+ * @brief Convert request timeouts to absolute deadlines of this issue.
+ * 
+ * @param cli HTTP client.
+ */
+static void EcoCli_StartDdls(EcoHttpCli *cli) {
+    EcoHttpReq *req = cli->req;
+    uint64_t now;
+
+    cli->connDdl = 0;
+    cli->firstByteDdl = 0;
+    cli->totalDdl = 0;
+
+    if (req->connTimeout == 0 &&
+        req->firstByteTimeout == 0 &&
+        req->totalTimeout == 0) {
+        return;
+    }
+
+    now = EcoTime_NowMs();
+
+    if (req->connTimeout != 0) {
+        cli->connDdl = now + req->connTimeout;
+    }
+
+    if (req->firstByteTimeout != 0) {
+        cli->firstByteDdl = now + req->firstByteTimeout;
+    }
+
+    if (req->totalTimeout != 0) {
+        cli->totalDdl = now + req->totalTimeout;
+    }
+}
+
+/**
+ * @brief Check if the channel can be kept alive after the current response.
+ * 
+ * @param cli HTTP client.
+ */
+static bool EcoCli_CanKeepAlive(EcoHttpCli *cli) {
+    return cli->keepAlive &&
+           cli->parseCache->connClose == false;
+}
+
+/**
+ * @brief End the current response, and close the channel unless it can be
+ *        kept alive for the next issue.
+ * 
+ * @param cli HTTP client.
+ */
+static void EcoCli_EndRsp(EcoHttpCli *cli) {
+    cli->bodyPending = false;
+
+    if (EcoCli_CanKeepAlive(cli)) {
+        return;
+    }
+
+    EcoCli_CloseChan(cli);
+}
+
 static EcoRes EcoHttpCli_SendReqAndParseRsp_OpenAndClose(EcoHttpCli *cli) {
     EcoChanAddr chanAddr;
     EcoRes res;
 
     /* Set channel address. */
-    memcpy(chanAddr.addr, cli->req->chanAddr.addr, 4);
-    chanAddr.port = cli->req->chanAddr.port;
+    chanAddr = cli->req->chanAddr;
 
     /* Open channel. */
-    res = cli->chanOpenHook(&chanAddr, cli->chanHookArg);
+    res = EcoCli_OpenChan(cli, &chanAddr);
     if (res != EcoRes_Ok) {
         return res;
     }
@@ -2788,27 +5317,31 @@ static EcoRes EcoHttpCli_SendReqAndParseRsp_OpenAndClose(EcoHttpCli *cli) {
 
     /* Receive and parse HTTP response. */
     res = ParseRspMsg(cli);
+    if (res == EcoRes_Again) {
+        return res;
+    }
+
     if (res != EcoRes_Ok) {
         goto CloseChan;
     }
 
+    /* Keep channel open until the body is pulled. */
+    if (cli->bodyPending) {
+        return EcoRes_Ok;
+    }
+
     res = EcoRes_Ok;
 
 CloseChan:
 
     /* Close channel. */
-    cli->chanCloseHook(cli->chanHookArg);
-
-    if (cli->chanOpened) {
-        cli->chanOpened = false;
-    }
+    EcoCli_CloseChan(cli);
 
     return res;
 }
 
 static EcoRes EcoHttpCli_SendReqAndParseRsp_KeepAlive(EcoHttpCli *cli) {
     EcoChanAddr chanAddr;
-    EcoKvp *kvp;
     EcoRes res;
 
     if (cli->chanOpened) {
@@ -2816,11 +5349,10 @@ static EcoRes EcoHttpCli_SendReqAndParseRsp_KeepAlive(EcoHttpCli *cli) {
     }
 
     /* Set channel address. */
-    memcpy(chanAddr.addr, cli->req->chanAddr.addr, 4);
-    chanAddr.port = cli->req->chanAddr.port;
+    chanAddr = cli->req->chanAddr;
 
     /* Open channel. */
-    res = cli->chanOpenHook(&chanAddr, cli->chanHookArg);
+    res = EcoCli_OpenChan(cli, &chanAddr);
     if (res != EcoRes_Ok) {
         return res;
     }
@@ -2834,27 +5366,33 @@ SendReqMsg:
     /* Send HTTP request. */
     res = SendReqMsg(cli);
     if (res != EcoRes_Ok) {
-        return res;
+        goto CloseChan;
     }
 
     /* Receive and parse HTTP response. */
     res = ParseRspMsg(cli);
-    if (res != EcoRes_Ok) {
+    if (res == EcoRes_Again) {
         return res;
     }
 
-    /* Check if server has refused keep-alive. */
-    res = EcoHdrTab_Find(cli->rsp->hdrTab, "connection", &kvp);
-    if (res == EcoRes_Ok &&
-        strcmp(kvp->valBuf, "close") == 0) {
-        cli->chanCloseHook(cli->chanHookArg);
+    if (res != EcoRes_Ok) {
+        goto CloseChan;
+    }
 
-        if (cli->chanOpened) {
-            cli->chanOpened = false;
-        }
+    /* Keep channel open until the body is pulled. */
+    if (cli->bodyPending == false) {
+        EcoCli_EndRsp(cli);
     }
 
     return EcoRes_Ok;
+
+CloseChan:
+
+    /* The channel is left in an unknown state
+       after a failure, so it can't be reused. */
+    EcoCli_CloseChan(cli);
+
+    return res;
 }
 
 EcoRes EcoHttpCli_Issue(EcoHttpCli *cli) {
@@ -2872,18 +5410,20 @@ EcoRes EcoHttpCli_Issue(EcoHttpCli *cli) {
         return EcoRes_NoReq;
     }
 
-    /* Lowercase all request headers. */
-    EcoCli_LowReqHdrKey(cli);
+    cli->stats.issueNum++;
 
-    /* Automatically generate necessary request headers. */
-    res = EcoCli_AutoGenHdrs(cli);
+    /* Body left unfinished by user has to be got rid of. */
+    EcoHttpCli_AbandonBody(cli);
+
+    /* Start counting down the deadlines. */
+    EcoCli_StartDdls(cli);
+
+    /* Render request head unless the cached one is still valid. */
+    res = EcoCli_PrepReqHead(cli);
     if (res != EcoRes_Ok) {
         return res;
     }
 
-    /* Capitalize the first letter of the request header key. */
-    EcoCli_CapReqHdrKey(cli);
-
     /* Call request header hook. */
     EcoCli_CallReqHdrHook(cli);
 
@@ -2898,11 +5438,170 @@ EcoRes EcoHttpCli_Issue(EcoHttpCli *cli) {
         return res;
     }
 
-    /* Capitalize the first letter of the response header key. */
-    EcoCli_CapRspHdrKey(cli);
+    /* Get rid of the body skipped by response hooks. */
+    if (cli->parseCache->skipBody) {
+        EcoHttpCli_AbandonBody(cli);
+    }
+
+    /* Call response header hook. */
+    EcoCli_CallRspHdrHook(cli);
+
+    return EcoRes_Ok;
+}
+
+EcoRes EcoHttpCli_Resume(EcoHttpCli *cli) {
+    EcoRes res;
+
+    if (cli->bodyPaused == false) {
+        return EcoRes_Ok;
+    }
+
+    cli->bodyPaused = false;
+
+    res = EcoCli_ContParseRsp(cli);
+    if (res == EcoRes_Again) {
+        return res;
+    }
+
+    if (res != EcoRes_Ok) {
+        EcoCli_CloseChan(cli);
+
+        return res;
+    }
+
+    EcoCli_EndRsp(cli);
 
     /* Call response header hook. */
     EcoCli_CallRspHdrHook(cli);
 
     return EcoRes_Ok;
 }
+
+int EcoHttpCli_ReadBody(EcoHttpCli *cli, void *buf, int len) {
+    ParseCache *cache = cli->parseCache;
+    size_t waitLen;
+    int rdLen;
+
+    if (cli->bodyPending == false) {
+        return 0;
+    }
+
+    if (buf == NULL ||
+        len <= 0) {
+        return EcoRes_BadArg;
+    }
+
+    waitLen = (size_t)cache->contLen - cache->bodyLen;
+    if ((size_t)len > waitLen) {
+        len = (int)waitLen;
+    }
+
+    /* Body data received along with the head comes first. */
+    if (cli->rcvBufOff != cli->rcvBufLen) {
+        size_t restLen = cli->rcvBufLen - cli->rcvBufOff;
+
+        if ((size_t)len > restLen) {
+            len = (int)restLen;
+        }
+
+        memcpy(buf, cli->rcvBuf + cli->rcvBufOff, (size_t)len);
+        cli->rcvBufOff += (size_t)len;
+
+        rdLen = len;
+    } else {
+        rdLen = EcoCli_ReadChan(cli, buf, len);
+        if (rdLen < 0) {
+            cli->bodyPending = false;
+
+            EcoCli_CloseChan(cli);
+
+            return rdLen;
+        }
+    }
+
+    cache->bodyOff += (uint32_t)rdLen;
+    cache->bodyLen += (uint32_t)rdLen;
+
+    if (cache->bodyLen == cache->contLen) {
+        EcoCli_EndRsp(cli);
+    }
+
+    return rdLen;
+}
+
+EcoBodyAbandon EcoHttpCli_AbandonBody(EcoHttpCli *cli) {
+    ParseCache *cache = cli->parseCache;
+    uint64_t firstByteDdl;
+    uint64_t totalDdl;
+    size_t waitLen;
+    size_t bufLen;
+    int rcvLen;
+
+    if (cli->bodyPending == false &&
+        cli->bodyPaused == false) {
+        return EcoBodyAbandon_None;
+    }
+
+    cli->bodyPending = false;
+    cli->bodyPaused = false;
+
+    /* Length of body data that hasn't been received yet. */
+    waitLen = (size_t)cache->contLen - cache->bodyLen;
+    bufLen = cli->rcvBufLen - cli->rcvBufOff;
+    waitLen = waitLen > bufLen ? waitLen - bufLen : 0;
+
+    if (EcoCli_CanKeepAlive(cli) == false ||
+        waitLen > cli->drainMaxLen) {
+        goto CloseChan;
+    }
+
+    /* Body data already received is drained as well. */
+    bufLen = (size_t)cache->contLen - cache->bodyLen - waitLen;
+
+    cli->stats.bodyDrainLen += (uint64_t)bufLen;
+
+    /* Drain within its own deadline instead of those of the issue. */
+    firstByteDdl = cli->firstByteDdl;
+    totalDdl = cli->totalDdl;
+
+    cli->firstByteDdl = 0;
+    cli->totalDdl = cli->drainTimeout != 0 ? EcoTime_NowMs() + cli->drainTimeout : 0;
+
+    while (waitLen != 0) {
+        rcvLen = EcoCli_ReadRcvBuf(cli);
+        if (rcvLen < 0) {
+            break;
+        }
+
+        /* Data beyond the body can't be told apart. */
+        if ((size_t)rcvLen > waitLen) {
+            rcvLen = EcoRes_Err;
+            break;
+        }
+
+        waitLen -= (size_t)rcvLen;
+
+        cli->stats.bodyDrainLen += (uint64_t)rcvLen;
+    }
+
+    cli->firstByteDdl = firstByteDdl;
+    cli->totalDdl = totalDdl;
+
+    cli->rcvBufOff = cli->rcvBufLen;
+
+    if (waitLen != 0) {
+        goto CloseChan;
+    }
+
+    cli->stats.bodyDrainNum++;
+
+    return EcoBodyAbandon_Drain;
+
+CloseChan:
+
+    EcoCli_CloseChan(cli);
+
+    cli->stats.bodyCloseNum++;
+
+    return EcoBodyAbandon_Close;
+}
@@ -73,6 +73,10 @@ typedef enum _EcoRes {
     /* Errors used in HTTP client. */
     EcoRes_NoChanHook,
     EcoRes_NoReq,
+    EcoRes_Timeout,
+    EcoRes_BodyTooBig,
+    EcoRes_Aborted,
+    EcoRes_BadResolve,
 } EcoRes;
 
 typedef enum _EcoScheme {
@@ -80,6 +84,10 @@ typedef enum _EcoScheme {
 
     EcoScheme_Http,
     EcoScheme_Https,
+
+    /* HTTP over Unix domain socket, for example:
+       "http+unix://%2Fvar%2Frun%2Fagent.sock/metrics". */
+    EcoScheme_HttpUnix,
 } EcoScheme;
 
 typedef enum _EcoHttpVer {
@@ -110,8 +118,51 @@ typedef enum _EcoHttpReqOpt {
     EcoHttpReqOpt_Headers,
     EcoHttpReqOpt_BodyBuf,
     EcoHttpReqOpt_BodyLen,
+
+    /* Set deadlines (in milliseconds) of the request, all of which
+       are measured from the start of `EcoHttpCli_Issue`.
+
+       0 means no deadline, which is also the default. */
+    EcoHttpReqOpt_ConnTimeout,
+    EcoHttpReqOpt_FirstByteTimeout,
+    EcoHttpReqOpt_TotalTimeout,
+
+    /* Apply a pre-parsed URL (`EcoUrl *`), which
+       involves no parsing, and no allocation once
+       path and query buffers are large enough. */
+    EcoHttpReqOpt_ParsedUrl,
+
+    /* Set Unix domain socket path, this option
+       will also set scheme to `EcoScheme_HttpUnix`. */
+    EcoHttpReqOpt_SockPath,
 } EcoHttpReqOpt;
 
+/* What to do when response body doesn't fit in the body buffer. */
+typedef enum _EcoBodyOverflow {
+
+    /* Fail with `EcoRes_BodyTooBig`. */
+    EcoBodyOverflow_Fail,
+
+    /* Pass body to the body write hook instead. */
+    EcoBodyOverflow_Stream,
+
+    /* Allocate a buffer large enough for the body. */
+    EcoBodyOverflow_Grow,
+} EcoBodyOverflow;
+
+/* How response headers are filtered before being added to the header table. */
+typedef enum _EcoHdrFilter {
+
+    /* Keep all headers. */
+    EcoHdrFilter_None = 0,
+
+    /* Keep only the headers listed in the filter table. */
+    EcoHdrFilter_Allow,
+
+    /* Keep all but the headers listed in the filter table. */
+    EcoHdrFilter_Deny,
+} EcoHdrFilter;
+
 typedef enum _EcoHttpCliOpt {
     EcoHttpCliOpt_ChanHookArg,
     EcoHttpCliOpt_ChanOpenHook,
@@ -137,43 +188,240 @@ typedef enum _EcoHttpCliOpt {
        This option will clear all data
        in the send chunk buffer. */
     EcoHttpCliOpt_SndChunkCap,
+
+    /* Reset the response of the last issue instead of
+       freeing it, so that its header table and body
+       buffer can be reused by the next issue. */
+    EcoHttpCliOpt_ReuseRsp,
+
+    /* Body buffer supplied by user, which is used instead of
+       an allocated one, and takes precedence over the body
+       write hook. It must outlive the client. */
+    EcoHttpCliOpt_BodyBuf,
+
+    /* Capacity of the user supplied body buffer, or if it's not
+       set, the maximum body length to allocate, 0 means no limit. */
+    EcoHttpCliOpt_BodyCap,
+
+    /* Overflow policy of body buffer, see `EcoBodyOverflow`. */
+    EcoHttpCliOpt_BodyOverflow,
+
+    /* Set initial receive buffer capacity (in bytes), which
+       is also the capacity it shrinks back to when idle.
+       The maximum capacity is raised to it if smaller.
+       `EcoRes_Again` is returned while a pulled or paused
+       body is unfinished. */
+    EcoHttpCliOpt_RcvBufCap,
+
+    /* Set maximum receive buffer capacity (in bytes), which
+       must not be less than the initial one. Setting it
+       to the initial capacity disables adaptive sizing. */
+    EcoHttpCliOpt_RcvBufMaxCap,
+
+    /* Return from `EcoHttpCli_Issue` once the response head is
+       parsed, and leave the body to be pulled by the caller
+       with `EcoHttpCli_ReadBody`. This takes precedence over
+       the body buffer and the body write hook. */
+    EcoHttpCliOpt_PullBody,
+
+    /* Maximum length (in bytes) of an abandoned body to drain
+       for keeping the channel alive, the channel is closed
+       instead if more is left. 0 means always closing. */
+    EcoHttpCliOpt_DrainMaxLen,
+
+    /* Maximum time (in milliseconds) to drain an abandoned body,
+       the channel is closed if it expires. 0 means no limit. */
+    EcoHttpCliOpt_DrainTimeout,
+
+    /* Response header filter mode, see `EcoHdrFilter`. Headers
+       filtered out are still parsed and passed to the header
+       line hook, but not added to the header table. */
+    EcoHttpCliOpt_RspHdrFilter,
+
+    /* Header table whose keys are the header names to filter,
+       values are ignored. It will be deleted by the client. */
+    EcoHttpCliOpt_RspHdrFilterTab,
+
+    /* Parse responses leniently, which is only meant for trusted
+       servers: bytes of status and header lines aren't checked
+       against their charsets, bare LF ends a line, and complete
+       lines are scanned in bulk. Strict parsing is the default. */
+    EcoHttpCliOpt_LenientParse,
+
+    EcoHttpCliOpt_RspStatHookArg,
+    EcoHttpCliOpt_RspStatHook,
+
+    EcoHttpCliOpt_RspHdrLineHookArg,
+    EcoHttpCliOpt_RspHdrLineHook,
+
+    /* Host name resolving hook, which is required
+       for requests to a host name. */
+    EcoHttpCliOpt_ResolveHookArg,
+    EcoHttpCliOpt_ResolveHook,
 } EcoHttpCliOpt;
 
 typedef void * EcoArg;
 
 typedef enum _EcoChanOpt {
     EcoChanOpt_SyncReadWrite,
+
+    /* Timeout (in milliseconds) of the next read or write,
+       passed as `(EcoArg)(size_t)ms`. */
     EcoChanOpt_ReadWriteTimeout,
+
+    /* Timeout (in milliseconds) of the next channel open,
+       passed as `(EcoArg)(size_t)ms`. */
+    EcoChanOpt_ConnTimeout,
 } EcoChanOpt;
 
 typedef struct _EcoKvp {
+
+    /* Canonical lowercase key, which is used for hashing and lookup. */
     char *keyBuf;
+
     char *valBuf;
     size_t keyLen;
     size_t valLen;
     uint32_t keyHash;
+
+    /* Maximum key and value lengths the owned buffers can hold. */
+    size_t keyCap;
+    size_t valCap;
+
+    /* Wire-case key such as `Content-Length`, which lives in the same
+       allocation as `keyBuf` and is computed on first use by
+       `EcoKvp_GetWireKey()`, `NULL` until then. */
+    char *wireKeyBuf;
+
+    /* Flags. */
+
+    /* Key or value is referenced rather than owned by the table. */
+    uint32_t keyRef: 1;
+    uint32_t valRef: 1;
+
+    /* Wire-case key has its own allocation. */
+    uint32_t wireKeyOwned: 1;
+
+    /* Generated by client, and refreshed whenever request changes. */
+    uint32_t autoGen: 1;
 } EcoKvp;
 
 typedef struct _EcoHdrTab {
     EcoKvp *kvpAry;
     size_t kvpCap;
     size_t kvpNum;
+
+    /* Slots in `[kvpNum, slotNum)` are unused,
+       but keep their buffers for later reuse. */
+    size_t slotNum;
+
+    /* Incremented on every change made through `EcoHdrTab_*()`,
+       so users of the table can tell if their cache is stale. */
+    uint32_t modCnt;
 } EcoHdrTab;
 
+typedef enum _EcoChanAddrType {
+    EcoChanAddrType_Ipv4,
+    EcoChanAddrType_Unix,
+
+    /* Host name, which is resolved to IP addresses
+       by the client right before opening the channel. */
+    EcoChanAddrType_Name,
+
+    EcoChanAddrType_Ipv6,
+} EcoChanAddrType;
+
+typedef enum _EcoIpVer {
+    EcoIpVer_4,
+    EcoIpVer_6,
+} EcoIpVer;
+
+/* IP address of either version. */
+typedef struct _EcoIpAddr {
+    EcoIpVer ver;
+
+    /* Only the first 4 bytes are used by IPv4. */
+    uint8_t buf[16];
+} EcoIpAddr;
+
+/* Maximum number of resolved addresses of a host name. */
+#define ECO_CHAN_IP_MAX_NUM         8
+
+/* Maximum length of Unix domain socket path,
+   which is limited by `sun_path` of `sockaddr_un`. */
+#define ECO_CHAN_SOCK_PATH_MAX_LEN  (108 - 1)
+#define ECO_CHAN_SOCK_PATH_BUF_LEN  (ECO_CHAN_SOCK_PATH_MAX_LEN + 1)
+
+/* Maximum length of host name, which is 253 in DNS. */
+#define ECO_CHAN_NAME_MAX_LEN       (256 - 1)
+#define ECO_CHAN_NAME_BUF_LEN       (ECO_CHAN_NAME_MAX_LEN + 1)
+
+/* Maximum length of `Host` header value, which is a host
+   name, an IPv4 or a bracketed IPv6 address with port. */
+#define ECO_CHAN_HOST_MAX_LEN       (ECO_CHAN_NAME_MAX_LEN + 8)
+#define ECO_CHAN_HOST_BUF_LEN       (ECO_CHAN_HOST_MAX_LEN + 1)
+
 typedef struct _EcoChanAddr {
+
+    /* IPv4 address, only used when `type` is `EcoChanAddrType_Ipv4`. */
     uint8_t addr[4];
     uint16_t port;
+
+    /* IPv6 address, only used when `type` is `EcoChanAddrType_Ipv6`. */
+    uint8_t addr6[16];
+
+    EcoChanAddrType type;
+
+    /* Unix domain socket path, only used when
+       `type` is `EcoChanAddrType_Unix`. */
+    char sockPath[ECO_CHAN_SOCK_PATH_BUF_LEN];
+    size_t sockPathLen;
+
+    /* Lowercase host name, only used when
+       `type` is `EcoChanAddrType_Name`. */
+    char name[ECO_CHAN_NAME_BUF_LEN];
+    size_t nameLen;
+
+    /* Resolved addresses of the host name in order
+       of preference, which are filled by the client. */
+    EcoIpAddr ipAry[ECO_CHAN_IP_MAX_NUM];
+    size_t ipNum;
+
+    /* Value of `Host` header, which is rendered
+       whenever the address is changed. */
+    char hostBuf[ECO_CHAN_HOST_BUF_LEN];
+    size_t hostLen;
 } EcoChanAddr;
 
+/* URL parsed once and applied to many requests. */
+typedef struct _EcoUrl {
+    EcoScheme scheme;
+    EcoChanAddr chanAddr;
+
+    /* Path and query string, both null-terminated,
+       are stored at offsets in a single buffer. */
+    char *strBuf;
+    size_t pathOff;
+    size_t pathLen;
+    size_t queryOff;
+    size_t queryLen;
+
+    /* Flags. */
+    uint32_t pathSet: 1;
+    uint32_t querySet: 1;
+} EcoUrl;
+
 typedef struct _EcoHttpReq {
     EcoScheme scheme;
     EcoHttpMeth meth;
     EcoChanAddr chanAddr;
 
     char *pathBuf;
+    size_t pathCap;
     size_t pathLen;
 
     char *queryBuf;
+    size_t queryCap;
     size_t queryLen;
 
     EcoHttpVer ver;
@@ -183,6 +431,31 @@ typedef struct _EcoHttpReq {
     /* Body field is not dynamicly allocated. */
     uint8_t *bodyBuf;
     size_t bodyLen;
+
+    /* Form-urlencoded body built by `EcoHttpReq_AddFormParam`,
+       which `bodyBuf` points to while the form is in use. */
+    char *formBuf;
+    size_t formCap;
+    size_t formLen;
+
+    /* Deadlines in milliseconds, 0 means no deadline. */
+    uint32_t connTimeout;
+    uint32_t firstByteTimeout;
+    uint32_t totalTimeout;
+
+    /* Value of auto-generated `Content-Length` header. */
+    char contLenBuf[24];
+
+    /* Rendered start line, header lines and empty line, which is
+       reused until an option or the header table is changed. */
+    uint8_t *headBuf;
+    size_t headCap;
+    size_t headLen;
+    uint32_t headModCnt;
+
+    /* Flags. */
+    uint32_t headKeepAlive: 1;
+    uint32_t headValid: 1;
 } EcoHttpReq;
 
 typedef enum _EcoStatCode {
@@ -202,11 +475,32 @@ typedef struct _EcoHttpRsp {
     EcoHdrTab *hdrTab;
     size_t contLen;
     uint8_t *bodyBuf;
+    size_t bodyCap;
     size_t bodyLen;
+
+    /* Flags. */
+
+    /* Body buffer is supplied by user rather than owned. */
+    uint32_t bodyRef: 1;
 } EcoHttpRsp;
 
 typedef EcoRes (*EcoChanOpenHook)(EcoChanAddr *addr, EcoArg arg);
 
+/**
+ * @brief User defined host name resolving hook function.
+ * 
+ * @param name Lowercase host name.
+ * @param ipAry Buffer to store the resolved addresses in order of preference.
+ * @param ipNum Capacity of `ipAry` on input, number of addresses on output.
+ * @param timeout Timeout in milliseconds, 0 means no timeout.
+ * @param arg Extra user data which can be set by option `EcoHttpCliOpt_ResolveHookArg`.
+ * 
+ * @return `EcoRes_Ok` for success, `EcoRes_Timeout` if the timeout
+ *         expires, otherwise an error code.
+ */
+typedef EcoRes (*EcoResolveHook)(const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                                 uint32_t timeout, EcoArg arg);
+
 typedef EcoRes (*EcoChanCloseHook)(EcoArg arg);
 
 /**
@@ -282,6 +576,49 @@ typedef EcoRes (*EcoRspHdrHook)(size_t hdrNum, size_t hdrIdx,
                                 const char *valBuf, size_t valLen,
                                 EcoArg arg);
 
+/* Decision made by streaming response hooks. */
+typedef enum _EcoRspAct {
+
+    /* Go on parsing the response. */
+    EcoRspAct_Continue = 0,
+
+    /* Go on parsing the response head, but abandon the body,
+       see `EcoHttpCli_AbandonBody`. */
+    EcoRspAct_SkipBody,
+
+    /* Stop parsing and close the channel, then
+       `EcoHttpCli_Issue` returns `EcoRes_Aborted`. */
+    EcoRspAct_Abort,
+} EcoRspAct;
+
+/**
+ * @brief User defined response status hook function, which is called
+ *        as soon as the status line is parsed.
+ * 
+ * @param ver HTTP version.
+ * @param statCode Status code.
+ * @param arg Extra user data which can be set by option `EcoHttpCliOpt_RspStatHookArg`.
+ * 
+ * @return What to do with the rest of the response.
+ */
+typedef EcoRspAct (*EcoRspStatHook)(EcoHttpVer ver, EcoStatCode statCode, EcoArg arg);
+
+/**
+ * @brief User defined response header line hook function, which is
+ *        called as soon as each header line is parsed.
+ * 
+ * @param keyBuf Lowercase header key string.
+ * @param keyLen Header key length.
+ * @param valBuf Header value string.
+ * @param valLen Header value length.
+ * @param arg Extra user data which can be set by option `EcoHttpCliOpt_RspHdrLineHookArg`.
+ * 
+ * @return What to do with the rest of the response.
+ */
+typedef EcoRspAct (*EcoRspHdrLineHook)(const char *keyBuf, size_t keyLen,
+                                       const char *valBuf, size_t valLen,
+                                       EcoArg arg);
+
 /**
  * @brief User defined body write hook function.
  * 
@@ -293,19 +630,75 @@ typedef EcoRes (*EcoRspHdrHook)(size_t hdrNum, size_t hdrIdx,
  * @param len Data length to write.
  * @param arg Extra user data which can be set by option `EcoOpt_BodyHookArg`.
  * 
- * @return The actual length of the written data.
- *         Negative numbers represent corresponding errors.
+ * @return The actual length of the written data, which can be less than `len`
+ *         to apply backpressure, as can `EcoRes_Again` when nothing is
+ *         written. Then `EcoHttpCli_Issue` returns `EcoRes_Again`, and the
+ *         rest is passed to the hook after `EcoHttpCli_Resume` is called.
+ *         Other negative numbers represent corresponding errors.
  */
 typedef int (*EcoBodyWriteHook)(int off, const void *buf, int len, EcoArg arg);
 
+/* A complete set of channel hooks with their argument,
+   which is used by channels decorating other channels. */
+typedef struct _EcoChanHooks {
+    EcoArg arg;
+    EcoChanOpenHook openHook;
+    EcoChanCloseHook closeHook;
+    EcoChanSetOptHook setOptHook;
+    EcoChanReadHook readHook;
+    EcoChanWriteHook writeHook;
+} EcoChanHooks;
+
+/* Statistics of a HTTP client, accumulated across issues. */
+typedef struct _EcoHttpCliStats {
+    uint64_t issueNum;          // Number of issues.
+    uint64_t readNum;           // Number of channel reads.
+    uint64_t rcvLen;            // Total length of received data.
+    size_t rcvBufCap;           // Current receive buffer capacity.
+    uint32_t rcvBufGrowNum;     // Number of times receive buffer grew.
+    uint32_t rcvBufShrinkNum;   // Number of times receive buffer shrank.
+    uint32_t bodyDrainNum;      // Number of abandoned bodies drained.
+    uint32_t bodyCloseNum;      // Number of abandoned bodies closed with channel.
+    uint64_t bodyDrainLen;      // Total length of drained body data.
+} EcoHttpCliStats;
+
+/* How an abandoned response body is dealt with. */
+typedef enum _EcoBodyAbandon {
+
+    /* Nothing was left to abandon. */
+    EcoBodyAbandon_None = 0,
+
+    /* The rest of body was drained, and the channel
+       is kept alive unless the server refused it. */
+    EcoBodyAbandon_Drain,
+
+    /* The channel was closed. */
+    EcoBodyAbandon_Close,
+} EcoBodyAbandon;
+
+/* Response parsing state, which is private to the client. */
+struct _ParseCache;
+
 typedef struct _EcoHttpCli {
     EcoHttpReq *req;
     EcoHttpRsp *rsp;
 
+    /* Kept across calls so that the body of
+       a response can be read after issuing. */
+    struct _ParseCache *parseCache;
+
     uint8_t *sndChunkBuf;   // Send chunk buffer.
     size_t sndChunkCap;     // Send chunk buffer capacity.
     size_t sndChunkLen;     // Send chunk buffer data length.
 
+    uint8_t *rcvBuf;        // Receive buffer.
+    size_t rcvBufCap;       // Receive buffer capacity.
+    size_t rcvBufMinCap;    // Capacity to shrink back to.
+    size_t rcvBufMaxCap;    // Capacity to grow up to.
+    size_t rcvPeakLen;      // Longest read into receive buffer of the current issue.
+    size_t rcvBufOff;       // Offset of unconsumed data in receive buffer.
+    size_t rcvBufLen;       // Length of received data in receive buffer.
+
     EcoArg chanHookArg;
     EcoChanOpenHook chanOpenHook;
     EcoChanCloseHook chanCloseHook;
@@ -322,9 +715,54 @@ typedef struct _EcoHttpCli {
     EcoArg bodyHookArg;
     EcoBodyWriteHook bodyWriteHook;
 
+    EcoArg rspStatHookArg;
+    EcoRspStatHook rspStatHook;
+
+    EcoArg rspHdrLineHookArg;
+    EcoRspHdrLineHook rspHdrLineHook;
+
+    EcoArg resolveHookArg;
+    EcoResolveHook resolveHook;
+
+    uint8_t *bodyBuf;
+    size_t bodyCap;
+    EcoBodyOverflow bodyOverflow;
+
+    size_t drainMaxLen;
+    uint64_t drainTimeout;
+
+    EcoHdrTab *rspHdrFilterTab;
+    EcoHdrFilter rspHdrFilter;
+
+    /* Absolute deadlines of the current issue on the
+       monotonic clock in milliseconds, 0 means none. */
+    uint64_t connDdl;
+    uint64_t firstByteDdl;
+    uint64_t totalDdl;
+
+    EcoHttpCliStats stats;
+
     /* Flags. */
     uint32_t chanOpened: 1;
     uint32_t keepAlive: 1;
+    uint32_t reuseRsp: 1;
+
+    /* The last read filled the whole receive buffer. */
+    uint32_t rcvBufFull: 1;
+
+    uint32_t pullBody: 1;
+
+    /* Body of the last response is yet to be pulled. */
+    uint32_t bodyPending: 1;
+
+    /* Body write hook has applied backpressure. */
+    uint32_t bodyPaused: 1;
+
+    uint32_t lenientParse: 1;
+
+    /* Channel may still hold a bounded budget pushed earlier. */
+    uint32_t connBudgetSet: 1;
+    uint32_t rwBudgetSet: 1;
 } EcoHttpCli;
 
 /**
@@ -372,6 +810,17 @@ void EcoHdrTab_Del(EcoHdrTab *tab);
  */
 EcoRes EcoHdrTab_Add(EcoHdrTab *tab, const char *key, const char *val);
 
+/**
+ * @brief Add a header whose key and value are referenced rather than copied.
+ * @note Both strings must outlive the header table, and the key must be
+ *       in lowercase. String literals are a typical choice.
+ * 
+ * @param tab Header table.
+ * @param key Lowercase key string.
+ * @param val Value string.
+ */
+EcoRes EcoHdrTab_AddStatic(EcoHdrTab *tab, const char *key, const char *val);
+
 /**
  * @brief Add a header to the header table.
  * @note `line` is a string consists both header key and value.
@@ -393,6 +842,14 @@ EcoRes EcoHdrTab_AddLine(EcoHdrTab *tab, const char *line);
  */
 EcoRes EcoHdrTab_AddFmt(EcoHdrTab *tab, const char *key, const char *fmt, ...);
 
+/**
+ * @brief Get wire-case key of the key-value pair, with the first
+ *        letter of each word capitalized.
+ * 
+ * @param kvp Key-value pair.
+ */
+const char *EcoKvp_GetWireKey(EcoKvp *kvp);
+
 /**
  * @brief Drop a key-value pair from the header table.
  * 
@@ -408,6 +865,14 @@ EcoRes EcoHdrTab_Drop(EcoHdrTab *tab, const char *key);
  */
 void EcoHdrTab_Clear(EcoHdrTab *tab);
 
+/**
+ * @brief Remove all key-value pairs in the header table,
+ *        but keep the allocated memory for reuse.
+ * 
+ * @param tab Header table.
+ */
+void EcoHdrTab_Reset(EcoHdrTab *tab);
+
 /**
  * @brief Find a key-value pair in the header table.
  * 
@@ -442,6 +907,14 @@ EcoHttpReq *EcoHttpReq_New(void);
  */
 void EcoHttpReq_Deinit(EcoHttpReq *req);
 
+/**
+ * @brief Restore a HTTP request to its initial state,
+ *        but keep the allocated memory for reuse.
+ * 
+ * @param req HTTP request.
+ */
+void EcoHttpReq_Reset(EcoHttpReq *req);
+
 /**
  * @brief Delete a HTTP request.
  * @note This function will also delete the header table if it exists.
@@ -461,6 +934,73 @@ void EcoHttpReq_Del(EcoHttpReq *req);
  */
 EcoRes EcoHttpReq_SetOpt(EcoHttpReq *req, EcoHttpReqOpt opt, EcoArg arg);
 
+/**
+ * @brief Append a percent-encoded "key=value" pair to the query string
+ *        of a HTTP request, whose buffer grows geometrically.
+ * @note Query string can be cleared with `EcoHttpReqOpt_Query` set to `NULL`.
+ * 
+ * @param req HTTP request.
+ * @param key Key string, can't be empty.
+ * @param val Value string, can be empty.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoHttpReq_AddQueryParam(EcoHttpReq *req, const char *key, const char *val);
+
+/**
+ * @brief Append a percent-encoded "key=value" pair to the
+ *        `application/x-www-form-urlencoded` body of a HTTP request.
+ * @note The request body is set to the form, and the form is
+ *       started over once the body has been replaced.
+ * 
+ * @param req HTTP request.
+ * @param key Key string, can't be empty.
+ * @param val Value string, can be empty.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoHttpReq_AddFormParam(EcoHttpReq *req, const char *key, const char *val);
+
+
+
+/**
+ * @brief Initialize a URL.
+ * 
+ * @param url URL.
+ */
+void EcoUrl_Init(EcoUrl *url);
+
+/**
+ * @brief Create a new URL.
+ */
+EcoUrl *EcoUrl_New(void);
+
+/**
+ * @brief Deinitialize a URL.
+ * 
+ * @param url URL.
+ */
+void EcoUrl_Deinit(EcoUrl *url);
+
+/**
+ * @brief Delete a URL.
+ * 
+ * @param url URL.
+ */
+void EcoUrl_Del(EcoUrl *url);
+
+/**
+ * @brief Parse a URL string, which can then be applied to
+ *        requests with `EcoHttpReqOpt_ParsedUrl`.
+ * @note The URL is kept as is if parsing fails.
+ * 
+ * @param url URL.
+ * @param str URL string.
+ * 
+ * @return `EcoRes_Ok` for success, otherwise an error code.
+ */
+EcoRes EcoUrl_Parse(EcoUrl *url, const char *str);
+
 
 
 /**
@@ -482,6 +1022,14 @@ EcoHttpRsp *EcoHttpRsp_New(void);
  */
 void EcoHttpRsp_Deinit(EcoHttpRsp *rsp);
 
+/**
+ * @brief Restore a HTTP response to its initial state,
+ *        but keep the allocated memory for reuse.
+ * 
+ * @param rsp HTTP response.
+ */
+void EcoHttpRsp_Reset(EcoHttpRsp *rsp);
+
 /**
  * @brief Delete a HTTP response.
  * @note This function will also delete the header
@@ -531,13 +1079,74 @@ void EcoHttpCli_Del(EcoHttpCli *cli);
  */
 EcoRes EcoHttpCli_SetOpt(EcoHttpCli *cli, EcoHttpCliOpt opt, EcoArg arg);
 
+/**
+ * @brief Get all channel hooks of a HTTP client.
+ * 
+ * @param cli HTTP client.
+ * @param hooks Channel hooks.
+ */
+void EcoHttpCli_GetChanHooks(EcoHttpCli *cli, EcoChanHooks *hooks);
+
+/**
+ * @brief Set all channel hooks of a HTTP client.
+ * 
+ * @param cli HTTP client.
+ * @param hooks Channel hooks.
+ */
+void EcoHttpCli_SetChanHooks(EcoHttpCli *cli, const EcoChanHooks *hooks);
+
 /**
  * @brief Issue a HTTP request.
+ * @note If any deadline of the request expires, the channel will be closed
+ *       and `EcoRes_Timeout` will be returned.
  * 
  * @param cli HTTP client.
  * 
- * @return `EcoRes_Ok` for success, otherwise an error code.
+ * @return `EcoRes_Ok` for success, `EcoRes_Again` if body write hook
+ *         applies backpressure, otherwise an error code.
  */
 EcoRes EcoHttpCli_Issue(EcoHttpCli *cli);
 
+/**
+ * @brief Resume the last issue paused by body write hook.
+ * @note The deadlines of the issue still apply. If it isn't resumed
+ *       before the next issue, the body will be abandoned.
+ * 
+ * @param cli HTTP client.
+ * 
+ * @return `EcoRes_Ok` when the response ends or nothing is paused,
+ *         `EcoRes_Again` when body write hook applies backpressure
+ *         again, otherwise an error code.
+ */
+EcoRes EcoHttpCli_Resume(EcoHttpCli *cli);
+
+/**
+ * @brief Abandon the rest of body of the last response, which is pending
+ *        to be pulled, or paused by body write hook.
+ * @note It's called by `EcoHttpCli_Issue` if the last body is left
+ *       unfinished. Depending on options `EcoHttpCliOpt_DrainMaxLen` and
+ *       `EcoHttpCliOpt_DrainTimeout`, the rest of body is either drained
+ *       to keep the channel alive, or the channel is closed.
+ * 
+ * @param cli HTTP client.
+ * 
+ * @return How the body has been dealt with.
+ */
+EcoBodyAbandon EcoHttpCli_AbandonBody(EcoHttpCli *cli);
+
+/**
+ * @brief Read body data of the last response, which is available
+ *        when option `EcoHttpCliOpt_PullBody` is enabled.
+ * @note The total deadline of the issue also covers these reads. If the
+ *       body isn't fully read before the next issue, it will be abandoned.
+ * 
+ * @param cli HTTP client.
+ * @param buf Buffer to store body data.
+ * @param len Buffer length.
+ * 
+ * @return The actual length of the read data, 0 when the body has been
+ *         fully read, or a negative error code.
+ */
+int EcoHttpCli_ReadBody(EcoHttpCli *cli, void *buf, int len);
+
 #endif
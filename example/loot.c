@@ -1,6 +1,4 @@
-#include <sys/socket.h>
 #include <sys/types.h>
-#include <arpa/inet.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -13,6 +11,13 @@
 #include <stdio.h>
 
 #include "echo.h"
+#include "conf.h"
+#include "chan_sock.h"
+#include "dns.h"
+
+#if ECO_CONF_TLS
+#include "chan_tls.h"
+#endif
 
 static bool gHelpNeeded = false;
 
@@ -26,6 +31,10 @@ static int gUrlArgIdx = -1;
 
 static int gUrlArgNum = 0;
 
+static size_t gMaxTime = 0;
+
+static bool gInsecure = false;
+
 #define EOL "\n"
 
 #define VERSION_MAJOR "1"
@@ -51,6 +60,12 @@ static int gUrlArgNum = 0;
                 EOL \
                 "    -H, --header" EOL \
                 "        Request header." EOL \
+                EOL \
+                "    -m, --max-time" EOL \
+                "        Maximum time in milliseconds for each request." EOL \
+                EOL \
+                "    -k, --insecure" EOL \
+                "        Skip TLS peer certificate verification." EOL \
 
 #define Log(fmt, ...) \
     fprintf(gLogFileStm, fmt EOL, ##__VA_ARGS__)
@@ -82,6 +97,8 @@ static int ParseParam(int argc, char **argv) {
             { "help", no_argument, NULL, 'h'},
             { "output-file", required_argument, NULL, 'o'},
             { "header", required_argument, NULL, 'H'},
+            { "max-time", required_argument, NULL, 'm'},
+            { "insecure", no_argument, NULL, 'k'},
             { NULL, 0, NULL, 0}
         };
         EcoRes res;
@@ -90,7 +107,7 @@ static int ParseParam(int argc, char **argv) {
 
         opterr = 0;
 
-        ch = getopt_long(argc, argv, "ho:H:", longOpts, &optIdx);
+        ch = getopt_long(argc, argv, "ho:H:m:k", longOpts, &optIdx);
         if (ch == -1) {
             break;
         }
@@ -134,6 +151,16 @@ static int ParseParam(int argc, char **argv) {
 
                 break;
 
+            case 'm':
+                gMaxTime = (size_t)strtoul(optarg, NULL, 10);
+
+                break;
+
+            case 'k':
+                gInsecure = true;
+
+                break;
+
             case '?':
                 Log("Unknown option \"%s\"!", argv[optind - 1]);
 
@@ -167,7 +194,7 @@ static void ShowReqHeader(void) {
     for (size_t i = 0; i < gReqHdrTab->kvpNum; i++) {
         EcoKvp *kvp = gReqHdrTab->kvpAry + i;
 
-        Log("    %s: %s", kvp->keyBuf, kvp->valBuf);
+        Log("    %s: %s", EcoKvp_GetWireKey(kvp), kvp->valBuf);
     }
 }
 
@@ -182,90 +209,6 @@ static void DeinitParam(void) {
     }
 }
 
-EcoRes LootChanOpenHook(EcoChanAddr *addr, void *arg) {
-    struct sockaddr_in srvAddr;
-    int opt = 1;
-    int sockFd;
-    int ret;
-
-    sockFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (sockFd == -1) {
-        return EcoRes_Err;
-    }
-
-    ret = setsockopt(sockFd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt));
-    if (ret != 0) {
-        close(sockFd);
-
-        return EcoRes_Err;
-    }
-
-    srvAddr.sin_family = AF_INET;
-    srvAddr.sin_port = htons(addr->port);
-    memcpy(&srvAddr.sin_addr, &addr->addr, 4);
-
-    ret = connect(sockFd, (struct sockaddr *)&srvAddr, sizeof(srvAddr));
-    if (ret != 0) {
-        close(sockFd);
-
-        return EcoRes_Err;
-    }
-
-    *(int *)arg = sockFd;
-
-    return EcoRes_Ok;
-}
-
-int LootChanReadHook(void *buf, int len, void *arg) {
-    int sockFd;
-    int ret;
-
-    sockFd = *(int *)arg;
-
-    ret = (int)read(sockFd, buf, (size_t)len);
-    if (ret <= 0) {
-        if (ret == 0) {
-            return EcoRes_ReachEnd;
-        }
-
-        return EcoRes_Err;
-    }
-
-    return ret;
-}
-
-int LootChanWriteHook(const void *buf, int len, void *arg) {
-    int sockFd;
-    int ret;
-
-    sockFd = *(int *)arg;
-
-    ret = (int)write(sockFd, buf, (size_t)len);
-    if (ret <= 0) {
-        if (ret == 0) {
-            return EcoRes_ReachEnd;
-        }
-
-        return EcoRes_Err;
-    }
-
-    return ret;
-}
-
-EcoRes LootChanCloseHook(void *arg) {
-    int sockFd;
-    int ret;
-
-    sockFd = *(int *)arg;
-
-    ret = close(sockFd);
-    if (ret != 0) {
-        return EcoRes_Err;
-    }
-
-    return EcoRes_Ok;
-}
-
 static int SaveToFile(EcoHttpRsp *rsp, const char *path) {
     ssize_t wrLen;
     int fd;
@@ -292,9 +235,14 @@ static int SaveToFile(EcoHttpRsp *rsp, const char *path) {
 }
 
 int main(int argc, char **argv) {
+#if ECO_CONF_TLS
+    EcoChanTlsCtx tlsCtx;
+    EcoChanTls tls;
+#endif
+    EcoChanSock sock;
     EcoHttpReq *req;
+    EcoDns dns;
     EcoHttpCli *cli;
-    int socketFd;
     EcoRes res;
     int ret;
 
@@ -334,14 +282,33 @@ int main(int argc, char **argv) {
 
     ShowReqHeader();
 
-    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanHookArg, &socketFd);
-    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanOpenHook, LootChanOpenHook);
-    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanCloseHook, LootChanCloseHook);
-    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanReadHook, LootChanReadHook);
-    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanWriteHook, LootChanWriteHook);
+    EcoChanSock_Init(&sock);
+
+    res = EcoDns_Init(&dns);
+    if (res != EcoRes_Ok) {
+        Log("Failed to create resolver!");
+
+        return EXIT_FAILURE;
+    }
+
+    EcoDns_Apply(&dns, cli);
+
+#if ECO_CONF_TLS
+    res = EcoChanTlsCtx_Init(&tlsCtx);
+    if (res != EcoRes_Ok) {
+        Log("Failed to create TLS context!");
+
+        return EXIT_FAILURE;
+    }
+
+    EcoChanTlsCtx_SetOpt(&tlsCtx, EcoChanTlsCtxOpt_VerifyPeer, (EcoArg)(size_t)!gInsecure);
+
+    EcoChanTls_Init(&tls, &tlsCtx);
+#endif
 
     EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Version, (EcoArg)EcoHttpVer_1_1);
     EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Method, (EcoArg)EcoHttpMeth_Get);
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_TotalTimeout, (EcoArg)gMaxTime);
 
     if (gUrlArgNum != 0) {
         for (int i = gUrlArgIdx; i < argc; i++) {
@@ -352,6 +319,19 @@ int main(int argc, char **argv) {
                 continue;
             }
 
+            /* Choose channel by scheme. */
+            if (req->scheme == EcoScheme_Https) {
+#if ECO_CONF_TLS
+                EcoChanTls_Apply(&tls, cli);
+#else
+                Log("Failed to issue URL \"%s\": HTTPS is not supported.", argv[i]);
+
+                continue;
+#endif
+            } else {
+                EcoChanSock_Apply(&sock, cli);
+            }
+
             Log("Issuing URL \"%s\"...", argv[i]);
 
             res = EcoHttpCli_Issue(cli);
@@ -378,5 +358,12 @@ int main(int argc, char **argv) {
 
     EcoHttpCli_Del(cli);
 
+    EcoDns_Deinit(&dns);
+
+#if ECO_CONF_TLS
+    EcoChanTls_Deinit(&tls);
+    EcoChanTlsCtx_Deinit(&tlsCtx);
+#endif
+
     DeinitParam();
 }
@@ -0,0 +1,1743 @@
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "echo.h"
+#include "chan_sock.h"
+#include "chan_mem.h"
+#include "chan_emu.h"
+#include "chan_rec.h"
+
+#include "greatest.h"
+
+/* Channel stub which behaves like a hung upstream. */
+typedef struct _HungChan {
+    size_t connTimeout;
+    size_t rwTimeout;
+    int openNum;
+    int closeNum;
+    bool openHangs;
+} HungChan;
+
+static EcoRes HungChanOpenHook(EcoChanAddr *addr, EcoArg arg) {
+    HungChan *chan = (HungChan *)arg;
+
+    (void)addr;
+
+    chan->openNum++;
+
+    if (chan->openHangs) {
+        usleep(chan->connTimeout * 1000);
+
+        return EcoRes_BadChanOpen;
+    }
+
+    return EcoRes_Ok;
+}
+
+static EcoRes HungChanCloseHook(EcoArg arg) {
+    HungChan *chan = (HungChan *)arg;
+
+    chan->closeNum++;
+
+    return EcoRes_Ok;
+}
+
+static EcoRes HungChanSetOptHook(EcoChanOpt opt, EcoArg arg, EcoArg hookArg) {
+    HungChan *chan = (HungChan *)hookArg;
+
+    switch (opt) {
+    case EcoChanOpt_ConnTimeout:
+        chan->connTimeout = (size_t)arg;
+        break;
+
+    case EcoChanOpt_ReadWriteTimeout:
+        chan->rwTimeout = (size_t)arg;
+        break;
+
+    default:
+        return EcoRes_BadOpt;
+    }
+
+    return EcoRes_Ok;
+}
+
+static int HungChanReadHook(void *buf, int len, EcoArg arg) {
+    HungChan *chan = (HungChan *)arg;
+
+    (void)buf;
+    (void)len;
+
+    /* Wait until the pushed timeout expires, like a socket would do. */
+    usleep(chan->rwTimeout * 1000);
+
+    return EcoRes_BadChanRead;
+}
+
+static int HungChanWriteHook(const void *buf, int len, EcoArg arg) {
+    (void)buf;
+    (void)arg;
+
+    return len;
+}
+
+static EcoHttpCli *NewHungCli(HungChan *chan) {
+    EcoHttpCli *cli;
+
+    cli = EcoHttpCli_New();
+    if (cli == NULL) {
+        return NULL;
+    }
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanHookArg, chan);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanOpenHook, HungChanOpenHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanCloseHook, HungChanCloseHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanSetOptHook, HungChanSetOptHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanReadHook, HungChanReadHook);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanWriteHook, HungChanWriteHook);
+
+    return cli;
+}
+
+TEST ExpireFirstByteDeadline(void) {
+    HungChan chan = {0};
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    EcoRes res;
+
+    cli = NewHungCli(&chan);
+    ASSERT_NEQ(NULL, cli);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_FirstByteTimeout, (EcoArg)(size_t)20);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_TotalTimeout, (EcoArg)(size_t)1000);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Timeout, res, "%d");
+    ASSERT_GT(chan.rwTimeout, 0);
+    ASSERT_LTE(chan.rwTimeout, 20);
+    ASSERT_EQ_FMT(1, chan.openNum, "%d");
+    ASSERT_EQ_FMT(1, chan.closeNum, "%d");
+
+    EcoHttpCli_Del(cli);
+
+    PASS();
+}
+
+TEST ExpireConnDeadline(void) {
+    HungChan chan = {0};
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    EcoRes res;
+
+    chan.openHangs = true;
+
+    cli = NewHungCli(&chan);
+    ASSERT_NEQ(NULL, cli);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_ConnTimeout, (EcoArg)(size_t)10);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Timeout, res, "%d");
+    ASSERT_GT(chan.connTimeout, 0);
+    ASSERT_LTE(chan.connTimeout, 10);
+    ASSERT_EQ_FMT(1, chan.openNum, "%d");
+
+    EcoHttpCli_Del(cli);
+
+    PASS();
+}
+
+/**
+ * @brief Serve canned responses on a Unix domain socket in a child process.
+ * @note Each response is written up to its stall offset, the rest follows
+ *       after the stall.
+ */
+static pid_t ServeUnixSock(const char *path, const char *const *rspAry,
+                           const size_t *stallOffAry, int rspNum, int stallMs) {
+    struct sockaddr_un addr;
+    char reqBuf[1024];
+    size_t reqLen;
+    size_t rspLen;
+    size_t offLen;
+    int lsnFd;
+    int fd;
+    pid_t pid;
+    int i;
+
+    unlink(path);
+
+    lsnFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lsnFd == -1) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if (bind(lsnFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(lsnFd, 1) != 0) {
+        close(lsnFd);
+
+        return -1;
+    }
+
+    pid = fork();
+    if (pid != 0) {
+        close(lsnFd);
+
+        return pid;
+    }
+
+    fd = accept(lsnFd, NULL, NULL);
+    if (fd == -1) {
+        _exit(1);
+    }
+
+    for (i = 0; i < rspNum; i++) {
+        reqLen = 0;
+
+        /* Wait for the whole request head. */
+        while (reqLen < sizeof(reqBuf) - 1) {
+            ssize_t ret = read(fd, reqBuf + reqLen, sizeof(reqBuf) - 1 - reqLen);
+            if (ret <= 0) {
+                break;
+            }
+
+            reqLen += (size_t)ret;
+            reqBuf[reqLen] = '\0';
+
+            if (strstr(reqBuf, "\r\n\r\n") != NULL) {
+                break;
+            }
+        }
+
+        rspLen = strlen(rspAry[i]);
+        offLen = stallOffAry != NULL && stallOffAry[i] < rspLen ? stallOffAry[i] : rspLen;
+
+        write(fd, rspAry[i], offLen);
+
+        if (offLen != rspLen) {
+            usleep(stallMs * 1000);
+
+            write(fd, rspAry[i] + offLen, rspLen - offLen);
+        }
+    }
+
+    close(fd);
+
+    _exit(0);
+}
+
+/**
+ * @brief Serve one canned response on a Unix domain socket in a child process.
+ */
+static pid_t ServeUnixSockOnce(const char *path, const char *rsp) {
+    return ServeUnixSock(path, &rsp, NULL, 1, 0);
+}
+
+TEST IssueOverUnixSock(void) {
+    EcoChanSock sock;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    char path[64];
+    EcoRes res;
+    pid_t pid;
+    int stat;
+
+    snprintf(path, sizeof(path), "/tmp/echo-test-%d.sock", (int)getpid());
+
+    pid = ServeUnixSockOnce(path, "HTTP/1.1 200 OK\r\n"
+                                  "Content-Length: 5\r\n"
+                                  "\r\n"
+                                  "hello");
+    ASSERT_GT(pid, 0);
+
+    EcoChanSock_Init(&sock);
+
+    cli = EcoHttpCli_New();
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanSock_Apply(&sock, cli);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_SockPath, path);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoStatCode_Ok, cli->rsp->statCode, "%d");
+    ASSERT_EQ_FMT(5UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("hello", cli->rsp->bodyBuf, 5);
+
+    waitpid(pid, &stat, 0);
+    unlink(path);
+
+    EcoHttpCli_Del(cli);
+
+    PASS();
+}
+
+TEST ClearExpiredBudget(void) {
+    static const char rspMsg[] = "HTTP/1.1 200 OK\r\n"
+                                 "Content-Length: 5\r\n"
+                                 "\r\n"
+                                 "hello";
+    const char *rspAry[2] = {rspMsg, rspMsg};
+    size_t stallOffAry[2];
+    EcoChanSock sock;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    char path[64];
+    EcoRes res;
+    pid_t pid;
+    int stat;
+
+    snprintf(path, sizeof(path), "/tmp/echo-test-%d.sock", (int)getpid());
+
+    /* Stall the body after the first byte, then stall the second response
+       before its first byte, both longer than the first byte timeout. */
+    stallOffAry[0] = sizeof(rspMsg) - 1 - 4;
+    stallOffAry[1] = 0;
+
+    pid = ServeUnixSock(path, rspAry, stallOffAry, 2, 100);
+    ASSERT_GT(pid, 0);
+
+    EcoChanSock_Init(&sock);
+
+    cli = EcoHttpCli_New();
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanSock_Apply(&sock, cli);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_SockPath, path);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    /* Only the first byte is bounded, not the rest of the body. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_FirstByteTimeout, (EcoArg)(size_t)50);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(5UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("hello", cli->rsp->bodyBuf, 5);
+
+    /* The kept-alive channel must not keep the budget of the last issue. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_FirstByteTimeout, (EcoArg)(size_t)0);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(5UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("hello", cli->rsp->bodyBuf, 5);
+
+    waitpid(pid, &stat, 0);
+    unlink(path);
+
+    EcoHttpCli_Del(cli);
+
+    PASS();
+}
+
+TEST RaceConnAttempts(void) {
+    struct timespec begTs, endTs;
+    struct sockaddr_storage peer;
+    struct sockaddr_in6 addr6;
+    struct sockaddr_in addr4;
+    EcoChanAddr chanAddr;
+    socklen_t addrLen;
+    EcoChanSock sock;
+    uint64_t elapsedMs;
+    int holeFd;
+    int fillFd;
+    int lsnFd;
+    int opt = 1;
+    EcoRes res;
+
+    /* IPv4 listener with a full backlog drops handshakes,
+       which looks like a black-holed address. */
+    holeFd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_NEQ(-1, holeFd);
+
+    memset(&addr4, 0, sizeof(addr4));
+    addr4.sin_family = AF_INET;
+    addr4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    addrLen = sizeof(addr4);
+    ASSERT_EQ(0, bind(holeFd, (struct sockaddr *)&addr4, sizeof(addr4)));
+    ASSERT_EQ(0, listen(holeFd, 0));
+    ASSERT_EQ(0, getsockname(holeFd, (struct sockaddr *)&addr4, &addrLen));
+
+    fillFd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, connect(fillFd, (struct sockaddr *)&addr4, sizeof(addr4)));
+
+    /* IPv6 listener on the same port is the healthy one. */
+    lsnFd = socket(AF_INET6, SOCK_STREAM, 0);
+    ASSERT_NEQ(-1, lsnFd);
+
+    setsockopt(lsnFd, IPPROTO_IPV6, IPV6_V6ONLY, &opt, sizeof(opt));
+
+    memset(&addr6, 0, sizeof(addr6));
+    addr6.sin6_family = AF_INET6;
+    addr6.sin6_addr = in6addr_loopback;
+    addr6.sin6_port = addr4.sin_port;
+
+    if (bind(lsnFd, (struct sockaddr *)&addr6, sizeof(addr6)) != 0 ||
+        listen(lsnFd, 8) != 0) {
+        close(lsnFd);
+        close(fillFd);
+        close(holeFd);
+
+        SKIPm("IPv6 loopback is unavailable");
+    }
+
+    memset(&chanAddr, 0, sizeof(chanAddr));
+    chanAddr.type = EcoChanAddrType_Name;
+    strcpy(chanAddr.name, "race.test");
+    chanAddr.nameLen = 9;
+    chanAddr.port = ntohs(addr4.sin_port);
+    chanAddr.ipAry[0].ver = EcoIpVer_4;
+    memcpy(chanAddr.ipAry[0].buf, &addr4.sin_addr, 4);
+    chanAddr.ipAry[1].ver = EcoIpVer_6;
+    memcpy(chanAddr.ipAry[1].buf, &addr6.sin6_addr, 16);
+    chanAddr.ipNum = 2;
+
+    EcoChanSock_Init(&sock);
+    EcoChanSock_SetOpt(&sock, EcoChanSockOpt_AttemptDelay, (EcoArg)(size_t)50);
+    EcoChanSock_SetOptHook(EcoChanOpt_ConnTimeout, (EcoArg)(size_t)5000, &sock);
+
+    clock_gettime(CLOCK_MONOTONIC, &begTs);
+
+    res = EcoChanSock_OpenHook(&chanAddr, &sock);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    clock_gettime(CLOCK_MONOTONIC, &endTs);
+
+    /* Black-holed address only costs the attempt delay. */
+    elapsedMs = (uint64_t)(((int64_t)endTs.tv_sec - (int64_t)begTs.tv_sec) * 1000 +
+                           ((int64_t)endTs.tv_nsec - (int64_t)begTs.tv_nsec) / 1000000);
+    ASSERT(elapsedMs >= 40);
+    ASSERT(elapsedMs < 2000);
+
+    addrLen = sizeof(peer);
+    ASSERT_EQ(0, getpeername(sock.fd, (struct sockaddr *)&peer, &addrLen));
+    ASSERT_EQ_FMT(AF_INET6, peer.ss_family, "%d");
+
+    EcoChanSock_Deinit(&sock);
+    close(lsnFd);
+    close(fillFd);
+    close(holeFd);
+
+    PASS();
+}
+
+static const char gRspMsg[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 26\r\n"
+    "X-Request-Id: 1b4e28ba-2fa1-11d2-883f-0016d3cca427\r\n"
+    "\r\n"
+    "abcdefghijklmnopqrstuvwxyz";
+
+/**
+ * @brief Create a client issuing to the URL over memory channel,
+ *        which answers each request with the given response.
+ * 
+ * @return The client, or `NULL` on failure.
+ */
+static EcoHttpCli *NewMemCli(EcoChanMem *mem, const char *rspBuf, size_t rspLen, const char *url) {
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+
+    EcoChanMem_Init(mem);
+    EcoChanMem_SetOpt(mem, EcoChanMemOpt_RspBuf, (EcoArg)rspBuf);
+    EcoChanMem_SetOpt(mem, EcoChanMemOpt_RspLen, (EcoArg)rspLen);
+
+    cli = EcoHttpCli_New();
+    if (cli == NULL) {
+        return NULL;
+    }
+
+    EcoChanMem_Apply(mem, cli);
+
+    req = EcoHttpReq_New();
+    if (req == NULL) {
+        EcoHttpCli_Del(cli);
+
+        return NULL;
+    }
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+
+    if (EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, (EcoArg)url) != EcoRes_Ok) {
+        EcoHttpCli_Del(cli);
+
+        return NULL;
+    }
+
+    return cli;
+}
+
+/**
+ * @brief Issue a request over memory channel and check the parsed response.
+ */
+static enum greatest_test_res IssueOverMemChan(EcoChanMemFrag frag, size_t fragLen, bool keepAlive) {
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoKvp *kvp;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/index.html?a=1");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)frag);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)fragLen);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)keepAlive);
+
+    for (int i = 0; i < 3; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ_FMT(EcoHttpVer_1_1, cli->rsp->ver, "%d");
+        ASSERT_EQ_FMT(EcoStatCode_Ok, cli->rsp->statCode, "%d");
+        ASSERT_EQ_FMT(3UL, cli->rsp->hdrTab->kvpNum, "%zu");
+
+        res = EcoHdrTab_Find(cli->rsp->hdrTab, "x-request-id", &kvp);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_STR_EQ("1b4e28ba-2fa1-11d2-883f-0016d3cca427", kvp->valBuf);
+
+        ASSERT_EQ_FMT(26UL, cli->rsp->bodyLen, "%zu");
+        ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", cli->rsp->bodyBuf, 26);
+
+        ASSERT(mem.reqLen > 0);
+        ASSERT_MEM_EQ("GET /index.html?a=1 HTTP/1.1\r\n", mem.reqBuf, 30);
+        ASSERT_MEM_EQ("\r\n\r\n", mem.reqBuf + mem.reqLen - 4, 4);
+    }
+
+    ASSERT_EQ_FMT(keepAlive ? 1U : 3U, mem.openNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST ParseFragmentedRsp(void) {
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_None, 0, false));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_None, 0, true));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 1, false));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 1, true));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 2, false));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 2, true));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 7, false));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 7, true));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 1460, false));
+    CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Fixed, 1460, true));
+
+    for (int i = 0; i < 16; i++) {
+        CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Random, 1 + i * 4, false));
+        CHECK_CALL(IssueOverMemChan(EcoChanMemFrag_Random, 1 + i * 4, true));
+    }
+
+    PASS();
+}
+
+TEST EmulateSlowLink(void) {
+    struct timespec begTs;
+    struct timespec endTs;
+    uint64_t elapsedMs;
+    EcoChanEmu emu;
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/index.html?a=1");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanEmu_Init(&emu, NULL);
+    EcoChanEmu_SetOpt(&emu, EcoChanEmuOpt_Latency, (EcoArg)(size_t)5);
+    EcoChanEmu_SetOpt(&emu, EcoChanEmuOpt_MaxReadLen, (EcoArg)(size_t)7);
+    EcoChanEmu_SetOpt(&emu, EcoChanEmuOpt_MaxWriteLen, (EcoArg)(size_t)5);
+    EcoChanEmu_Wrap(&emu, cli);
+
+    clock_gettime(CLOCK_MONOTONIC, &begTs);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    clock_gettime(CLOCK_MONOTONIC, &endTs);
+
+    ASSERT_EQ_FMT(EcoStatCode_Ok, cli->rsp->statCode, "%d");
+    ASSERT_EQ_FMT(26UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", cli->rsp->bodyBuf, 26);
+    ASSERT_MEM_EQ("GET /index.html?a=1 HTTP/1.1\r\n", mem.reqBuf, 30);
+
+    /* Handshake and request each take a round trip. */
+    elapsedMs = (uint64_t)(((int64_t)endTs.tv_sec - (int64_t)begTs.tv_sec) * 1000 +
+                           ((int64_t)endTs.tv_nsec - (int64_t)begTs.tv_nsec) / 1000000);
+    ASSERT(elapsedMs >= 19);
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST BoundEmulatedWaits(void) {
+    static char rspMsg[64 + 1000];
+    struct timespec begTs;
+    struct timespec endTs;
+    uint64_t elapsedMs;
+    EcoChanEmu emu;
+    EcoChanMem mem;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    int headLen;
+    EcoRes res;
+
+    headLen = snprintf(rspMsg, sizeof(rspMsg), "HTTP/1.1 200 OK\r\n"
+                                               "Content-Length: 1000\r\n"
+                                               "\r\n");
+    memset(rspMsg + headLen, 'x', 1000);
+
+    cli = NewMemCli(&mem, rspMsg, (size_t)(headLen + 1000), "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    req = cli->req;
+
+    /* Handshake takes 200 ms, and the body takes 1 s. */
+    EcoChanEmu_Init(&emu, NULL);
+    EcoChanEmu_SetOpt(&emu, EcoChanEmuOpt_Latency, (EcoArg)(size_t)100);
+    EcoChanEmu_SetOpt(&emu, EcoChanEmuOpt_DownBandwidth, (EcoArg)(size_t)8000);
+    EcoChanEmu_Wrap(&emu, cli);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_ConnTimeout, (EcoArg)(size_t)30);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    clock_gettime(CLOCK_MONOTONIC, &begTs);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Timeout, res, "%d");
+
+    clock_gettime(CLOCK_MONOTONIC, &endTs);
+
+    elapsedMs = (uint64_t)(((int64_t)endTs.tv_sec - (int64_t)begTs.tv_sec) * 1000 +
+                           ((int64_t)endTs.tv_nsec - (int64_t)begTs.tv_nsec) / 1000000);
+    ASSERT(elapsedMs < 150);
+    ASSERT_EQ_FMT(0U, mem.openNum, "%u");
+
+    /* Slow body is cut by the total timeout. */
+    EcoChanEmu_SetOpt(&emu, EcoChanEmuOpt_Latency, (EcoArg)(size_t)0);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_ConnTimeout, (EcoArg)(size_t)0);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_TotalTimeout, (EcoArg)(size_t)100);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    clock_gettime(CLOCK_MONOTONIC, &begTs);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Timeout, res, "%d");
+
+    clock_gettime(CLOCK_MONOTONIC, &endTs);
+
+    elapsedMs = (uint64_t)(((int64_t)endTs.tv_sec - (int64_t)begTs.tv_sec) * 1000 +
+                           ((int64_t)endTs.tv_nsec - (int64_t)begTs.tv_nsec) / 1000000);
+    ASSERT(elapsedMs >= 90);
+    ASSERT(elapsedMs < 500);
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST RecordAndReplay(void) {
+    EcoChanReplay rep;
+    EcoChanRec rec;
+    EcoChanMem mem;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    char path[64];
+    EcoRes res;
+
+    snprintf(path, sizeof(path), "/tmp/echo-test-%d.cap", (int)getpid());
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/index.html?a=1");
+    ASSERT_NEQ(NULL, cli);
+
+    req = cli->req;
+
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)EcoChanMemFrag_Fixed);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)(size_t)7);
+
+    EcoChanRec_Init(&rec, NULL);
+    res = EcoChanRec_SetOpt(&rec, EcoChanRecOpt_Path, path);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    EcoChanRec_Wrap(&rec, cli);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+
+    for (int i = 0; i < 2; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    }
+
+    /* Closing the channel flushes the capture. */
+    EcoHttpCli_Del(cli);
+    EcoChanRec_Deinit(&rec);
+
+    EcoChanReplay_Init(&rep);
+    res = EcoChanReplay_SetOpt(&rep, EcoChanReplayOpt_Path, path);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    cli = EcoHttpCli_New();
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanReplay_Apply(&rep, cli);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://10.0.0.1:8080/index.html?a=1");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    /* Replay restarts from the beginning after the last connection. */
+    for (int i = 0; i < 4; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ_FMT(EcoStatCode_Ok, cli->rsp->statCode, "%d");
+        ASSERT_EQ_FMT(26UL, cli->rsp->bodyLen, "%zu");
+        ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", cli->rsp->bodyBuf, 26);
+
+        if (i == 1) {
+            EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)false);
+        }
+    }
+
+    /* Original fragmentation is reproduced. */
+    ASSERT_EQ_FMT(mem.readNum * 2, rep.readNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanReplay_Deinit(&rep);
+    EcoChanMem_Deinit(&mem);
+    unlink(path);
+
+    PASS();
+}
+
+TEST ReuseCachedReqHead(void) {
+    EcoChanMem mem;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/index.html?a=1");
+    ASSERT_NEQ(NULL, cli);
+
+    req = cli->req;
+
+    for (int i = 0; i < 2; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ(1, req->headValid);
+        ASSERT_EQ_FMT(req->headLen, mem.reqLen, "%zu");
+        ASSERT_MEM_EQ(req->headBuf, mem.reqBuf, mem.reqLen);
+    }
+
+    /* Header table change invalidates the cached head. */
+    res = EcoHdrTab_Add(req->hdrTab, "X-Trace", "on");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(req->headLen, mem.reqLen, "%zu");
+    ASSERT_MEM_EQ("X-Trace: on\r\n\r\n", mem.reqBuf + mem.reqLen - 15, 15);
+
+    /* So does an option change. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Path, "/other");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ(0, req->headValid);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_MEM_EQ("GET /other?a=1 HTTP/1.1\r\n", mem.reqBuf, 25);
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+/**
+ * @brief Issue the request and return the request head captured by memory channel.
+ */
+static const char *IssueAndGetReqHead(EcoHttpCli *cli, EcoChanMem *mem) {
+    static char headBuf[512];
+    size_t headLen;
+
+    if (EcoHttpCli_Issue(cli) != EcoRes_Ok) {
+        return "";
+    }
+
+    headLen = mem->reqLen < sizeof(headBuf) - 1 ? mem->reqLen : sizeof(headBuf) - 1;
+    memcpy(headBuf, mem->reqBuf, headLen);
+    headBuf[headLen] = '\0';
+
+    return headBuf;
+}
+
+TEST RefreshAutoGenHdrs(void) {
+    EcoChanMem mem;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    req = cli->req;
+
+    ASSERT_STR_EQ("GET / HTTP/1.1\r\n"
+                  "Host: 10.0.0.1:8080\r\n"
+                  "User-Agent: ecHo/1.0.0\r\n"
+                  "Content-Length: 0\r\n"
+                  "\r\n", IssueAndGetReqHead(cli, &mem));
+
+    /* Auto-generated headers follow the request. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://10.0.0.2:9090/");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_BodyBuf, (EcoArg)"hello");
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_BodyLen, (EcoArg)(size_t)5);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+
+    ASSERT_STR_EQ("GET / HTTP/1.1\r\n"
+                  "Host: 10.0.0.2:9090\r\n"
+                  "User-Agent: ecHo/1.0.0\r\n"
+                  "Content-Length: 5\r\n"
+                  "Connection: keep-alive\r\n"
+                  "\r\n"
+                  "hello", IssueAndGetReqHead(cli, &mem));
+
+    /* Headers set by user are left untouched. */
+    res = EcoHdrTab_Add(req->hdrTab, "Host", "example.com");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://10.0.0.3/");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)false);
+
+    ASSERT_STR_EQ("GET / HTTP/1.1\r\n"
+                  "Host: example.com\r\n"
+                  "User-Agent: ecHo/1.0.0\r\n"
+                  "Content-Length: 5\r\n"
+                  "\r\n"
+                  "hello", IssueAndGetReqHead(cli, &mem));
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST ReuseRspAcrossIssues(void) {
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoKvp *kvpAry;
+    char *keyBuf;
+    char *valBuf;
+    uint8_t *bodyBuf;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/index.html?a=1");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ReuseRsp, (EcoArg)true);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    kvpAry = cli->rsp->hdrTab->kvpAry;
+    keyBuf = kvpAry[0].keyBuf;
+    valBuf = kvpAry[0].valBuf;
+    bodyBuf = cli->rsp->bodyBuf;
+
+    for (int i = 0; i < 3; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ_FMT(3UL, cli->rsp->hdrTab->kvpNum, "%zu");
+        ASSERT_EQ_FMT(26UL, cli->rsp->bodyLen, "%zu");
+        ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", cli->rsp->bodyBuf, 26);
+
+        /* Nothing is reallocated. */
+        ASSERT_EQ(kvpAry, cli->rsp->hdrTab->kvpAry);
+        ASSERT_EQ(keyBuf, cli->rsp->hdrTab->kvpAry[0].keyBuf);
+        ASSERT_EQ(valBuf, cli->rsp->hdrTab->kvpAry[0].valBuf);
+        ASSERT_EQ(bodyBuf, cli->rsp->bodyBuf);
+    }
+
+    ASSERT_EQ_FMT(1U, mem.openNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+typedef struct _BodySink {
+    uint8_t buf[64];
+    size_t len;
+    bool done;
+} BodySink;
+
+static int WriteBodySink(int off, const void *buf, int len, EcoArg arg) {
+    BodySink *sink = (BodySink *)arg;
+
+    if (len == 0) {
+        sink->done = true;
+
+        return 0;
+    }
+
+    memcpy(sink->buf + off, buf, (size_t)len);
+    sink->len += (size_t)len;
+
+    return len;
+}
+
+TEST UseCallerBodyBuf(void) {
+    uint8_t bodyBuf[32];
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    BodySink sink = {0};
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/index.html?a=1");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyBuf, bodyBuf);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyCap, (EcoArg)sizeof(bodyBuf));
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyHookArg, &sink);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyWriteHook, WriteBodySink);
+
+    /* Body fits in the caller's buffer. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ(bodyBuf, cli->rsp->bodyBuf);
+    ASSERT_EQ_FMT(26UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", bodyBuf, 26);
+    ASSERT_EQ_FMT(0UL, sink.len, "%zu");
+
+    /* Body doesn't fit. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyCap, (EcoArg)(size_t)16);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_BodyTooBig, res, "%d");
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyOverflow, (EcoArg)EcoBodyOverflow_Stream);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(26UL, sink.len, "%zu");
+    ASSERT(sink.done);
+    ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", sink.buf, 26);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyOverflow, (EcoArg)EcoBodyOverflow_Grow);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_NEQ(bodyBuf, cli->rsp->bodyBuf);
+    ASSERT_EQ_FMT(26UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", cli->rsp->bodyBuf, 26);
+
+    /* Without caller's buffer, capacity limits the allocation. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyBuf, NULL);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyWriteHook, NULL);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyOverflow, (EcoArg)EcoBodyOverflow_Fail);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_BodyTooBig, res, "%d");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST ReadBodyDirectly(void) {
+    static char rspMsg[64 + 4096];
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    int headLen;
+    EcoRes res;
+
+    headLen = snprintf(rspMsg, sizeof(rspMsg), "HTTP/1.1 200 OK\r\n"
+                                               "Content-Length: 4096\r\n"
+                                               "\r\n");
+    memset(rspMsg + headLen, 'x', 4096);
+
+    cli = NewMemCli(&mem, rspMsg, (size_t)(headLen + 4096), "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(4096UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ(rspMsg + headLen, cli->rsp->bodyBuf, 4096);
+
+    /* One read for the head, and one for the rest of the body. */
+    ASSERT_EQ_FMT(2U, mem.readNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+static int CountBodyLen(int off, const void *buf, int len, EcoArg arg) {
+    (void)off;
+    (void)buf;
+
+    *(size_t *)arg += (size_t)len;
+
+    return len;
+}
+
+TEST AdaptRcvBuf(void) {
+    const size_t bodyLen = 1024 * 1024;
+    size_t sinkLen = 0;
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    char *rspMsg;
+    int headLen;
+    EcoRes res;
+
+    rspMsg = (char *)malloc(64 + bodyLen);
+    ASSERT_NEQ(NULL, rspMsg);
+
+    headLen = snprintf(rspMsg, 64, "HTTP/1.1 200 OK\r\n"
+                                   "Content-Length: %zu\r\n"
+                                   "\r\n", bodyLen);
+    memset(rspMsg + headLen, 'x', bodyLen);
+
+    cli = NewMemCli(&mem, rspMsg, headLen + bodyLen, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyHookArg, &sinkLen);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyWriteHook, CountBodyLen);
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufCap, (EcoArg)(size_t)64);
+    ASSERT_EQ_FMT(EcoRes_BadArg, res, "%d");
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufCap, (EcoArg)(size_t)4096);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufMaxCap, (EcoArg)(size_t)2048);
+    ASSERT_EQ_FMT(EcoRes_BadArg, res, "%d");
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufMaxCap, (EcoArg)(size_t)(64 * 1024));
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    /* A large streamed body grows the buffer up to the maximum. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(bodyLen, sinkLen, "%zu");
+    ASSERT_EQ_FMT((size_t)64 * 1024, cli->stats.rcvBufCap, "%zu");
+    ASSERT_EQ_FMT(4U, cli->stats.rcvBufGrowNum, "%u");
+    ASSERT(mem.readNum < 32);
+    ASSERT_EQ_FMT((uint64_t)mem.readNum, cli->stats.readNum, "%" PRIu64);
+
+    /* Small responses shrink it back by half each issue. */
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_RspBuf, (EcoArg)gRspMsg);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_RspLen, (EcoArg)(sizeof(gRspMsg) - 1));
+
+    for (int i = 0; i < 8; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    }
+
+    ASSERT_EQ_FMT((size_t)4096, cli->stats.rcvBufCap, "%zu");
+    ASSERT_EQ_FMT(4U, cli->stats.rcvBufShrinkNum, "%u");
+    ASSERT_EQ_FMT((uint64_t)9, cli->stats.issueNum, "%" PRIu64);
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+    free(rspMsg);
+
+    PASS();
+}
+
+TEST PullBody(void) {
+    char bodyBuf[32];
+    size_t bodyLen;
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoRes res;
+    int rdLen;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)EcoChanMemFrag_Fixed);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)(size_t)40);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_PullBody, (EcoArg)true);
+
+    for (int i = 0; i < 2; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ_FMT(26UL, cli->rsp->contLen, "%zu");
+        ASSERT_EQ_FMT(0UL, cli->rsp->bodyLen, "%zu");
+
+        /* Pull the body in small pieces. */
+        bodyLen = 0;
+        while ((rdLen = EcoHttpCli_ReadBody(cli, bodyBuf + bodyLen, 5)) > 0) {
+            bodyLen += (size_t)rdLen;
+        }
+
+        ASSERT_EQ_FMT(0, rdLen, "%d");
+        ASSERT_EQ_FMT(26UL, bodyLen, "%zu");
+        ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", bodyBuf, 26);
+    }
+
+    ASSERT_EQ_FMT(1U, mem.openNum, "%u");
+
+    /* Body left unread is drained by the next issue. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(1U, mem.openNum, "%u");
+    ASSERT_EQ_FMT(1U, cli->stats.bodyDrainNum, "%u");
+
+    /* Unless draining is disabled, which makes it reconnect. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_DrainMaxLen, (EcoArg)(size_t)0);
+
+    ASSERT_EQ_FMT(EcoBodyAbandon_Close, EcoHttpCli_AbandonBody(cli), "%d");
+    ASSERT_EQ_FMT(1U, cli->stats.bodyCloseNum, "%u");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(2U, mem.openNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+typedef struct _SlowSink {
+    BodySink sink;
+    size_t quota;
+} SlowSink;
+
+static int WriteSlowSink(int off, const void *buf, int len, EcoArg arg) {
+    SlowSink *slow = (SlowSink *)arg;
+
+    if (len != 0) {
+        if (slow->quota == 0) {
+            return EcoRes_Again;
+        }
+
+        if ((size_t)len > slow->quota) {
+            len = (int)slow->quota;
+        }
+
+        slow->quota -= (size_t)len;
+    }
+
+    return WriteBodySink(off, buf, len, &slow->sink);
+}
+
+TEST ApplyBodyBackpressure(void) {
+    SlowSink slow;
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    uint32_t readNum;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyHookArg, &slow);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyWriteHook, WriteSlowSink);
+
+    for (int i = 0; i < 2; i++) {
+        memset(&slow, 0, sizeof(slow));
+        slow.quota = 4;
+
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Again, res, "%d");
+        ASSERT_EQ_FMT(4UL, slow.sink.len, "%zu");
+
+        /* Nothing is read while the sink is full. */
+        readNum = mem.readNum;
+
+        res = EcoHttpCli_Resume(cli);
+        ASSERT_EQ_FMT(EcoRes_Again, res, "%d");
+        ASSERT_EQ_FMT(readNum, mem.readNum, "%u");
+
+        while (res == EcoRes_Again) {
+            slow.quota = 5;
+
+            res = EcoHttpCli_Resume(cli);
+        }
+
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT(slow.sink.done);
+        ASSERT_EQ_FMT(26UL, slow.sink.len, "%zu");
+        ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", slow.sink.buf, 26);
+    }
+
+    ASSERT_EQ_FMT(1U, mem.openNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST KeepRcvBufForUnfinishedBody(void) {
+    char bodyBuf[32];
+    size_t bodyLen;
+    SlowSink slow;
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoRes res;
+    int rdLen;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_PullBody, (EcoArg)true);
+
+    /* Body received with the head is still in the receive buffer. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufCap, (EcoArg)(size_t)1024);
+    ASSERT_EQ_FMT(EcoRes_Again, res, "%d");
+
+    bodyLen = 0;
+    while ((rdLen = EcoHttpCli_ReadBody(cli, bodyBuf + bodyLen, 5)) > 0) {
+        bodyLen += (size_t)rdLen;
+    }
+
+    ASSERT_EQ_FMT(0, rdLen, "%d");
+    ASSERT_EQ_FMT(26UL, bodyLen, "%zu");
+    ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", bodyBuf, 26);
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufCap, (EcoArg)(size_t)1024);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    /* Same for a body paused by the body write hook. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_PullBody, (EcoArg)false);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyHookArg, &slow);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_BodyWriteHook, WriteSlowSink);
+
+    memset(&slow, 0, sizeof(slow));
+    slow.quota = 4;
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Again, res, "%d");
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufCap, (EcoArg)(size_t)2048);
+    ASSERT_EQ_FMT(EcoRes_Again, res, "%d");
+
+    slow.quota = 26;
+
+    res = EcoHttpCli_Resume(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(26UL, slow.sink.len, "%zu");
+    ASSERT_MEM_EQ("abcdefghijklmnopqrstuvwxyz", slow.sink.buf, 26);
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RcvBufCap, (EcoArg)(size_t)2048);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(1U, mem.openNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+typedef struct _RspDecider {
+    EcoRspAct statAct;
+    size_t hdrNum;
+} RspDecider;
+
+static EcoRspAct DecideOnStat(EcoHttpVer ver, EcoStatCode statCode, EcoArg arg) {
+    RspDecider *dec = (RspDecider *)arg;
+
+    (void)ver;
+    (void)statCode;
+
+    dec->hdrNum = 0;
+
+    return dec->statAct;
+}
+
+static EcoRspAct DecideOnHdrLine(const char *keyBuf, size_t keyLen,
+                                 const char *valBuf, size_t valLen,
+                                 EcoArg arg) {
+    RspDecider *dec = (RspDecider *)arg;
+
+    (void)keyLen;
+    (void)valLen;
+
+    dec->hdrNum++;
+
+    if (strcmp(keyBuf, "content-type") == 0 &&
+        strcmp(valBuf, "text/plain") == 0) {
+        return EcoRspAct_SkipBody;
+    }
+
+    return EcoRspAct_Continue;
+}
+
+TEST DecideOnRspHead(void) {
+    RspDecider dec;
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, gRspMsg, sizeof(gRspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)EcoChanMemFrag_Fixed);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)(size_t)16);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspStatHookArg, &dec);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspStatHook, DecideOnStat);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrLineHookArg, &dec);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrLineHook, DecideOnHdrLine);
+
+    /* Skipped body is drained, so the channel is kept alive. */
+    dec.statAct = EcoRspAct_Continue;
+
+    for (int i = 0; i < 2; i++) {
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ_FMT(3UL, dec.hdrNum, "%zu");
+        ASSERT_EQ_FMT(3UL, cli->rsp->hdrTab->kvpNum, "%zu");
+        ASSERT_EQ_FMT(26UL, cli->rsp->contLen, "%zu");
+        ASSERT_EQ_FMT(0UL, cli->rsp->bodyLen, "%zu");
+    }
+
+    ASSERT_EQ_FMT(1U, mem.openNum, "%u");
+
+    /* Aborting right after the status line closes the channel. */
+    dec.statAct = EcoRspAct_Abort;
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Aborted, res, "%d");
+    ASSERT_EQ_FMT(0UL, dec.hdrNum, "%zu");
+    ASSERT_EQ_FMT(1U, mem.closeNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST DrainAbandonedBody(void) {
+    static char rspMsg[64 + 16384];
+    char bodyBuf[16];
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    int headLen;
+    EcoRes res;
+    int rdLen;
+
+    headLen = snprintf(rspMsg, sizeof(rspMsg), "HTTP/1.1 200 OK\r\n"
+                                               "Content-Length: 16384\r\n"
+                                               "\r\n");
+    memset(rspMsg + headLen, 'x', 16384);
+
+    cli = NewMemCli(&mem, rspMsg, (size_t)(headLen + 16384), "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)EcoChanMemFrag_Fixed);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)(size_t)1460);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_PullBody, (EcoArg)true);
+
+    /* Short enough to drain. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    rdLen = EcoHttpCli_ReadBody(cli, bodyBuf, sizeof(bodyBuf));
+    ASSERT_EQ_FMT((int)sizeof(bodyBuf), rdLen, "%d");
+
+    ASSERT_EQ_FMT(EcoBodyAbandon_Drain, EcoHttpCli_AbandonBody(cli), "%d");
+    ASSERT_EQ_FMT(EcoBodyAbandon_None, EcoHttpCli_AbandonBody(cli), "%d");
+    ASSERT_EQ_FMT(0, EcoHttpCli_ReadBody(cli, bodyBuf, sizeof(bodyBuf)), "%d");
+    ASSERT(cli->stats.bodyDrainLen > 0);
+    ASSERT(cli->stats.bodyDrainLen < 16384);
+
+    /* Too long to drain. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_DrainMaxLen, (EcoArg)(size_t)1024);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(1U, mem.openNum, "%u");
+
+    ASSERT_EQ_FMT(EcoBodyAbandon_Close, EcoHttpCli_AbandonBody(cli), "%d");
+    ASSERT_EQ_FMT(1U, cli->stats.bodyDrainNum, "%u");
+    ASSERT_EQ_FMT(1U, cli->stats.bodyCloseNum, "%u");
+    ASSERT_EQ_FMT(1U, mem.closeNum, "%u");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST DrainWithinOwnDeadline(void) {
+    static char rspMsg[64 + 1000];
+    const char *rspAry[2] = {rspMsg, rspMsg};
+    size_t stallOffAry[2];
+    char bodyBuf[16];
+    EcoChanSock sock;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    char path[64];
+    int headLen;
+    EcoRes res;
+    int rdLen;
+    pid_t pid;
+    int stat;
+
+    headLen = snprintf(rspMsg, sizeof(rspMsg), "HTTP/1.1 200 OK\r\n"
+                                               "Content-Length: 1000\r\n"
+                                               "\r\n");
+    memset(rspMsg + headLen, 'x', 1000);
+    rspMsg[headLen + 1000] = '\0';
+
+    snprintf(path, sizeof(path), "/tmp/echo-test-%d.sock", (int)getpid());
+
+    /* Stall in the middle of both bodies, longer than the issue timeout. */
+    stallOffAry[0] = (size_t)headLen + 500;
+    stallOffAry[1] = (size_t)headLen + 500;
+
+    pid = ServeUnixSock(path, rspAry, stallOffAry, 2, 100);
+    ASSERT_GT(pid, 0);
+
+    EcoChanSock_Init(&sock);
+
+    cli = EcoHttpCli_New();
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanSock_Apply(&sock, cli);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_PullBody, (EcoArg)true);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_DrainTimeout, (EcoArg)(size_t)0);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_SockPath, path);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_TotalTimeout, (EcoArg)(size_t)50);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    /* Unlimited drain isn't bounded by the budget of the issue. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    rdLen = EcoHttpCli_ReadBody(cli, bodyBuf, sizeof(bodyBuf));
+    ASSERT_EQ_FMT((int)sizeof(bodyBuf), rdLen, "%d");
+
+    ASSERT_EQ_FMT(EcoBodyAbandon_Drain, EcoHttpCli_AbandonBody(cli), "%d");
+    ASSERT_EQ_FMT((uint64_t)(1000 - sizeof(bodyBuf)), cli->stats.bodyDrainLen, "%" PRIu64);
+
+    /* Limited drain expires on its own deadline. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_DrainTimeout, (EcoArg)(size_t)30);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_TotalTimeout, (EcoArg)(size_t)1000);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    ASSERT_EQ_FMT(EcoBodyAbandon_Close, EcoHttpCli_AbandonBody(cli), "%d");
+    ASSERT_EQ_FMT(1U, cli->stats.bodyDrainNum, "%u");
+    ASSERT_EQ_FMT(1U, cli->stats.bodyCloseNum, "%u");
+    ASSERT(cli->chanOpened == false);
+
+    waitpid(pid, &stat, 0);
+    unlink(path);
+
+    EcoHttpCli_Del(cli);
+
+    PASS();
+}
+
+TEST FilterRspHdrs(void) {
+    static const char rspMsg[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 4\r\n"
+        "Connection: close\r\n"
+        "X-Request-Id: 1b4e28ba-2fa1-11d2-883f-0016d3cca427\r\n"
+        "\r\n"
+        "abcd";
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoHdrTab *tab;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, rspMsg, sizeof(rspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_KeepAlive, (EcoArg)true);
+
+    tab = EcoHdrTab_New();
+    ASSERT_NEQ(NULL, tab);
+
+    EcoHdrTab_Add(tab, "Content-Type", "");
+    EcoHdrTab_Add(tab, "X-Request-Id", "");
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrFilterTab, tab);
+
+    res = EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrFilter, (EcoArg)(size_t)99);
+    ASSERT_EQ_FMT(EcoRes_BadArg, res, "%d");
+
+    /* Only listed headers are stored, but the unlisted
+       ones still take effect. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrFilter, (EcoArg)EcoHdrFilter_Allow);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(2UL, cli->rsp->hdrTab->kvpNum, "%zu");
+    ASSERT_EQ_FMT(EcoRes_Ok, EcoHdrTab_Find(cli->rsp->hdrTab, "content-type", NULL), "%d");
+    ASSERT_EQ_FMT(EcoRes_Ok, EcoHdrTab_Find(cli->rsp->hdrTab, "x-request-id", NULL), "%d");
+    ASSERT_EQ_FMT(4UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("abcd", cli->rsp->bodyBuf, 4);
+    ASSERT_EQ_FMT(1U, mem.closeNum, "%u");
+
+    /* Listed headers are dropped. */
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_RspHdrFilter, (EcoArg)EcoHdrFilter_Deny);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(2UL, cli->rsp->hdrTab->kvpNum, "%zu");
+    ASSERT_EQ_FMT(EcoRes_Ok, EcoHdrTab_Find(cli->rsp->hdrTab, "content-length", NULL), "%d");
+    ASSERT_EQ_FMT(EcoRes_Ok, EcoHdrTab_Find(cli->rsp->hdrTab, "connection", NULL), "%d");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST ParseLenientRsp(void) {
+    static const char rspMsg[] =
+        "HTTP/1.1 200\n"
+        "X_Trace:\tv\xc3\xa9\n"
+        "Content-Length: 4\r\n"
+        "\n"
+        "abcd";
+    static const size_t fragLenAry[] = { 0, 1, 7 };
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoKvp *kvp;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, rspMsg, sizeof(rspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    /* Rejected by default. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_BadStatLine, res, "%d");
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_LenientParse, (EcoArg)true);
+
+    /* Both bulk and byte by byte parsing accept it. */
+    for (size_t i = 0; i < sizeof(fragLenAry) / sizeof(fragLenAry[0]); i++) {
+        EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)(size_t)(fragLenAry[i] == 0 ? EcoChanMemFrag_None : EcoChanMemFrag_Fixed));
+        EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)fragLenAry[i]);
+
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ_FMT(EcoStatCode_Ok, cli->rsp->statCode, "%d");
+        ASSERT_EQ_FMT(2UL, cli->rsp->hdrTab->kvpNum, "%zu");
+
+        res = EcoHdrTab_Find(cli->rsp->hdrTab, "x_trace", &kvp);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_STR_EQ("v\xc3\xa9", kvp->valBuf);
+
+        ASSERT_EQ_FMT(4UL, cli->rsp->bodyLen, "%zu");
+        ASSERT_MEM_EQ("abcd", cli->rsp->bodyBuf, 4);
+    }
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST ParseRspLinesByTab(void) {
+    static const char rspMsg[] =
+        "xHTTHTTP/1.0 404 Not Found\r\n"
+        "X_Trace: a:b c\r\n"
+        "Content-Length: 4\r\n"
+        "\r\n"
+        "abcd";
+    static const size_t fragLenAry[] = { 0, 1, 5 };
+    EcoChanMem mem;
+    EcoHttpCli *cli;
+    EcoKvp *kvp;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, rspMsg, sizeof(rspMsg) - 1, "http://10.0.0.1:8080/");
+    ASSERT_NEQ(NULL, cli);
+
+    /* Leading garbage is skipped, and the key keeps its underscore. */
+    for (size_t i = 0; i < sizeof(fragLenAry) / sizeof(fragLenAry[0]); i++) {
+        EcoChanMem_SetOpt(&mem, EcoChanMemOpt_Frag, (EcoArg)(size_t)(fragLenAry[i] == 0 ? EcoChanMemFrag_None : EcoChanMemFrag_Fixed));
+        EcoChanMem_SetOpt(&mem, EcoChanMemOpt_FragLen, (EcoArg)fragLenAry[i]);
+
+        res = EcoHttpCli_Issue(cli);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_EQ_FMT(EcoHttpVer_1_0, cli->rsp->ver, "%d");
+        ASSERT_EQ_FMT(EcoStatCode_NotFound, cli->rsp->statCode, "%d");
+
+        res = EcoHdrTab_Find(cli->rsp->hdrTab, "x_trace", &kvp);
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+        ASSERT_STR_EQ("a:b c", kvp->valBuf);
+
+        ASSERT_EQ_FMT(4UL, cli->rsp->bodyLen, "%zu");
+        ASSERT_MEM_EQ("abcd", cli->rsp->bodyBuf, 4);
+    }
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+TEST PostFormBody(void) {
+    static const char rspMsg[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+    EcoChanMem mem;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    EcoKvp *kvp;
+    EcoRes res;
+
+    cli = NewMemCli(&mem, rspMsg, sizeof(rspMsg) - 1, "http://10.0.0.1:8080/login");
+    ASSERT_NEQ(NULL, cli);
+
+    req = cli->req;
+
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Method, (EcoArg)EcoHttpMeth_Post);
+
+    res = EcoHttpReq_AddFormParam(req, "user", "jo");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHdrTab_Find(req->hdrTab, "content-type", &kvp);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_STR_EQ("application/x-www-form-urlencoded", kvp->valBuf);
+
+    res = EcoHdrTab_Find(req->hdrTab, "content-length", &kvp);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_STR_EQ("7", kvp->valBuf);
+
+    /* Generated type goes away with the form. */
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_BodyBuf, NULL);
+    EcoHttpReq_SetOpt(req, EcoHttpReqOpt_BodyLen, (EcoArg)0);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHdrTab_Find(req->hdrTab, "content-type", &kvp);
+    ASSERT_EQ_FMT(EcoRes_NotFound, res, "%d");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+
+    PASS();
+}
+
+SUITE(BasicClientSuite) {
+    RUN_TEST(ExpireFirstByteDeadline);
+    RUN_TEST(ExpireConnDeadline);
+    RUN_TEST(IssueOverUnixSock);
+    RUN_TEST(ClearExpiredBudget);
+    RUN_TEST(RaceConnAttempts);
+    RUN_TEST(ParseFragmentedRsp);
+    RUN_TEST(EmulateSlowLink);
+    RUN_TEST(BoundEmulatedWaits);
+    RUN_TEST(RecordAndReplay);
+    RUN_TEST(ReuseCachedReqHead);
+    RUN_TEST(RefreshAutoGenHdrs);
+    RUN_TEST(ReuseRspAcrossIssues);
+    RUN_TEST(UseCallerBodyBuf);
+    RUN_TEST(ReadBodyDirectly);
+    RUN_TEST(AdaptRcvBuf);
+    RUN_TEST(PullBody);
+    RUN_TEST(ApplyBodyBackpressure);
+    RUN_TEST(KeepRcvBufForUnfinishedBody);
+    RUN_TEST(DecideOnRspHead);
+    RUN_TEST(DrainAbandonedBody);
+    RUN_TEST(DrainWithinOwnDeadline);
+    RUN_TEST(FilterRspHdrs);
+    RUN_TEST(ParseLenientRsp);
+    RUN_TEST(ParseRspLinesByTab);
+    RUN_TEST(PostFormBody);
+}
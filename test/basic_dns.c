@@ -0,0 +1,303 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "echo.h"
+#include "chan_mem.h"
+#include "dns.h"
+
+#include "greatest.h"
+
+/* Lookup stub, which resolves "*.test" names to
+   2001:db8::x and 10.0.0.x, where x is the name length. */
+typedef struct _StubResolver {
+    pthread_mutex_t mutex;
+    int lookupNum;
+
+    /* TTL reported by the stub, 0 means keeping the default. */
+    uint32_t ttl;
+
+    /* Time to take for each lookup. */
+    uint32_t delay;
+} StubResolver;
+
+static void SleepMs(uint32_t ms) {
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000;
+
+    nanosleep(&ts, NULL);
+}
+
+static EcoRes StubLookupHook(const char *name, EcoIpAddr *ipAry, size_t *ipNum,
+                             uint32_t *ttl, EcoArg arg) {
+    StubResolver *stub = (StubResolver *)arg;
+    size_t nameLen = strlen(name);
+
+    pthread_mutex_lock(&stub->mutex);
+    stub->lookupNum++;
+    pthread_mutex_unlock(&stub->mutex);
+
+    SleepMs(stub->delay);
+
+    if (nameLen < 5 ||
+        strcmp(name + nameLen - 5, ".test") != 0 ||
+        strncmp(name, "bad", 3) == 0) {
+        return EcoRes_BadResolve;
+    }
+
+    memset(ipAry, 0, sizeof(EcoIpAddr) * 2);
+
+    ipAry[0].ver = EcoIpVer_6;
+    ipAry[0].buf[0] = 0x20;
+    ipAry[0].buf[1] = 0x01;
+    ipAry[0].buf[2] = 0x0d;
+    ipAry[0].buf[3] = 0xb8;
+    ipAry[0].buf[15] = (uint8_t)nameLen;
+
+    ipAry[1].ver = EcoIpVer_4;
+    ipAry[1].buf[0] = 10;
+    ipAry[1].buf[3] = (uint8_t)nameLen;
+
+    *ipNum = 2;
+
+    if (stub->ttl != 0) {
+        *ttl = stub->ttl;
+    }
+
+    return EcoRes_Ok;
+}
+
+static int GetLookupNum(StubResolver *stub) {
+    int lookupNum;
+
+    pthread_mutex_lock(&stub->mutex);
+    lookupNum = stub->lookupNum;
+    pthread_mutex_unlock(&stub->mutex);
+
+    return lookupNum;
+}
+
+static EcoDns *NewStubDns(StubResolver *stub) {
+    EcoDns *dns;
+
+    pthread_mutex_init(&stub->mutex, NULL);
+    stub->lookupNum = 0;
+    stub->ttl = 0;
+    stub->delay = 0;
+
+    dns = EcoDns_New();
+    if (dns == NULL) {
+        return NULL;
+    }
+
+    EcoDns_SetOpt(dns, EcoDnsOpt_LookupHookArg, stub);
+    EcoDns_SetOpt(dns, EcoDnsOpt_LookupHook, (EcoArg)StubLookupHook);
+
+    return dns;
+}
+
+TEST ResolveFromHostsFile(void) {
+    EcoIpAddr ipAry[ECO_CHAN_IP_MAX_NUM];
+    bool loopFound = false;
+    size_t ipNum;
+    EcoDns *dns;
+    EcoRes res;
+
+    dns = EcoDns_New();
+    ASSERT_NEQ(NULL, dns);
+
+    ipNum = ECO_CHAN_IP_MAX_NUM;
+
+    res = EcoDns_Resolve(dns, "localhost", ipAry, &ipNum, 5000);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    for (size_t i = 0; i < ipNum; i++) {
+        if (ipAry[i].ver == EcoIpVer_4 &&
+            ipAry[i].buf[0] == 127) {
+            loopFound = true;
+        }
+    }
+
+    ASSERT(loopFound);
+
+    res = EcoDns_Resolve(dns, "localhost", ipAry, &ipNum, 5000);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT((uint64_t)1, dns->hitNum, "%" PRIu64);
+    ASSERT_EQ_FMT((uint64_t)1, dns->missNum, "%" PRIu64);
+
+    ipNum = ECO_CHAN_IP_MAX_NUM;
+
+    res = EcoDns_Resolve(dns, "no-such-host.invalid", ipAry, &ipNum, 5000);
+    ASSERT_NEQ(EcoRes_Ok, res);
+
+    EcoDns_Del(dns);
+
+    PASS();
+}
+
+TEST CacheStubLookups(void) {
+    EcoIpAddr ipAry[ECO_CHAN_IP_MAX_NUM];
+    StubResolver stub;
+    size_t ipNum;
+    EcoDns *dns;
+    EcoRes res;
+
+    dns = NewStubDns(&stub);
+    ASSERT_NEQ(NULL, dns);
+
+    stub.ttl = 50;
+
+    ipNum = ECO_CHAN_IP_MAX_NUM;
+
+    res = EcoDns_Resolve(dns, "api.test", ipAry, &ipNum, 0);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT((size_t)2, ipNum, "%zu");
+    ASSERT_EQ_FMT(EcoIpVer_6, ipAry[0].ver, "%d");
+    ASSERT_EQ_FMT(8, ipAry[0].buf[15], "%u");
+    ASSERT_EQ_FMT(EcoIpVer_4, ipAry[1].ver, "%d");
+    ASSERT_EQ_FMT(10, ipAry[1].buf[0], "%u");
+
+    /* Addresses are truncated to the capacity of caller. */
+    ipNum = 1;
+
+    /* Cached until the reported TTL expires. */
+    res = EcoDns_Resolve(dns, "api.test", ipAry, &ipNum, 0);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT((size_t)1, ipNum, "%zu");
+    ASSERT_EQ_FMT(1, GetLookupNum(&stub), "%d");
+
+    SleepMs(80);
+
+    res = EcoDns_Resolve(dns, "api.test", ipAry, &ipNum, 0);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(2, GetLookupNum(&stub), "%d");
+
+    /* Failures are cached too. */
+    res = EcoDns_Resolve(dns, "bad.test", ipAry, &ipNum, 0);
+    ASSERT_EQ_FMT(EcoRes_BadResolve, res, "%d");
+
+    res = EcoDns_Resolve(dns, "bad.test", ipAry, &ipNum, 0);
+    ASSERT_EQ_FMT(EcoRes_BadResolve, res, "%d");
+    ASSERT_EQ_FMT(3, GetLookupNum(&stub), "%d");
+
+    /* Prefetched name is looked up in the background. */
+    res = EcoDns_Prefetch(dns, "cdn.test");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoDns_Resolve(dns, "cdn.test", ipAry, &ipNum, 0);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(4, GetLookupNum(&stub), "%d");
+
+    EcoDns_Del(dns);
+
+    PASS();
+}
+
+TEST TimeoutSlowLookup(void) {
+    EcoIpAddr ipAry[ECO_CHAN_IP_MAX_NUM];
+    size_t ipNum = ECO_CHAN_IP_MAX_NUM;
+    StubResolver stub;
+    EcoDns *dns;
+    EcoRes res;
+
+    dns = NewStubDns(&stub);
+    ASSERT_NEQ(NULL, dns);
+
+    stub.delay = 100;
+
+    res = EcoDns_Resolve(dns, "slow.test", ipAry, &ipNum, 10);
+    ASSERT_EQ_FMT(EcoRes_Timeout, res, "%d");
+
+    /* Lookup in progress is waited for instead of being repeated. */
+    res = EcoDns_Resolve(dns, "slow.test", ipAry, &ipNum, 0);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(1, GetLookupNum(&stub), "%d");
+
+    EcoDns_Del(dns);
+
+    PASS();
+}
+
+static EcoIpAddr gOpenIpAry[ECO_CHAN_IP_MAX_NUM];
+static size_t gOpenIpNum;
+
+static EcoRes RecAddrOpenHook(EcoChanAddr *addr, EcoArg arg) {
+    memcpy(gOpenIpAry, addr->ipAry, sizeof(EcoIpAddr) * addr->ipNum);
+    gOpenIpNum = addr->ipNum;
+
+    return EcoChanMem_OpenHook(addr, arg);
+}
+
+TEST IssueToHostName(void) {
+    static const char rspMsg[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 0\r\n"
+        "\r\n";
+    StubResolver stub;
+    EcoChanMem mem;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    EcoDns *dns;
+    EcoRes res;
+
+    EcoChanMem_Init(&mem);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_RspBuf, (EcoArg)rspMsg);
+    EcoChanMem_SetOpt(&mem, EcoChanMemOpt_RspLen, (EcoArg)(sizeof(rspMsg) - 1));
+
+    cli = EcoHttpCli_New();
+    ASSERT_NEQ(NULL, cli);
+
+    EcoChanMem_Apply(&mem, cli);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_ChanOpenHook, (EcoArg)RecAddrOpenHook);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://www.test:8080/");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    /* Host name can't be issued without a resolver. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_BadResolve, res, "%d");
+
+    dns = NewStubDns(&stub);
+    ASSERT_NEQ(NULL, dns);
+
+    EcoDns_Apply(dns, cli);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT((size_t)2, gOpenIpNum, "%zu");
+    ASSERT_EQ_FMT(EcoIpVer_4, gOpenIpAry[1].ver, "%d");
+    ASSERT_EQ_FMT(8, gOpenIpAry[1].buf[3], "%u");
+    ASSERT_MEM_EQ("GET / HTTP/1.1\r\n"
+                  "Host: www.test:8080\r\n", mem.reqBuf, 37);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://bad.test/");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_BadResolve, res, "%d");
+
+    EcoHttpCli_Del(cli);
+    EcoChanMem_Deinit(&mem);
+    EcoDns_Del(dns);
+
+    PASS();
+}
+
+SUITE(BasicDnsSuite) {
+    RUN_TEST(ResolveFromHostsFile);
+    RUN_TEST(CacheStubLookups);
+    RUN_TEST(TimeoutSlowLookup);
+    RUN_TEST(IssueToHostName);
+}
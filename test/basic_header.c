@@ -380,6 +380,64 @@ TEST AddInvalidHeaderLine(void) {
     PASS();
 }
 
+TEST GetWireCaseKey(void) {
+    EcoHdrTab *tab;
+    EcoRes res;
+
+    tab = EcoHdrTab_New();
+    ASSERT_NEQ(NULL, tab);
+
+    res = EcoHdrTab_Add(tab, "CONTENT-TYPE", "text/plain");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHdrTab_Add(tab, "x-request-id", "1");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    ASSERT_EQ(NULL, tab->kvpAry[0].wireKeyBuf);
+    ASSERT_STR_EQ("Content-Type", EcoKvp_GetWireKey(tab->kvpAry + 0));
+    ASSERT_STR_EQ("X-Request-Id", EcoKvp_GetWireKey(tab->kvpAry + 1));
+
+    /* Canonical key is left untouched. */
+    ASSERT_STR_EQ("content-type", tab->kvpAry[0].keyBuf);
+    ASSERT_STR_EQ("x-request-id", tab->kvpAry[1].keyBuf);
+
+    EcoHdrTab_Del(tab);
+
+    PASS();
+}
+
+TEST AddStaticHeader(void) {
+    static const char val[] = "ecHo";
+    EcoHdrTab *tab;
+    EcoRes res;
+
+    tab = EcoHdrTab_New();
+    ASSERT_NEQ(NULL, tab);
+
+    res = EcoHdrTab_AddStatic(tab, "User-Agent", val);
+    ASSERT_EQ_FMT(EcoRes_BadHdrKey, res, "%d");
+
+    res = EcoHdrTab_AddStatic(tab, "user-agent", val);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(1UL, tab->kvpNum, "%zu");
+    ASSERT_EQ(val, tab->kvpAry[0].valBuf);
+    ASSERT_STR_EQ("User-Agent", EcoKvp_GetWireKey(tab->kvpAry + 0));
+
+    /* Overwriting a static header copies the new value. */
+    res = EcoHdrTab_Add(tab, "User-Agent", "curl");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(1UL, tab->kvpNum, "%zu");
+    ASSERT_STR_EQ("curl", tab->kvpAry[0].valBuf);
+
+    res = EcoHdrTab_Drop(tab, "user-agent");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(0UL, tab->kvpNum, "%zu");
+
+    EcoHdrTab_Del(tab);
+
+    PASS();
+}
+
 SUITE(BasicHeaderSuite) {
     RUN_TEST(AddCommonHeaderSeparately);
     RUN_TEST(AddCommonFormattedHeaderSeparately);
@@ -389,4 +447,6 @@ SUITE(BasicHeaderSuite) {
     RUN_TEST(OverwriteHeaderSeparately);
     RUN_TEST(AddValidHeaderLine);
     RUN_TEST(AddInvalidHeaderLine);
+    RUN_TEST(GetWireCaseKey);
+    RUN_TEST(AddStaticHeader);
 }
@@ -1,4 +1,6 @@
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
 #include "conf.h"
 #include "echo.h"
@@ -91,7 +93,391 @@ TEST SetInvalidUrl(void) {
     PASS();
 }
 
+TEST SetUnixSockUrl(void) {
+    EcoHttpReq *req;
+    EcoRes res;
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http+unix://%2Fvar%2Frun%2Fagent.sock/metrics?fmt=text");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoScheme_HttpUnix, req->scheme, "%d");
+    ASSERT_EQ_FMT(EcoChanAddrType_Unix, req->chanAddr.type, "%d");
+    ASSERT_STR_EQ("/var/run/agent.sock", req->chanAddr.sockPath);
+    ASSERT_EQ_FMT(19UL, req->chanAddr.sockPathLen, "%zu");
+    ASSERT_STR_EQ("/metrics", req->pathBuf);
+    ASSERT_STR_EQ("fmt=text", req->queryBuf);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http+unix://agent.sock");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_STR_EQ("agent.sock", req->chanAddr.sockPath);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://127.0.0.1:8080/");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoChanAddrType_Ipv4, req->chanAddr.type, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http+unix:///metrics");
+    ASSERT_EQ_FMT(EcoRes_BadHost, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http+unix://%2Ftmp%2/metrics");
+    ASSERT_EQ_FMT(EcoRes_BadChar, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http+unix://%00/metrics");
+    ASSERT_EQ_FMT(EcoRes_BadHost, res, "%d");
+
+    EcoHttpReq_Del(req);
+
+    PASS();
+}
+
+TEST ResetAndReuseRequest(void) {
+    EcoHttpReq *req;
+    char *pathBuf;
+    char *queryBuf;
+    EcoKvp *kvpAry;
+    EcoRes res;
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://10.0.0.1:8080/api/v1/items?page=1&size=20");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Headers, EcoHdrTab_New());
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHdrTab_Add(req->hdrTab, "Accept", "application/json");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    pathBuf = req->pathBuf;
+    queryBuf = req->queryBuf;
+    kvpAry = req->hdrTab->kvpAry;
+
+    EcoHttpReq_Reset(req);
+    ASSERT_EQ_FMT(0UL, req->pathLen, "%zu");
+    ASSERT_EQ_FMT(0UL, req->queryLen, "%zu");
+    ASSERT_EQ_FMT(0UL, req->hdrTab->kvpNum, "%zu");
+    ASSERT_EQ_FMT(ECO_CONF_DEF_HTTP_PORT, req->chanAddr.port, "%u");
+
+    /* Shorter strings fit in the kept buffers. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://10.0.0.2/api/v2?page=2");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ(pathBuf, req->pathBuf);
+    ASSERT_EQ(queryBuf, req->queryBuf);
+    ASSERT_STR_EQ("/api/v2", req->pathBuf);
+    ASSERT_STR_EQ("page=2", req->queryBuf);
+
+    res = EcoHdrTab_Add(req->hdrTab, "Accept", "text/html");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ(kvpAry, req->hdrTab->kvpAry);
+    ASSERT_STR_EQ("accept", req->hdrTab->kvpAry[0].keyBuf);
+    ASSERT_STR_EQ("text/html", req->hdrTab->kvpAry[0].valBuf);
+
+    EcoHttpReq_Del(req);
+
+    PASS();
+}
+
+TEST ApplyParsedUrl(void) {
+    EcoHttpReq *req1;
+    EcoHttpReq *req2;
+    char *pathBuf;
+    char *queryBuf;
+    EcoUrl *url;
+    EcoRes res;
+
+    url = EcoUrl_New();
+    ASSERT_NEQ(NULL, url);
+
+    req1 = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req1);
+
+    req2 = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req2);
+
+    res = EcoUrl_Parse(url, "https://10.0.0.1/api/v1/items?page=1&size=20");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_STR_EQ("10.0.0.1:443", url->chanAddr.hostBuf);
+
+    /* Failed parsing keeps the URL. */
+    res = EcoUrl_Parse(url, "httq://10.0.0.2/");
+    ASSERT_EQ_FMT(EcoRes_BadScheme, res, "%d");
+    ASSERT_STR_EQ("/api/v1/items", url->strBuf + url->pathOff);
+
+    /* Same URL can be applied to many requests. */
+    res = EcoHttpReq_SetOpt(req1, EcoHttpReqOpt_ParsedUrl, url);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    res = EcoHttpReq_SetOpt(req2, EcoHttpReqOpt_ParsedUrl, url);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    ASSERT_EQ_FMT(EcoScheme_Https, req2->scheme, "%d");
+    ASSERT_MEM_EQ(((uint8_t [4]){10, 0, 0, 1}), req2->chanAddr.addr, 4);
+    ASSERT_EQ_FMT(443, req2->chanAddr.port, "%d");
+    ASSERT_STR_EQ("10.0.0.1:443", req2->chanAddr.hostBuf);
+    ASSERT_STR_EQ("/api/v1/items", req2->pathBuf);
+    ASSERT_STR_EQ("page=1&size=20", req2->queryBuf);
+
+    /* Buffers of the request are reused. */
+    pathBuf = req1->pathBuf;
+    queryBuf = req1->queryBuf;
+
+    res = EcoUrl_Parse(url, "http://10.0.0.2:8080/api?id=7");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req1, EcoHttpReqOpt_ParsedUrl, url);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ(pathBuf, req1->pathBuf);
+    ASSERT_EQ(queryBuf, req1->queryBuf);
+    ASSERT_EQ_FMT(EcoScheme_Http, req1->scheme, "%d");
+    ASSERT_STR_EQ("10.0.0.2:8080", req1->chanAddr.hostBuf);
+    ASSERT_STR_EQ("/api", req1->pathBuf);
+    ASSERT_STR_EQ("id=7", req1->queryBuf);
+
+    EcoHttpReq_Del(req1);
+    EcoHttpReq_Del(req2);
+    EcoUrl_Del(url);
+
+    PASS();
+}
+
+TEST SetLongUrl(void) {
+    static const char pathChs[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.!~*'():@&=+$,";
+    char url[2048];
+    EcoHttpReq *req;
+    size_t len;
+    EcoRes res;
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    /* Every character is checked wherever it is in a block. */
+    for (int ch = 1; ch < 256; ch++) {
+        for (size_t off = 0; off < 40; off += 13) {
+            len = (size_t)snprintf(url, sizeof(url), "http://10.0.0.1/");
+            memset(url + len, 'a', 40);
+            url[len + off] = (char)ch;
+            url[len + 40] = '\0';
+
+            res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, url);
+            if (strchr(pathChs, ch) != NULL) {
+                ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+                ASSERT_STR_EQ(url + len - 1, req->pathBuf);
+            } else if (ch != '/' && ch != '?') {
+                ASSERT_EQ_FMT(EcoRes_BadChar, res, "%d");
+            }
+        }
+    }
+
+    len = (size_t)snprintf(url, sizeof(url), "http://10.0.0.1/?");
+    memset(url + len, 'q', 1023);
+    url[len + 1023] = '\0';
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, url);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(1023UL, req->queryLen, "%zu");
+
+    /* Too long query string is rejected. */
+    url[len + 1023] = 'q';
+    url[len + 1024] = '\0';
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, url);
+    ASSERT_EQ_FMT(EcoRes_BadQuery, res, "%d");
+
+    len = (size_t)snprintf(url, sizeof(url), "http://10.0.0.1/");
+    memset(url + len, 'p', 1100);
+    url[len + 1100] = '\0';
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, url);
+    ASSERT_EQ_FMT(EcoRes_BadPath, res, "%d");
+
+    EcoHttpReq_Del(req);
+
+    PASS();
+}
+
+TEST BuildQueryAndForm(void) {
+    EcoHttpReq *req;
+    EcoRes res;
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://10.0.0.1/search?page=1");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    /* Parameters are appended to the query string of the URL. */
+    res = EcoHttpReq_AddQueryParam(req, "q", "a b&c=d");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_AddQueryParam(req, "name", "\xe5\x90\x8d/~x");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_AddQueryParam(req, "empty", "");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    ASSERT_STR_EQ("page=1&q=a+b%26c%3Dd&name=%E5%90%8D%2F~x&empty=", req->queryBuf);
+    ASSERT_EQ_FMT(strlen(req->queryBuf), req->queryLen, "%zu");
+
+    res = EcoHttpReq_AddQueryParam(req, "", "x");
+    ASSERT_EQ_FMT(EcoRes_BadArg, res, "%d");
+
+    /* Query string can be started over. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Query, NULL);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    for (int i = 0; i < 100; i++) {
+        res = EcoHttpReq_AddQueryParam(req, "id", "12345");
+        ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    }
+
+    ASSERT_EQ_FMT(100UL * 9 - 1, req->queryLen, "%zu");
+    ASSERT_EQ_FMT(strlen(req->queryBuf), req->queryLen, "%zu");
+
+    /* Form becomes the request body. */
+    res = EcoHttpReq_AddFormParam(req, "user", "jo@example.com");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_AddFormParam(req, "pass", "p w");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    ASSERT_EQ((uint8_t *)req->formBuf, req->bodyBuf);
+    ASSERT_EQ_FMT(30UL, req->bodyLen, "%zu");
+    ASSERT_MEM_EQ("user=jo%40example.com&pass=p+w", req->bodyBuf, 30);
+
+    /* Replacing the body starts the form over. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_BodyBuf, "raw");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    res = EcoHttpReq_AddFormParam(req, "a", "1");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(3UL, req->bodyLen, "%zu");
+    ASSERT_MEM_EQ("a=1", req->bodyBuf, 3);
+
+    EcoHttpReq_Del(req);
+
+    PASS();
+}
+
+TEST SetHostNameUrl(void) {
+    char longName[ECO_CHAN_NAME_BUF_LEN + 16];
+    EcoHttpReq *req;
+    EcoRes res;
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://Api.Example.COM:8080/v1?x=1");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoChanAddrType_Name, req->chanAddr.type, "%d");
+    ASSERT_STR_EQ("api.example.com", req->chanAddr.name);
+    ASSERT_EQ_FMT(15UL, req->chanAddr.nameLen, "%zu");
+    ASSERT_EQ_FMT(8080, req->chanAddr.port, "%u");
+    ASSERT_STR_EQ("api.example.com:8080", req->chanAddr.hostBuf);
+    ASSERT_STR_EQ("/v1", req->pathBuf);
+
+    /* Name may start with digits. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "https://1password.com");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_STR_EQ("1password.com", req->chanAddr.name);
+    ASSERT_EQ_FMT(443, req->chanAddr.port, "%u");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://127.0.0.1/");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoChanAddrType_Ipv4, req->chanAddr.type, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://a..b/");
+    ASSERT_EQ_FMT(EcoRes_BadHost, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://example.123/");
+    ASSERT_EQ_FMT(EcoRes_BadHost, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://exa mple.com/");
+    ASSERT_EQ_FMT(EcoRes_BadChar, res, "%d");
+
+    memcpy(longName, "http://", 7);
+    memset(longName + 7, 'a', ECO_CHAN_NAME_BUF_LEN);
+    longName[7 + ECO_CHAN_NAME_BUF_LEN] = '\0';
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, longName);
+    ASSERT_EQ_FMT(EcoRes_BadHost, res, "%d");
+
+    /* So does the host option. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Host, "WWW.example.org");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoChanAddrType_Name, req->chanAddr.type, "%d");
+    ASSERT_STR_EQ("www.example.org:80", req->chanAddr.hostBuf);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Host, "www.example.org/");
+    ASSERT_EQ_FMT(EcoRes_BadChar, res, "%d");
+
+    EcoHttpReq_Del(req);
+
+    PASS();
+}
+
+TEST SetIpv6Url(void) {
+    EcoHttpReq *req;
+    EcoRes res;
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://[::1]:8080/v1?x=1");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoChanAddrType_Ipv6, req->chanAddr.type, "%d");
+    ASSERT_EQ_FMT(1, req->chanAddr.addr6[15], "%u");
+    ASSERT_EQ_FMT(8080, req->chanAddr.port, "%u");
+    ASSERT_STR_EQ("[::1]:8080", req->chanAddr.hostBuf);
+    ASSERT_STR_EQ("/v1", req->pathBuf);
+
+    /* Host is rendered in canonical form. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "https://[2001:DB8:0:0::1]");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(0x20, req->chanAddr.addr6[0], "%u");
+    ASSERT_STR_EQ("[2001:db8::1]:443", req->chanAddr.hostBuf);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://[::ffff:10.0.0.1]/");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(10, req->chanAddr.addr6[12], "%u");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://[1::2::3]/");
+    ASSERT_EQ_FMT(EcoRes_BadHost, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://[::1/");
+    ASSERT_EQ_FMT(EcoRes_BadChar, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://[::1");
+    ASSERT_EQ_FMT(EcoRes_BadFmt, res, "%d");
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Url, "http://[::1]x");
+    ASSERT_EQ_FMT(EcoRes_BadChar, res, "%d");
+
+    /* So does the host option, with or without brackets. */
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Host, "fe80::1");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_STR_EQ("[fe80::1]:80", req->chanAddr.hostBuf);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Host, "[::2]");
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_STR_EQ("[::2]:80", req->chanAddr.hostBuf);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_Host, "[::2");
+    ASSERT_EQ_FMT(EcoRes_BadFmt, res, "%d");
+
+    EcoHttpReq_Del(req);
+
+    PASS();
+}
+
 SUITE(BasicRequestSuite) {
     RUN_TEST(SetCommonUrl);
     RUN_TEST(SetInvalidUrl);
+    RUN_TEST(SetUnixSockUrl);
+    RUN_TEST(SetHostNameUrl);
+    RUN_TEST(SetIpv6Url);
+    RUN_TEST(ResetAndReuseRequest);
+    RUN_TEST(ApplyParsedUrl);
+    RUN_TEST(SetLongUrl);
+    RUN_TEST(BuildQueryAndForm);
 }
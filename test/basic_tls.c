@@ -0,0 +1,434 @@
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/un.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "echo.h"
+#include "conf.h"
+
+#include "greatest.h"
+
+#if ECO_CONF_TLS
+
+#include <openssl/x509.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "chan_sock.h"
+#include "chan_tls.h"
+
+static const char gRspMsg[] = "HTTP/1.1 200 OK\r\n"
+                              "Content-Length: 5\r\n"
+                              "Connection: close\r\n"
+                              "\r\n"
+                              "hello";
+
+/* Body is cut short by a close without close_notify. */
+static const char gCutRspMsg[] = "HTTP/1.1 200 OK\r\n"
+                                 "Content-Length: 100\r\n"
+                                 "\r\n"
+                                 "hello";
+
+/**
+ * @brief Create a server context with a self-signed certificate,
+ *        which is also written to the file as the CA of clients.
+ */
+static SSL_CTX *NewSrvCtx(const char *certPath) {
+    EVP_PKEY_CTX *keyCtx;
+    EVP_PKEY *key = NULL;
+    SSL_CTX *srvCtx = NULL;
+    X509_NAME *name;
+    X509 *cert;
+    FILE *file;
+
+    keyCtx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    if (keyCtx == NULL) {
+        return NULL;
+    }
+
+    if (EVP_PKEY_keygen_init(keyCtx) != 1 ||
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyCtx, NID_X9_62_prime256v1) != 1 ||
+        EVP_PKEY_keygen(keyCtx, &key) != 1) {
+        EVP_PKEY_CTX_free(keyCtx);
+
+        return NULL;
+    }
+
+    EVP_PKEY_CTX_free(keyCtx);
+
+    cert = X509_new();
+    if (cert == NULL) {
+        EVP_PKEY_free(key);
+
+        return NULL;
+    }
+
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 60 * 60);
+    X509_set_pubkey(cert, key);
+
+    name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    if (X509_sign(cert, key, EVP_sha256()) == 0) {
+        goto Free;
+    }
+
+    file = fopen(certPath, "w");
+    if (file == NULL) {
+        goto Free;
+    }
+
+    PEM_write_X509(file, cert);
+    fclose(file);
+
+    srvCtx = SSL_CTX_new(TLS_server_method());
+    if (srvCtx == NULL) {
+        goto Free;
+    }
+
+    if (SSL_CTX_use_certificate(srvCtx, cert) != 1 ||
+        SSL_CTX_use_PrivateKey(srvCtx, key) != 1) {
+        SSL_CTX_free(srvCtx);
+        srvCtx = NULL;
+    }
+
+Free:
+    X509_free(cert);
+    EVP_PKEY_free(key);
+
+    return srvCtx;
+}
+
+/**
+ * @brief Listen on a Unix domain socket.
+ *
+ * @return Listening socket, or -1 on failure.
+ */
+static int ListenUnixSock(const char *path) {
+    struct sockaddr_un addr;
+    int lsnFd;
+
+    unlink(path);
+
+    lsnFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lsnFd == -1) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if (bind(lsnFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(lsnFd, 4) != 0) {
+        close(lsnFd);
+
+        return -1;
+    }
+
+    return lsnFd;
+}
+
+/**
+ * @brief Serve one canned response per connection over TLS in a child process.
+ * @note The connection is closed with close_notify unless `cut` is set.
+ */
+static pid_t ServeTls(const char *path, SSL_CTX *srvCtx,
+                      const char *rsp, int connNum, bool cut) {
+    char reqBuf[1024];
+    size_t reqLen;
+    int lsnFd;
+    SSL *ssl;
+    pid_t pid;
+    int fd;
+
+    lsnFd = ListenUnixSock(path);
+    if (lsnFd == -1) {
+        return -1;
+    }
+
+    pid = fork();
+    if (pid != 0) {
+        close(lsnFd);
+
+        return pid;
+    }
+
+    for (int i = 0; i < connNum; i++) {
+        fd = accept(lsnFd, NULL, NULL);
+        if (fd == -1) {
+            _exit(1);
+        }
+
+        ssl = SSL_new(srvCtx);
+        SSL_set_fd(ssl, fd);
+
+        if (SSL_accept(ssl) != 1) {
+            _exit(1);
+        }
+
+        /* Wait for the whole request head. */
+        reqLen = 0;
+        while (reqLen < sizeof(reqBuf) - 1) {
+            int ret = SSL_read(ssl, reqBuf + reqLen, (int)(sizeof(reqBuf) - 1 - reqLen));
+            if (ret <= 0) {
+                break;
+            }
+
+            reqLen += (size_t)ret;
+            reqBuf[reqLen] = '\0';
+
+            if (strstr(reqBuf, "\r\n\r\n") != NULL) {
+                break;
+            }
+        }
+
+        SSL_write(ssl, rsp, (int)strlen(rsp));
+
+        if (cut == false) {
+            SSL_shutdown(ssl);
+        }
+
+        SSL_free(ssl);
+        close(fd);
+    }
+
+    _exit(0);
+}
+
+static EcoHttpCli *NewTlsCli(EcoChanTls *tls, EcoHttpReq *req, const char *path) {
+    EcoHttpCli *cli;
+
+    cli = EcoHttpCli_New();
+    if (cli == NULL) {
+        return NULL;
+    }
+
+    EcoChanTls_Apply(tls, cli);
+    EcoHttpCli_SetOpt(cli, EcoHttpCliOpt_Request, req);
+
+    if (EcoHttpReq_SetOpt(req, EcoHttpReqOpt_SockPath, (EcoArg)path) != EcoRes_Ok) {
+        EcoHttpCli_Del(cli);
+
+        return NULL;
+    }
+
+    return cli;
+}
+
+TEST HandshakeAndResume(void) {
+    EcoChanTlsCtx *ctx;
+    EcoChanTls tls;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    SSL_CTX *srvCtx;
+    char certPath[64];
+    char path[64];
+    EcoRes res;
+    pid_t pid;
+    int stat;
+
+    snprintf(path, sizeof(path), "/tmp/echo-tls-%d.sock", (int)getpid());
+    snprintf(certPath, sizeof(certPath), "/tmp/echo-tls-%d.pem", (int)getpid());
+
+    srvCtx = NewSrvCtx(certPath);
+    ASSERT_NEQ(NULL, srvCtx);
+
+    pid = ServeTls(path, srvCtx, gRspMsg, 2, false);
+    ASSERT_GT(pid, 0);
+
+    ctx = EcoChanTlsCtx_New();
+    ASSERT_NEQ(NULL, ctx);
+
+    /* Peer is verified against the self-signed certificate. */
+    res = EcoChanTlsCtx_SetOpt(ctx, EcoChanTlsCtxOpt_CaFile, certPath);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    EcoChanTls_Init(&tls, ctx);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    cli = NewTlsCli(&tls, req, path);
+    ASSERT_NEQ(NULL, cli);
+
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(EcoStatCode_Ok, cli->rsp->statCode, "%d");
+    ASSERT_EQ_FMT(5UL, cli->rsp->bodyLen, "%zu");
+    ASSERT_MEM_EQ("hello", cli->rsp->bodyBuf, 5);
+    ASSERT_FALSE(tls.resumed);
+    ASSERT_EQ_FMT(1UL, ctx->sessNum, "%zu");
+
+    /* Session of the last connection is resumed. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+    ASSERT_EQ_FMT(5UL, cli->rsp->bodyLen, "%zu");
+    ASSERT(tls.resumed);
+
+    waitpid(pid, &stat, 0);
+    unlink(path);
+    unlink(certPath);
+
+    EcoHttpCli_Del(cli);
+    EcoChanTls_Deinit(&tls);
+    EcoChanTlsCtx_Del(ctx);
+    SSL_CTX_free(srvCtx);
+
+    PASS();
+}
+
+TEST ExpireHandshake(void) {
+    struct timespec begTs, endTs;
+    EcoChanTlsCtx *ctx;
+    EcoChanTls tls;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    char path[64];
+    int64_t costMs;
+    EcoRes res;
+    int lsnFd;
+
+    snprintf(path, sizeof(path), "/tmp/echo-tls-%d.sock", (int)getpid());
+
+    /* Connections are queued, but nobody ever answers the handshake. */
+    lsnFd = ListenUnixSock(path);
+    ASSERT_NEQ(-1, lsnFd);
+
+    ctx = EcoChanTlsCtx_New();
+    ASSERT_NEQ(NULL, ctx);
+
+    EcoChanTls_Init(&tls, ctx);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    cli = NewTlsCli(&tls, req, path);
+    ASSERT_NEQ(NULL, cli);
+
+    res = EcoHttpReq_SetOpt(req, EcoHttpReqOpt_ConnTimeout, (EcoArg)(size_t)50);
+    ASSERT_EQ_FMT(EcoRes_Ok, res, "%d");
+
+    clock_gettime(CLOCK_MONOTONIC, &begTs);
+
+    res = EcoHttpCli_Issue(cli);
+
+    clock_gettime(CLOCK_MONOTONIC, &endTs);
+
+    costMs = (int64_t)(endTs.tv_sec - begTs.tv_sec) * 1000 +
+             (endTs.tv_nsec - begTs.tv_nsec) / 1000000;
+
+    ASSERT_EQ_FMT(EcoRes_Timeout, res, "%d");
+    ASSERT(costMs >= 40);
+    ASSERT(costMs < 2000);
+    ASSERT_EQ_FMT(-1, tls.sock.fd, "%d");
+
+    close(lsnFd);
+    unlink(path);
+
+    EcoHttpCli_Del(cli);
+    EcoChanTls_Deinit(&tls);
+    EcoChanTlsCtx_Del(ctx);
+
+    PASS();
+}
+
+TEST FailCutRead(void) {
+    EcoChanTlsCtx *ctx;
+    EcoChanTls tls;
+    EcoHttpReq *req;
+    EcoHttpCli *cli;
+    SSL_CTX *srvCtx;
+    char certPath[64];
+    char path[64];
+    EcoRes res;
+    pid_t pid;
+    int stat;
+
+    snprintf(path, sizeof(path), "/tmp/echo-tls-%d.sock", (int)getpid());
+    snprintf(certPath, sizeof(certPath), "/tmp/echo-tls-%d.pem", (int)getpid());
+
+    srvCtx = NewSrvCtx(certPath);
+    ASSERT_NEQ(NULL, srvCtx);
+
+    pid = ServeTls(path, srvCtx, gCutRspMsg, 1, true);
+    ASSERT_GT(pid, 0);
+
+    ctx = EcoChanTlsCtx_New();
+    ASSERT_NEQ(NULL, ctx);
+
+    EcoChanTlsCtx_SetOpt(ctx, EcoChanTlsCtxOpt_VerifyPeer, (EcoArg)false);
+
+    EcoChanTls_Init(&tls, ctx);
+
+    req = EcoHttpReq_New();
+    ASSERT_NEQ(NULL, req);
+
+    cli = NewTlsCli(&tls, req, path);
+    ASSERT_NEQ(NULL, cli);
+
+    /* Close without close_notify isn't taken as the end of data. */
+    res = EcoHttpCli_Issue(cli);
+    ASSERT_EQ_FMT(EcoRes_BadChanRead, res, "%d");
+
+    waitpid(pid, &stat, 0);
+    unlink(path);
+    unlink(certPath);
+
+    EcoHttpCli_Del(cli);
+    EcoChanTls_Deinit(&tls);
+    EcoChanTlsCtx_Del(ctx);
+    SSL_CTX_free(srvCtx);
+
+    PASS();
+}
+
+TEST FailUnopenedChan(void) {
+    EcoChanTlsCtx *ctx;
+    EcoChanTls tls;
+    char buf[16];
+
+    ctx = EcoChanTlsCtx_New();
+    ASSERT_NEQ(NULL, ctx);
+
+    EcoChanTls_Init(&tls, ctx);
+
+    ASSERT_EQ_FMT((int)EcoRes_BadChanRead, EcoChanTls_ReadHook(buf, sizeof(buf), &tls), "%d");
+    ASSERT_EQ_FMT((int)EcoRes_BadChanWrite, EcoChanTls_WriteHook(buf, sizeof(buf), &tls), "%d");
+    ASSERT_EQ_FMT(EcoRes_Ok, EcoChanTls_CloseHook(&tls), "%d");
+
+    EcoChanTls_Deinit(&tls);
+    EcoChanTlsCtx_Del(ctx);
+
+    PASS();
+}
+
+SUITE(BasicTlsSuite) {
+    RUN_TEST(HandshakeAndResume);
+    RUN_TEST(ExpireHandshake);
+    RUN_TEST(FailCutRead);
+    RUN_TEST(FailUnopenedChan);
+}
+
+#else
+
+TEST SkipWithoutTls(void) {
+    SKIPm("OpenSSL is absent");
+}
+
+SUITE(BasicTlsSuite) {
+    RUN_TEST(SkipWithoutTls);
+}
+
+#endif
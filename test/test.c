@@ -4,6 +4,12 @@ void BasicHeaderSuite(void);
 
 void BasicRequestSuite(void);
 
+void BasicClientSuite(void);
+
+void BasicDnsSuite(void);
+
+void BasicTlsSuite(void);
+
 GREATEST_MAIN_DEFS();
 
 int main(int argc, char **argv) {
@@ -11,6 +17,9 @@ int main(int argc, char **argv) {
 
     RUN_SUITE(BasicHeaderSuite);
     RUN_SUITE(BasicRequestSuite);
+    RUN_SUITE(BasicClientSuite);
+    RUN_SUITE(BasicDnsSuite);
+    RUN_SUITE(BasicTlsSuite);
 
     GREATEST_MAIN_END();
 }